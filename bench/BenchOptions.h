@@ -0,0 +1,207 @@
+/**
+ * @file BenchOptions.h
+ * @brief Command-line options shared by the benchmark programs.
+ *
+ * Parses --backend, --huge-pages and --numa the same way in bench.c, replay.c and ycsb.c, plus
+ * --allocator in the programs that keep one dictionary at a time, and creates the dictionary they
+ * describe: any backend, with its table placed by a DictMemoryPolicy, or with every block taken
+ * from a bump arena through createDictWithAllocator.
+ */
+
+#ifndef BENCH_OPTIONS_H_
+#define BENCH_OPTIONS_H_
+
+#include "../include/Dict.h"
+
+#define BENCH_MEMORY_USAGE \
+    "[--huge-pages off|transparent|explicit] [--numa default|interleave|bind:NODE] [--allocator malloc|arena:SIZE]"
+
+typedef struct BenchBackend
+{
+    const char *name;
+    DictBackend backend;
+} BenchBackend;
+
+static const BenchBackend benchBackends[] = {
+    {"chaining", DICT_BACKEND_CHAINING},
+    {"robin_hood", DICT_BACKEND_ROBIN_HOOD},
+    {"cuckoo", DICT_BACKEND_CUCKOO},
+    {"bucket_vector", DICT_BACKEND_BUCKET_VECTOR},
+    {"small", DICT_BACKEND_SMALL},
+};
+
+#define BENCH_BACKEND_COUNT (int)(sizeof(benchBackends) / sizeof(benchBackends[0]))
+
+/**
+ * @struct BenchArena
+ * @brief Bump allocator for --allocator arena:SIZE; blocks are never freed one by one.
+ */
+typedef struct BenchArena
+{
+    char *base;
+    size_t used;
+    size_t capacity; /**< 0 for plain malloc */
+} BenchArena;
+
+/**
+ * @struct BenchMemory
+ * @brief Where the dictionaries of a benchmark take their memory from.
+ */
+typedef struct BenchMemory
+{
+    DictMemoryPolicy policy; /**< Table placement, with malloc */
+    BenchArena arena; /**< Used instead of malloc when its capacity is set */
+} BenchMemory;
+
+/**
+ * @brief Parse a comma-separated list of backend names
+ *
+ * @param backends Receives the backends in the order listed, at most BENCH_BACKEND_COUNT
+ * @param count Receives the number of backends
+ * @return bool false if a name is unknown or the list is empty
+ */
+static inline bool benchParseBackends(const BenchBackend **backends, int *count, const char *list)
+{
+    char *copy = strdup(list);
+    char *save = NULL;
+    bool ok = true;
+
+    *count = 0;
+    for (char *tok = strtok_r(copy, ",", &save); tok && ok; tok = strtok_r(NULL, ",", &save))
+    {
+        ok = false;
+        for (int i = 0; i < BENCH_BACKEND_COUNT && *count < BENCH_BACKEND_COUNT; i++)
+        {
+            if (strcmp(tok, benchBackends[i].name) == 0)
+            {
+                backends[(*count)++] = &benchBackends[i];
+                ok = true;
+                break;
+            }
+        }
+    }
+    free(copy);
+    return ok && *count > 0;
+}
+
+/**
+ * @brief Parse a byte count with an optional K, M or G suffix
+ */
+static inline bool benchParseBytes(const char *spec, size_t *bytes)
+{
+    char *end;
+    double n = strtod(spec, &end);
+
+    if (*end == 'K' || *end == 'k')
+        n *= 1024.0, end++;
+    else if (*end == 'M' || *end == 'm')
+        n *= 1024.0 * 1024.0, end++;
+    else if (*end == 'G' || *end == 'g')
+        n *= 1024.0 * 1024.0 * 1024.0, end++;
+    if (*end || n < 1)
+        return false;
+    *bytes = (size_t)n;
+    return true;
+}
+
+/**
+ * @brief Parse one of --huge-pages, --numa and --allocator
+ *
+ * @param option The option, including its dashes
+ * @param spec Its argument
+ * @return bool false if the option is not one of them or its argument is invalid
+ */
+static inline bool benchParseMemory(BenchMemory *memory, const char *option, const char *spec)
+{
+    if (strcmp(option, "--huge-pages") == 0)
+    {
+        if (strcmp(spec, "off") == 0)
+            memory->policy.hugePages = DICT_HUGE_PAGES_OFF;
+        else if (strcmp(spec, "transparent") == 0)
+            memory->policy.hugePages = DICT_HUGE_PAGES_TRANSPARENT;
+        else if (strcmp(spec, "explicit") == 0)
+            memory->policy.hugePages = DICT_HUGE_PAGES_EXPLICIT;
+        else
+            return false;
+        return true;
+    }
+
+    if (strcmp(option, "--allocator") == 0)
+    {
+        if (strcmp(spec, "malloc") == 0)
+            memory->arena.capacity = 0;
+        else if (strncmp(spec, "arena:", 6) != 0 || !benchParseBytes(spec + 6, &memory->arena.capacity))
+            return false;
+        return true;
+    }
+
+    if (strcmp(option, "--numa") != 0)
+        return false;
+    if (strcmp(spec, "default") == 0)
+        memory->policy.numa = DICT_NUMA_DEFAULT;
+    else if (strcmp(spec, "interleave") == 0)
+        memory->policy.numa = DICT_NUMA_INTERLEAVE;
+    else if (sscanf(spec, "bind:%d", &memory->policy.node) == 1 && memory->policy.node >= 0)
+        memory->policy.numa = DICT_NUMA_BIND;
+    else
+        return false;
+    return true;
+}
+
+static inline void *benchArenaAlloc(size_t size, void *ctx)
+{
+    BenchArena *arena = ctx;
+    char *block;
+
+    // each block is preceded by 16 bytes holding its size, which realloc needs to copy it
+    size = ((size + 15) & ~(size_t)15) + 16;
+    if (size > arena->capacity - arena->used)
+        return NULL;
+    block = arena->base + arena->used;
+    arena->used += size;
+    *(size_t *)block = size - 16;
+    return block + 16;
+}
+
+static inline void *benchArenaRealloc(void *block, size_t size, void *ctx)
+{
+    void *grown = benchArenaAlloc(size, ctx);
+    size_t old = block ? *(size_t *)((char *)block - 16) : 0;
+
+    if (block && grown)
+        memcpy(grown, block, old < size ? old : size);
+    return grown;
+}
+
+/**
+ * @brief Create a dictionary with the chosen backend and memory options
+ *
+ * With an arena, the first call allocates it and every call starts it over, so only one dictionary
+ * may live at a time; the memory policy does not apply, the arena being ordinary malloc'd memory.
+ *
+ * @return Dict* The dictionary, or NULL if out of memory
+ */
+static inline Dict *benchCreateDict(DictBackend backend, BenchMemory *memory)
+{
+    BenchArena *arena = &memory->arena;
+
+    if (!arena->capacity)
+        return createDictWithMemory(backend, &memory->policy);
+    if (!arena->base && !(arena->base = malloc(arena->capacity)))
+        return NULL;
+    arena->used = 0;
+    return createDictWithAllocator(backend, benchArenaAlloc, benchArenaRealloc, NULL, arena);
+}
+
+/**
+ * @brief Free a block a dictionary handed back, e.g. from keys_dict, with the allocator it came from
+ */
+static inline void benchFree(const Dict *dict, void *block)
+{
+    if (!dict->allocator_dict.alloc)
+        free(block);
+    else if (dict->allocator_dict.free)
+        dict->allocator_dict.free(block, dict->allocator_dict.ctx);
+}
+
+#endif
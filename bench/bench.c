@@ -0,0 +1,502 @@
+/**
+ * @file bench.c
+ * @brief Dict micro-benchmark suite.
+ *
+ * Runs insert, get-hit, get-miss, update, iterate, copy, merge, clear and remove
+ * workloads over a range of table sizes and prints one machine-readable row per
+ * (size, workload): throughput, ns/op percentiles, peak RSS and, with --perf,
+ * hardware cache/branch/dTLB miss counters from perf_event_open.
+ *
+ * Usage: bench [--sizes 1000,10000,...] [--key-len fixed:N | uniform:MIN:MAX]
+ *              [--value-len N] [--seed N] [--perf] [--format csv|json]
+ *              [--backend chaining,robin_hood,cuckoo,bucket_vector,small]
+ *              [--huge-pages off|transparent|explicit] [--numa default|interleave|bind:NODE]
+ */
+
+#define _GNU_SOURCE /* syscall, perf_event_open */
+
+#include "BenchOptions.h"
+#include <inttypes.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define BENCH_MAX_SIZES 16
+#define BENCH_PERF_EVENTS 3
+
+typedef struct BenchConfig
+{
+    size_t sizes[BENCH_MAX_SIZES];
+    int sizeCount;
+    const BenchBackend *backends[BENCH_BACKEND_COUNT];
+    int backendCount;
+    int keyLenMin;
+    int keyLenMax;
+    int valueLen;
+    uint64_t seed;
+    bool perf;
+    bool json;
+    BenchMemory memory; /**< Table placement for every dictionary the benchmark creates; the arena stays unused */
+} BenchConfig;
+
+/* Keys for one run, packed into a single buffer so generating them does not skew the allocator */
+typedef struct BenchKeys
+{
+    char *buffer;
+    char **keys;
+    size_t count;
+} BenchKeys;
+
+typedef struct BenchPerf
+{
+    int fds[BENCH_PERF_EVENTS];
+    long long values[BENCH_PERF_EVENTS];
+} BenchPerf;
+
+typedef struct BenchResult
+{
+    const char *workload;
+    size_t ops;
+    double seconds;
+    Histogram latency; /* cycleCounter ticks per operation */
+    BenchPerf perf;
+} BenchResult;
+
+static const char *perfEventNames[BENCH_PERF_EVENTS] = {"cache_misses", "branch_misses", "dtlb_misses"};
+
+static uint64_t benchRandom(uint64_t *state)
+{
+    // splitmix64
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static double benchNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long benchPeakRssKb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief Generate count unique keys whose lengths follow the configured distribution
+ *
+ * Each key is random filler followed by its index in base 62, so keys are unique by construction.
+ * A non-zero marker is prepended to miss keys so they never collide with hit keys.
+ */
+static BenchKeys benchMakeKeys(const BenchConfig *config, size_t count, char marker, uint64_t *rng)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    BenchKeys out;
+    size_t capacity = count * ((size_t)config->keyLenMax + 16);
+    size_t used = 0;
+
+    out.buffer = malloc(capacity);
+    out.keys = malloc(sizeof(char *) * count);
+    out.count = count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int span = config->keyLenMax - config->keyLenMin + 1;
+        int length = config->keyLenMin + (int)(benchRandom(rng) % (uint64_t)span);
+        char suffix[16];
+        int suffixLen = 0;
+        char *key = out.buffer + used;
+        int pos = 0;
+
+        for (size_t n = i; suffixLen == 0 || n; n /= 62)
+            suffix[suffixLen++] = charset[n % 62];
+
+        if (marker)
+            key[pos++] = marker;
+        while (pos + suffixLen < length)
+            key[pos++] = charset[benchRandom(rng) % 62];
+        while (suffixLen)
+            key[pos++] = suffix[--suffixLen];
+
+        key[pos++] = '\0';
+        out.keys[i] = key;
+        used += (size_t)pos;
+    }
+    return out;
+}
+
+static void benchFreeKeys(BenchKeys *keys)
+{
+    free(keys->buffer);
+    free(keys->keys);
+}
+
+static void benchShuffle(size_t *order, size_t count, uint64_t *rng)
+{
+    for (size_t i = 0; i < count; i++)
+        order[i] = i;
+    for (size_t i = count; i > 1; i--)
+    {
+        size_t j = benchRandom(rng) % i;
+        size_t tmp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = tmp;
+    }
+}
+
+#ifdef __linux__
+static int benchPerfOpen(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+static void benchPerfStart(const BenchConfig *config, BenchPerf *perf)
+{
+    for (int i = 0; i < BENCH_PERF_EVENTS; i++)
+    {
+        perf->fds[i] = -1;
+        perf->values[i] = -1;
+    }
+#ifdef __linux__
+    if (!config->perf)
+        return;
+
+    perf->fds[0] = benchPerfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    perf->fds[1] = benchPerfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    perf->fds[2] = benchPerfOpen(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    for (int i = 0; i < BENCH_PERF_EVENTS; i++)
+    {
+        if (perf->fds[i] >= 0)
+        {
+            ioctl(perf->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)config;
+#endif
+}
+
+static void benchPerfStop(BenchPerf *perf)
+{
+#ifdef __linux__
+    for (int i = 0; i < BENCH_PERF_EVENTS; i++)
+    {
+        if (perf->fds[i] < 0)
+            continue;
+
+        long long value;
+        ioctl(perf->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(perf->fds[i], &value, sizeof(value)) == (ssize_t)sizeof(value))
+            perf->values[i] = value;
+        close(perf->fds[i]);
+    }
+#else
+    (void)perf;
+#endif
+}
+
+static void benchBegin(const BenchConfig *config, BenchResult *result, const char *workload, size_t ops)
+{
+    result->workload = workload;
+    result->ops = ops;
+    histogramReset(&result->latency);
+    benchPerfStart(config, &result->perf);
+    result->seconds = benchNow();
+}
+
+static void benchEnd(BenchResult *result)
+{
+    result->seconds = benchNow() - result->seconds;
+    benchPerfStop(&result->perf);
+}
+
+/* Bulk workloads have no per-operation timings; spread the total evenly so every row has percentiles */
+static void benchRecordBulk(BenchResult *result)
+{
+    uint64_t ticks = (uint64_t)(result->seconds * cycleCounterFrequency());
+    uint64_t perOp = result->ops ? ticks / result->ops : ticks;
+
+    histogramRecord(&result->latency, perOp);
+}
+
+static void benchPrintHeader(const BenchConfig *config)
+{
+    if (config->json)
+        return;
+
+    printf("backend,size,key_len_min,key_len_max,value_len,workload,ops,seconds,ops_per_sec,"
+           "mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,peak_rss_kb");
+    for (int i = 0; i < BENCH_PERF_EVENTS; i++)
+        printf(",%s", perfEventNames[i]);
+    printf("\n");
+}
+
+static void benchPrint(const BenchConfig *config, const BenchBackend *backend, size_t size, const BenchResult *result)
+{
+    double nsPerTick = 1e9 / cycleCounterFrequency();
+    const Histogram *h = &result->latency;
+    double throughput = result->seconds > 0 ? (double)result->ops / result->seconds : 0.0;
+    double p50 = (double)histogramPercentile(h, 50.0) * nsPerTick;
+    double p90 = (double)histogramPercentile(h, 90.0) * nsPerTick;
+    double p99 = (double)histogramPercentile(h, 99.0) * nsPerTick;
+    double p999 = (double)histogramPercentile(h, 99.9) * nsPerTick;
+    double max = (double)h->max * nsPerTick;
+    double mean = histogramMean(h) * nsPerTick;
+
+    if (config->json)
+    {
+        printf("{\"backend\":\"%s\",\"size\":%zu,\"key_len_min\":%d,\"key_len_max\":%d,\"value_len\":%d,"
+               "\"workload\":\"%s\",\"ops\":%zu,\"seconds\":%.6f,\"ops_per_sec\":%.0f,\"mean_ns\":%.1f,"
+               "\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"p999_ns\":%.1f,\"max_ns\":%.1f,\"peak_rss_kb\":%ld",
+               backend->name, size, config->keyLenMin, config->keyLenMax, config->valueLen, result->workload, result->ops,
+               result->seconds, throughput, mean, p50, p90, p99, p999, max, benchPeakRssKb());
+        for (int i = 0; i < BENCH_PERF_EVENTS; i++)
+            printf(",\"%s\":%lld", perfEventNames[i], result->perf.values[i]);
+        printf("}\n");
+    }
+    else
+    {
+        printf("%s,%zu,%d,%d,%d,%s,%zu,%.6f,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%ld",
+               backend->name, size, config->keyLenMin, config->keyLenMax, config->valueLen, result->workload, result->ops,
+               result->seconds, throughput, mean, p50, p90, p99, p999, max, benchPeakRssKb());
+        for (int i = 0; i < BENCH_PERF_EVENTS; i++)
+            printf(",%lld", result->perf.values[i]);
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+static void benchRunSize(const BenchConfig *config, const BenchBackend *backend, size_t size)
+{
+    uint64_t rng = config->seed ^ (uint64_t)size;
+    BenchKeys keys = benchMakeKeys(config, size, 0, &rng);
+    BenchKeys missKeys = benchMakeKeys(config, size, '#', &rng);
+    size_t *order = malloc(sizeof(size_t) * size);
+    char *value = malloc((size_t)config->valueLen + 1);
+    char *newValue = malloc((size_t)config->valueLen + 1);
+    BenchResult result;
+    Dict *dict = createDictWithMemory(backend->backend, &config->memory.policy);
+
+    memset(value, 'v', (size_t)config->valueLen);
+    memset(newValue, 'u', (size_t)config->valueLen);
+    value[config->valueLen] = '\0';
+    newValue[config->valueLen] = '\0';
+
+    benchBegin(config, &result, "insert", size);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t start = cycleCounter();
+        insert_dict(dict, keys.keys[i], value);
+        histogramRecord(&result.latency, cycleCounter() - start);
+    }
+    benchEnd(&result);
+    benchPrint(config, backend, size, &result);
+
+    benchShuffle(order, size, &rng);
+    benchBegin(config, &result, "get_hit", size);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t start = cycleCounter();
+        char *found = get_dict(dict, keys.keys[order[i]]);
+        histogramRecord(&result.latency, cycleCounter() - start);
+        if (!found)
+            fprintf(stderr, "bench: missing key %s\n", keys.keys[order[i]]);
+    }
+    benchEnd(&result);
+    benchPrint(config, backend, size, &result);
+
+    benchBegin(config, &result, "get_miss", size);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t start = cycleCounter();
+        char *found = get_dict(dict, missKeys.keys[order[i]]);
+        histogramRecord(&result.latency, cycleCounter() - start);
+        if (found)
+            fprintf(stderr, "bench: unexpected key %s\n", missKeys.keys[order[i]]);
+    }
+    benchEnd(&result);
+    benchPrint(config, backend, size, &result);
+
+    benchBegin(config, &result, "update", size);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t start = cycleCounter();
+        update_dict(dict, keys.keys[order[i]], newValue);
+        histogramRecord(&result.latency, cycleCounter() - start);
+    }
+    benchEnd(&result);
+    benchPrint(config, backend, size, &result);
+
+    benchBegin(config, &result, "iterate", size);
+    DictItem *items = items_dict(dict);
+    for (size_t i = 0; items[i].key; i++)
+    {
+        free(items[i].key);
+        free(items[i].value);
+    }
+    free(items);
+    benchEnd(&result);
+    benchRecordBulk(&result);
+    benchPrint(config, backend, size, &result);
+
+    Dict *copy = createDictWithMemory(backend->backend, &config->memory.policy);
+    benchBegin(config, &result, "copy", size);
+    copy_dict(copy, dict);
+    benchEnd(&result);
+    benchRecordBulk(&result);
+    benchPrint(config, backend, size, &result);
+
+    Dict *merged = createDictWithMemory(backend->backend, &config->memory.policy);
+    benchBegin(config, &result, "merge", size);
+    merge_dict(merged, dict);
+    benchEnd(&result);
+    benchRecordBulk(&result);
+    benchPrint(config, backend, size, &result);
+    destroyDict(merged);
+
+    benchBegin(config, &result, "clear", size);
+    clear_dict(copy);
+    benchEnd(&result);
+    benchRecordBulk(&result);
+    benchPrint(config, backend, size, &result);
+    destroyDict(copy);
+
+    benchShuffle(order, size, &rng);
+    benchBegin(config, &result, "remove", size);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t start = cycleCounter();
+        removeKey_dict(dict, keys.keys[order[i]]);
+        histogramRecord(&result.latency, cycleCounter() - start);
+    }
+    benchEnd(&result);
+    benchPrint(config, backend, size, &result);
+
+    destroyDict(dict);
+    free(order);
+    free(value);
+    free(newValue);
+    benchFreeKeys(&keys);
+    benchFreeKeys(&missKeys);
+}
+
+static void benchUsage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [--sizes N,N,...] [--key-len fixed:N | uniform:MIN:MAX] [--value-len N]\n"
+            "          [--seed N] [--perf] [--format csv|json] [--backend NAME,NAME,...]\n"
+            "          [--huge-pages off|transparent|explicit] [--numa default|interleave|bind:NODE]\n"
+            "Sizes accept K/M suffixes, e.g. --sizes 1K,1M,100M (default 1K,10K,100K,1M).\n"
+            "Backends: chaining, robin_hood, cuckoo, bucket_vector, small (default chaining); each size runs on every listed backend.\n",
+            program);
+}
+
+static bool benchParseSizes(BenchConfig *config, const char *list)
+{
+    char *copy = strdup(list);
+    char *save = NULL;
+
+    config->sizeCount = 0;
+    for (char *tok = strtok_r(copy, ",", &save); tok && config->sizeCount < BENCH_MAX_SIZES; tok = strtok_r(NULL, ",", &save))
+    {
+        char *end;
+        double n = strtod(tok, &end);
+
+        if (*end == 'K' || *end == 'k')
+            n *= 1e3;
+        else if (*end == 'M' || *end == 'm')
+            n *= 1e6;
+        if (n < 1)
+        {
+            free(copy);
+            return false;
+        }
+        config->sizes[config->sizeCount++] = (size_t)n;
+    }
+    free(copy);
+    return config->sizeCount > 0;
+}
+
+static bool benchParseKeyLen(BenchConfig *config, const char *spec)
+{
+    if (sscanf(spec, "fixed:%d", &config->keyLenMin) == 1)
+        config->keyLenMax = config->keyLenMin;
+    else if (sscanf(spec, "uniform:%d:%d", &config->keyLenMin, &config->keyLenMax) != 2)
+        return false;
+
+    return config->keyLenMin > 0 && config->keyLenMax >= config->keyLenMin;
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig config = {
+        .sizes = {1000, 10000, 100000, 1000000},
+        .sizeCount = 4,
+        .keyLenMin = 16,
+        .keyLenMax = 16,
+        .valueLen = 16,
+        .seed = 42,
+        .backends = {&benchBackends[0]},
+        .backendCount = 1,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--sizes") == 0 && next && benchParseSizes(&config, next))
+            i++;
+        else if (strcmp(arg, "--key-len") == 0 && next && benchParseKeyLen(&config, next))
+            i++;
+        else if (strcmp(arg, "--value-len") == 0 && next && (config.valueLen = atoi(next)) >= 0)
+            i++;
+        else if (strcmp(arg, "--seed") == 0 && next)
+            config.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(arg, "--perf") == 0)
+            config.perf = true;
+        else if (strcmp(arg, "--backend") == 0 && next && benchParseBackends(config.backends, &config.backendCount, next))
+            i++;
+        else if ((strcmp(arg, "--huge-pages") == 0 || strcmp(arg, "--numa") == 0) && next && benchParseMemory(&config.memory, arg, next))
+            i++;
+        else if (strcmp(arg, "--format") == 0 && next && (strcmp(next, "csv") == 0 || strcmp(next, "json") == 0))
+            config.json = strcmp(argv[++i], "json") == 0;
+        else
+        {
+            benchUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    benchPrintHeader(&config);
+    for (int i = 0; i < config.sizeCount; i++)
+    {
+        for (int b = 0; b < config.backendCount; b++)
+            benchRunSize(&config, config.backends[b], config.sizes[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file replay.c
+ * @brief Re-execute a Dict operation trace and report throughput and latency.
+ *
+ * Traces are recorded with startTrace_dict (build with -DDICT_ENABLE_TRACE). Replay runs the
+ * recorded operations against a fresh dictionary either as fast as possible or at the recorded
+ * pacing (optionally sped up), and prints one machine-readable row per operation kind. The
+ * dictionary can be of any backend, with its table placed by a memory policy or every block in an arena.
+ *
+ * Usage: replay TRACE [--pacing fast|recorded] [--speed F] [--format csv|json]
+ *              [--backend chaining|robin_hood|cuckoo|bucket_vector|small]
+ *              [--huge-pages off|transparent|explicit] [--numa default|interleave|bind:NODE]
+ *              [--allocator malloc|arena:SIZE]
+ */
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime, nanosleep */
+
+#include "../include/Trace.h"
+#include "BenchOptions.h"
+#include <time.h>
+
+static const char *opNames[DICT_OP_COUNT] = {
+    "insert", "get", "remove", "update", "clear", "pop_item", "keys", "values", "items", "merge", "copy"
+};
+
+static double replayNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void replayWaitUntil(double target)
+{
+    double remaining = target - replayNow();
+
+    // sleep for the bulk of the gap, then spin for the last stretch to keep pacing accurate
+    if (remaining > 200e-6)
+    {
+        struct timespec pause = {0, (long)((remaining - 100e-6) * 1e9)};
+        nanosleep(&pause, NULL);
+    }
+    while (replayNow() < target)
+        ;
+}
+
+static void replayFreeStrings(const Dict *dict, char **strings)
+{
+    if (!strings)
+        return; // out of memory
+    for (size_t i = 0; strings[i]; i++)
+        benchFree(dict, strings[i]);
+    benchFree(dict, strings);
+}
+
+static void replayExecute(Dict *dict, const TraceRecord *record, const char *value)
+{
+    switch (record->op)
+    {
+    case DICT_OP_INSERT:
+        insert_dict(dict, record->key, value);
+        break;
+    case DICT_OP_GET:
+        get_dict(dict, record->key);
+        break;
+    case DICT_OP_REMOVE:
+        removeKey_dict(dict, record->key);
+        break;
+    case DICT_OP_UPDATE:
+        update_dict(dict, record->key, value);
+        break;
+    case DICT_OP_CLEAR:
+        clear_dict(dict);
+        break;
+    case DICT_OP_POP_ITEM:
+    {
+        DictItem *item = popItem_dict(dict, record->key);
+        if (item)
+        {
+            benchFree(dict, item->key);
+            benchFree(dict, item->value);
+            benchFree(dict, item);
+        }
+        break;
+    }
+    case DICT_OP_KEYS:
+        replayFreeStrings(dict, keys_dict(dict));
+        break;
+    case DICT_OP_VALUES:
+        replayFreeStrings(dict, values_dict(dict));
+        break;
+    case DICT_OP_ITEMS:
+    {
+        DictItem *items = items_dict(dict);
+        for (size_t i = 0; items && items[i].key; i++)
+        {
+            benchFree(dict, items[i].key);
+            benchFree(dict, items[i].value);
+        }
+        benchFree(dict, items);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    bool recordedPacing = false;
+    bool json = false;
+    double speed = 1.0;
+    const BenchBackend *backends[BENCH_BACKEND_COUNT] = {&benchBackends[0]};
+    int backendCount = 1;
+    BenchMemory memory = {0};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+            recordedPacing = strcmp(argv[++i], "recorded") == 0;
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+            speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+            json = strcmp(argv[++i], "json") == 0;
+        else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc && benchParseBackends(backends, &backendCount, argv[i + 1]) && backendCount == 1)
+            i++;
+        else if (argv[i][0] == '-' && i + 1 < argc && benchParseMemory(&memory, argv[i], argv[i + 1]))
+            i++;
+        else if (!path && argv[i][0] != '-')
+            path = argv[i];
+        else
+        {
+            path = NULL;
+            break;
+        }
+    }
+
+    if (!path || speed <= 0.0)
+    {
+        fprintf(stderr,
+                "usage: %s TRACE [--pacing fast|recorded] [--speed F] [--format csv|json] [--backend NAME]\n"
+                "          " BENCH_MEMORY_USAGE "\n"
+                "Backends: chaining, robin_hood, cuckoo, bucket_vector, small (default chaining).\n",
+                argv[0]);
+        return 1;
+    }
+
+    TraceReader *reader = traceReaderOpen(path);
+    if (!reader)
+    {
+        fprintf(stderr, "replay: cannot read trace %s\n", path);
+        return 1;
+    }
+
+    Histogram latency[DICT_OP_COUNT];
+    Histogram lag; // how far behind the recorded schedule each operation started, in ns
+    double nsPerTick = 1e9 / cycleCounterFrequency();
+    size_t valueCapacity = 0;
+    char *value = NULL;
+    uint64_t total = 0;
+    Dict *dict = benchCreateDict(backends[0]->backend, &memory);
+    TraceRecord record;
+
+    if (!dict)
+    {
+        fprintf(stderr, "replay: cannot create the dictionary\n");
+        traceReaderClose(reader);
+        return 1;
+    }
+
+    for (int op = 0; op < DICT_OP_COUNT; op++)
+        histogramReset(&latency[op]);
+    histogramReset(&lag);
+
+    double begin = replayNow();
+    while (traceReaderNext(reader, &record))
+    {
+        if (record.valueLength + 1 > valueCapacity)
+        {
+            valueCapacity = (record.valueLength + 1) * 2;
+            value = realloc(value, valueCapacity);
+            memset(value, 'v', valueCapacity);
+        }
+        value[record.valueLength] = '\0';
+
+        if (recordedPacing)
+        {
+            double target = begin + (double)record.ticks / reader->ticksPerSecond / speed;
+            double late = replayNow() - target;
+
+            if (late < 0)
+                replayWaitUntil(target);
+            histogramRecord(&lag, late > 0 ? (uint64_t)(late * 1e9) : 0);
+        }
+
+        uint64_t start = cycleCounter();
+        replayExecute(dict, &record, value);
+        histogramRecord(&latency[record.op], cycleCounter() - start);
+
+        value[record.valueLength] = 'v';
+        total++;
+    }
+    double seconds = replayNow() - begin;
+
+    if (!json)
+        printf("op,count,seconds,total_ops_per_sec,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,p99_lag_ns\n");
+
+    for (int op = 0; op < DICT_OP_COUNT; op++)
+    {
+        const Histogram *h = &latency[op];
+
+        if (h->total == 0)
+            continue;
+
+        double throughput = seconds > 0 ? (double)total / seconds : 0.0;
+        double p99Lag = (double)histogramPercentile(&lag, 99.0);
+
+        if (json)
+            printf("{\"op\":\"%s\",\"count\":%llu,\"seconds\":%.6f,\"total_ops_per_sec\":%.0f,\"mean_ns\":%.1f,"
+                   "\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"p999_ns\":%.1f,\"max_ns\":%.1f,\"p99_lag_ns\":%.0f}\n",
+                   opNames[op], (unsigned long long)h->total, seconds, throughput, histogramMean(h) * nsPerTick,
+                   histogramPercentile(h, 50.0) * nsPerTick, histogramPercentile(h, 90.0) * nsPerTick,
+                   histogramPercentile(h, 99.0) * nsPerTick, histogramPercentile(h, 99.9) * nsPerTick,
+                   (double)h->max * nsPerTick, p99Lag);
+        else
+            printf("%s,%llu,%.6f,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.0f\n",
+                   opNames[op], (unsigned long long)h->total, seconds, throughput, histogramMean(h) * nsPerTick,
+                   histogramPercentile(h, 50.0) * nsPerTick, histogramPercentile(h, 90.0) * nsPerTick,
+                   histogramPercentile(h, 99.0) * nsPerTick, histogramPercentile(h, 99.9) * nsPerTick,
+                   (double)h->max * nsPerTick, p99Lag);
+    }
+
+    free(value);
+    destroyDict(dict);
+    free(memory.arena.base);
+    traceReaderClose(reader);
+    return 0;
+}
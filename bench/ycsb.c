@@ -0,0 +1,187 @@
+/**
+ * @file ycsb.c
+ * @brief YCSB-style benchmark driver for Dict.
+ *
+ * Loads recordCount records, runs one of the core workloads A-F (or a custom mix) and
+ * prints one machine-readable row per operation kind with throughput and ns/op percentiles.
+ *
+ * Usage: ycsb [--workload A-F] [--records N] [--operations N]
+ *             [--distribution uniform|zipfian|latest|hotspot] [--theta T]
+ *             [--hotset F] [--hot-ops F] [--scan-length N]
+ *             [--key-len N] [--value-len N] [--seed N] [--format csv|json]
+ *             [--backend chaining|robin_hood|cuckoo|bucket_vector|small]
+ *             [--huge-pages off|transparent|explicit] [--numa default|interleave|bind:NODE]
+ *             [--allocator malloc|arena:SIZE]
+ */
+
+#define _POSIX_C_SOURCE 200809L /* strdup, strtok_r */
+
+#include "../include/Workload.h"
+#include "BenchOptions.h"
+
+static void ycsbUsage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [--workload A-F] [--records N] [--operations N]\n"
+            "          [--distribution uniform|zipfian|latest|hotspot] [--theta T]\n"
+            "          [--hotset F] [--hot-ops F] [--scan-length N]\n"
+            "          [--key-len N] [--value-len N] [--seed N] [--format csv|json] [--backend NAME]\n"
+            "          " BENCH_MEMORY_USAGE "\n"
+            "Backends: chaining, robin_hood, cuckoo, bucket_vector, small (default chaining).\n",
+            program);
+}
+
+static bool ycsbParseDistribution(WorkloadConfig *config, const char *name)
+{
+    static const char *names[] = {"uniform", "zipfian", "latest", "hotspot"};
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            config->distribution = (WorkloadDistribution)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ycsbPrint(bool json, char workloadName, const WorkloadConfig *config, const WorkloadResult *result)
+{
+    double nsPerTick = 1e9 / cycleCounterFrequency();
+    uint64_t total = 0;
+
+    for (int op = 0; op < WORKLOAD_OP_COUNT; op++)
+        total += result->operations[op];
+
+    if (!json)
+        printf("workload,records,operations,op,count,seconds,total_ops_per_sec,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,read_misses\n");
+
+    for (int op = 0; op < WORKLOAD_OP_COUNT; op++)
+    {
+        const Histogram *h = &result->latency[op];
+
+        if (result->operations[op] == 0)
+            continue;
+
+        double throughput = result->seconds > 0 ? (double)total / result->seconds : 0.0;
+        double mean = histogramMean(h) * nsPerTick;
+        double p50 = (double)histogramPercentile(h, 50.0) * nsPerTick;
+        double p90 = (double)histogramPercentile(h, 90.0) * nsPerTick;
+        double p99 = (double)histogramPercentile(h, 99.0) * nsPerTick;
+        double p999 = (double)histogramPercentile(h, 99.9) * nsPerTick;
+        double max = (double)h->max * nsPerTick;
+
+        if (json)
+            printf("{\"workload\":\"%c\",\"records\":%llu,\"operations\":%llu,\"op\":\"%s\",\"count\":%llu,\"seconds\":%.6f,"
+                   "\"total_ops_per_sec\":%.0f,\"mean_ns\":%.1f,\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,"
+                   "\"p999_ns\":%.1f,\"max_ns\":%.1f,\"read_misses\":%llu}\n",
+                   workloadName, (unsigned long long)config->recordCount, (unsigned long long)config->operationCount,
+                   workloadOpName((WorkloadOp)op), (unsigned long long)result->operations[op], result->seconds,
+                   throughput, mean, p50, p90, p99, p999, max, (unsigned long long)result->readMisses);
+        else
+            printf("%c,%llu,%llu,%s,%llu,%.6f,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%llu\n",
+                   workloadName, (unsigned long long)config->recordCount, (unsigned long long)config->operationCount,
+                   workloadOpName((WorkloadOp)op), (unsigned long long)result->operations[op], result->seconds,
+                   throughput, mean, p50, p90, p99, p999, max, (unsigned long long)result->readMisses);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    WorkloadConfig config = {
+        .recordCount = 100000,
+        .operationCount = 1000000,
+        .zipfianTheta = 0.99,
+        .hotsetFraction = 0.2,
+        .hotOperationFraction = 0.8,
+        .maxScanLength = 100,
+        .keyLength = WORKLOAD_MIN_KEY_LENGTH,
+        .valueLength = 100,
+        .seed = 42,
+    };
+    char workloadName = 'A';
+    const char *distribution = NULL;
+    bool json = false;
+    const BenchBackend *backends[BENCH_BACKEND_COUNT] = {&benchBackends[0]};
+    int backendCount = 1;
+    BenchMemory memory = {0};
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!next)
+        {
+            ycsbUsage(argv[0]);
+            return 1;
+        }
+
+        if (strcmp(arg, "--workload") == 0)
+            workloadName = next[0];
+        else if (strcmp(arg, "--records") == 0)
+            config.recordCount = strtoull(next, NULL, 10);
+        else if (strcmp(arg, "--operations") == 0)
+            config.operationCount = strtoull(next, NULL, 10);
+        else if (strcmp(arg, "--distribution") == 0)
+            distribution = next;
+        else if (strcmp(arg, "--theta") == 0)
+            config.zipfianTheta = atof(next);
+        else if (strcmp(arg, "--hotset") == 0)
+            config.hotsetFraction = atof(next);
+        else if (strcmp(arg, "--hot-ops") == 0)
+            config.hotOperationFraction = atof(next);
+        else if (strcmp(arg, "--scan-length") == 0)
+            config.maxScanLength = atoi(next);
+        else if (strcmp(arg, "--key-len") == 0)
+            config.keyLength = atoi(next);
+        else if (strcmp(arg, "--value-len") == 0)
+            config.valueLength = atoi(next);
+        else if (strcmp(arg, "--seed") == 0)
+            config.seed = strtoull(next, NULL, 10);
+        else if (strcmp(arg, "--format") == 0)
+            json = strcmp(next, "json") == 0;
+        else if (strcmp(arg, "--backend") == 0)
+        {
+            if (!benchParseBackends(backends, &backendCount, next) || backendCount != 1)
+            {
+                ycsbUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (!benchParseMemory(&memory, arg, next))
+        {
+            ycsbUsage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (!workloadPreset(&config, workloadName) || (distribution && !ycsbParseDistribution(&config, distribution)) ||
+        config.zipfianTheta <= 0.0 || config.zipfianTheta >= 1.0)
+    {
+        ycsbUsage(argv[0]);
+        return 1;
+    }
+
+    Workload *workload = createWorkload(&config);
+    Dict *dict = benchCreateDict(backends[0]->backend, &memory);
+    WorkloadResult result;
+
+    if (!dict)
+    {
+        fprintf(stderr, "ycsb: cannot create the dictionary\n");
+        destroyWorkload(workload);
+        return 1;
+    }
+
+    workloadLoad(workload, dict);
+    workloadRun(workload, dict, &result);
+    ycsbPrint(json, workloadName, &config, &result);
+
+    destroyDict(dict);
+    free(memory.arena.base);
+    destroyWorkload(workload);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file BloomFilter.h
+ * @brief Cache-line-blocked Bloom filter over 64-bit key hashes.
+ *
+ * Every key maps to one 64-byte block and sets all of its probe bits inside that block, so a
+ * membership test touches a single cache line. Blocking costs a little accuracy compared with a
+ * classic Bloom filter of the same size: about 1% false positives at 10 bits per key.
+ * Bits cannot be cleared; callers rebuild the filter to forget removed keys.
+ */
+
+#ifndef BLOOM_FILTER_H_
+#define BLOOM_FILTER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define BLOOM_BLOCK_BYTES 64
+#define BLOOM_BLOCK_WORDS (BLOOM_BLOCK_BYTES / sizeof(uint64_t))
+#define BLOOM_BLOCK_BITS (BLOOM_BLOCK_BYTES * 8)
+
+/**
+ * @brief Allocate size bytes for a filter, NULL if out of memory
+ */
+typedef void *(*BloomAllocFn)(size_t size, void *ctx);
+
+/**
+ * @brief Release a block from BloomAllocFn
+ */
+typedef void (*BloomFreeFn)(void *block, void *ctx);
+
+/**
+ * @struct BloomFilter
+ * @brief Filter sized for a number of keys, created by createBloomFilter.
+ */
+typedef struct BloomFilter
+{
+    uint64_t *words; /**< blockCount cache-line-aligned blocks of BLOOM_BLOCK_WORDS words */
+    size_t blockCount;
+    unsigned int probes; /**< Bits set per key */
+    size_t capacity; /**< Number of keys the filter was sized for */
+    void *wordsBlock; /**< Block words was carved from, aligned up inside it for a custom allocator */
+    BloomAllocFn alloc; /**< NULL for malloc */
+    BloomFreeFn free; /**< With alloc set, NULL to never free (arena mode) */
+    void *allocCtx; /**< User pointer passed to alloc and free */
+} BloomFilter;
+
+BloomFilter *createBloomFilter(size_t capacity, unsigned int bitsPerKey);
+BloomFilter *createBloomFilterWithAllocator(size_t capacity, unsigned int bitsPerKey, BloomAllocFn allocFn, BloomFreeFn freeFn, void *ctx);
+void destroyBloomFilter(BloomFilter *filter);
+void bloomFilterClear(BloomFilter *filter);
+uint64_t bloomFilterHash(const char *key);
+
+/**
+ * @brief Block holding a hash, chosen from its high 32 bits by multiply-shift
+ */
+static inline uint64_t *bloomFilterBlock(const BloomFilter *filter, uint64_t hash)
+{
+    return filter->words + ((hash >> 32) * filter->blockCount >> 32) * BLOOM_BLOCK_WORDS;
+}
+
+/**
+ * @brief Add a key, given its bloomFilterHash
+ */
+static inline void bloomFilterAdd(BloomFilter *filter, uint64_t hash)
+{
+    uint64_t *block = bloomFilterBlock(filter, hash);
+    uint32_t bit = (uint32_t)hash;
+    uint32_t step = (uint32_t)(hash >> 32) | 1;
+
+    for (unsigned int i = 0; i < filter->probes; i++, bit += step)
+        block[(bit % BLOOM_BLOCK_BITS) / 64] |= 1ull << (bit % 64);
+}
+
+/**
+ * @brief Test a key, given its bloomFilterHash
+ *
+ * @return bool false if the key was certainly never added, true if it probably was
+ */
+static inline bool bloomFilterMayContain(const BloomFilter *filter, uint64_t hash)
+{
+    const uint64_t *block = bloomFilterBlock(filter, hash);
+    uint32_t bit = (uint32_t)hash;
+    uint32_t step = (uint32_t)(hash >> 32) | 1;
+
+    for (unsigned int i = 0; i < filter->probes; i++, bit += step)
+    {
+        if (!(block[(bit % BLOOM_BLOCK_BITS) / 64] & (1ull << (bit % 64))))
+            return false;
+    }
+    return true;
+}
+
+#endif
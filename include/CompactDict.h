@@ -0,0 +1,84 @@
+/**
+ * @file CompactDict.h
+ * @brief Memory-dense string dictionary for very large key counts.
+ *
+ * A CompactDict has no KeyValue nodes. Each key and its value are copied back to back into a
+ * segmented byte pool, and the hash index holds 8-byte slots of {32-bit hash, 32-bit pool
+ * reference}. A reference counts DICT_COMPACT_GRANULE-byte units, so one dictionary can address
+ * a pool of 4G granules (16 GB at the default granule) spread over DICT_COMPACT_SEGMENT_BYTES
+ * segments, without any 8-byte pointer per entry and without a malloc header per string.
+ *
+ * The price is the Dict feature set: there are no duplicate keys (put replaces the value), no TTL,
+ * cache mode, Bloom filter, ordered index, instrumentation or vtable. Strings returned by the dictionary
+ * live in the pool and stay valid only until the next put or remove, which may move the pool.
+ */
+
+#ifndef COMPACT_DICT_H_
+#define COMPACT_DICT_H_
+
+#include "Dict.h"
+#include <stdint.h>
+
+/* Bytes per unit of a pool reference; every record starts on a granule boundary. 8 doubles the
+ * addressable pool to 32 GB at the cost of more padding */
+#ifndef DICT_COMPACT_GRANULE
+#define DICT_COMPACT_GRANULE 4
+#endif
+
+#define DICT_COMPACT_SEGMENT_SHIFT 24
+#define DICT_COMPACT_SEGMENT_BYTES ((size_t)1 << DICT_COMPACT_SEGMENT_SHIFT) /* 16 MB; also the largest key + value */
+
+/**
+ * @struct CompactSlot
+ * @brief One index slot; ref 0 marks an empty slot because the pool never hands out offset 0.
+ */
+typedef struct CompactSlot
+{
+    uint32_t hash; /**< Hash of the key; the home slot is hash * slotCount >> 32 */
+    uint32_t ref; /**< Pool offset of the record, in granules */
+} CompactSlot;
+
+/**
+ * @struct CompactDict
+ * @brief Robin Hood index over a pool of "key\0value\0" records, created by createCompactDict.
+ */
+typedef struct CompactDict
+{
+    CompactSlot *slots;
+    size_t slotCount; /**< Any size, so that an index sized for its keys wastes no slots */
+    size_t count; /**< Number of keys */
+    char **segments; /**< Pool segments, each spanning DICT_COMPACT_SEGMENT_BYTES of pool offsets */
+    size_t segmentCount;
+    size_t segmentCapacity; /**< Length of the segments array */
+    size_t lastBytes; /**< Bytes allocated for the last segment, which grows by doubling */
+    size_t poolBytes; /**< Bytes allocated for all segments */
+    uint64_t tail; /**< Pool offset of the next record */
+    uint64_t garbageBytes; /**< Pool bytes no record uses: replaced and removed records, segment ends */
+    uint64_t payloadBytes; /**< Key and value characters of the live records, terminators not included */
+} CompactDict;
+
+/**
+ * @struct CompactDictStats
+ * @brief Memory use of a CompactDict, filled in by compactDictStats.
+ */
+typedef struct CompactDictStats
+{
+    size_t entryCount; /**< Number of keys */
+    size_t slotCount; /**< Index slots */
+    size_t indexBytes; /**< Bytes of the index */
+    size_t poolBytes; /**< Bytes allocated for pool segments */
+    size_t garbageBytes; /**< Pool bytes waiting to be reclaimed */
+    size_t payloadBytes; /**< Key and value characters stored */
+    double overheadPerEntry; /**< (indexBytes + poolBytes - payloadBytes) / entryCount */
+} CompactDictStats;
+
+CompactDict *createCompactDict(size_t capacity);
+void destroyCompactDict(CompactDict *dict);
+bool compactDictPut(CompactDict *dict, const char *key, const char *value);
+const char *compactDictGet(const CompactDict *dict, const char *key);
+bool compactDictRemove(CompactDict *dict, const char *key);
+size_t compactDictSize(const CompactDict *dict);
+size_t compactDictForEach(const CompactDict *dict, DictVisitor visitor, void *ctx);
+void compactDictStats(const CompactDict *dict, CompactDictStats *out);
+
+#endif
@@ -11,11 +11,20 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include "String.h"
+#include "Histogram.h"
+#include "TimerWheel.h"
+#include "BloomFilter.h"
+#include "RadixTree.h"
+#include "Glob.h"
 
 #define TABLE_SIZE 100000
 
+/* Number of bins in DictStats::chainHistogram; the last bin collects every longer chain */
+#define DICT_STATS_CHAIN_BINS 16
+
 
 /**
  * @struct KeyValue
@@ -28,7 +37,19 @@ typedef struct KeyValue
 {
     char *key; /**< The key of the pair */
     char *value; /**< The value associated with the key */
-    struct KeyValue *next; /**< Pointer to the next key-value pair */
+    struct KeyValue *next; /**< Next pair in the bucket chain; in engines with one slot per key, the next pair with the same key */
+    union
+    {
+        struct
+        {
+            struct KeyValue *lruPrev; /**< More recently used pair, only maintained in DICT_EVICT_LRU cache mode */
+            struct KeyValue *lruNext; /**< Less recently used pair, only maintained in DICT_EVICT_LRU cache mode */
+        };
+        size_t sampleIndex; /**< Position in DictCache::samples, only maintained in the sampled cache modes */
+    };
+    struct WheelTimer *timer; /**< Expiry timer, NULL unless the pair was given a TTL */
+    uint32_t accessTime; /**< DICT_EVICT_SAMPLED_LRU: coarse timestamp of the last access. DICT_EVICT_LFU: last decay time in seconds (high 24 bits) and logarithmic access counter (low 8 bits) */
+    size_t cacheBytes; /**< Allocated bytes charged against the cache byte budget, only maintained in cache mode */
 } KeyValue;
 
 /**
@@ -46,26 +67,290 @@ typedef struct DictItem
 } DictItem;
 
 /**
- * @struct Dict
- * @author Amin Tahmasebi
- * @date 2023-06-26
- * @brief Structure for a dictionary.
+ * @struct DictCounters
+ * @brief Running operation counters.
  *
- * This structure represents a dictionary, containing function pointers for various operations,
- * as well as an array of KeyValue buckets for storing data.
+ * Only maintained when the library is built with DICT_ENABLE_COUNTERS defined; otherwise the
+ * counting code compiles away and stats_dict reports zeros. Every translation unit including
+ * Dict.h must agree on the flag because it changes the layout of Dict.
  */
-typedef struct Dict
+typedef struct DictCounters
+{
+    unsigned long long lookups; /**< Calls that searched for a key (get, exists, pop, popItem) */
+    unsigned long long hits; /**< Lookups that found the key */
+    unsigned long long misses; /**< Lookups that did not find the key */
+    unsigned long long inserts; /**< Key-value pairs added */
+    unsigned long long removes; /**< Key-value pairs removed (clear_dict not included) */
+} DictCounters;
+
+/**
+ * @struct DictStats
+ * @brief Snapshot of the dictionary's structure, filled in by stats_dict.
+ */
+typedef struct DictStats
+{
+    size_t entryCount; /**< Number of key-value pairs */
+    size_t bucketCount; /**< Number of buckets (slots, for open addressing) in the table */
+    size_t usedBuckets; /**< Buckets holding at least one pair */
+    size_t collisions; /**< Pairs a lookup does not find on its first probe */
+    size_t longestChain; /**< Length of the longest bucket chain; for open addressing, the longest probe sequence of a stored key */
+    size_t chainHistogram[DICT_STATS_CHAIN_BINS]; /**< chainHistogram[i] is the number of buckets whose chain has length i; for open addressing, the number of slots at probe distance i, empty slots in bin 0; for cuckoo, 1 or 2 by the bucket the key sits in */
+    double avgProbesHit; /**< Average pairs compared by a successful lookup */
+    double avgProbesMiss; /**< Average pairs compared by a failed lookup */
+    size_t nodeBytes; /**< Bytes used by KeyValue nodes */
+    size_t keyBytes; /**< Bytes used by key strings, including terminators */
+    size_t valueBytes; /**< Bytes used by value strings, including terminators */
+    size_t bucketBytes; /**< Bytes used by the bucket array */
+    size_t timerBytes; /**< Bytes used by expiry timers and the timer wheel */
+    size_t bloomBytes; /**< Bytes used by the Bloom filter, 0 unless setBloomFilter_dict enabled it */
+    size_t indexBytes; /**< Bytes used by the ordered index, 0 unless setOrderedIndex_dict enabled it */
+    size_t totalBytes; /**< Sum of the byte counts above (allocator overhead not included) */
+    double bloomFalsePositiveRate; /**< Share of lookups for absent keys that the Bloom filter let through, measured since the last setBloomFilter_dict */
+    DictCounters counters; /**< Running counters, all zero unless built with DICT_ENABLE_COUNTERS */
+} DictStats;
+
+/**
+ * @enum DictOp
+ * @brief Operations timed by the latency instrumentation.
+ */
+typedef enum DictOp
+{
+    DICT_OP_INSERT,
+    DICT_OP_GET,
+    DICT_OP_REMOVE,
+    DICT_OP_UPDATE,
+    DICT_OP_CLEAR,
+    DICT_OP_POP_ITEM,
+    DICT_OP_KEYS,
+    DICT_OP_VALUES,
+    DICT_OP_ITEMS,
+    DICT_OP_MERGE,
+    DICT_OP_COPY,
+    DICT_OP_COUNT /**< Number of operation kinds, not an operation */
+} DictOp;
+
+/**
+ * @brief Callback invoked when an operation takes longer than the configured threshold
+ *
+ * @param key Key the operation was called with, or NULL for whole-table operations
+ * @param op Kind of operation
+ * @param chainLength Pairs walked by the operation (chain length for point operations, pairs visited for bulk ones)
+ * @param cycles Duration in cycleCounter ticks
+ * @param ctx User pointer given to setSlowOpHook_dict
+ */
+typedef void (*DictSlowOpHook)(const char *key, DictOp op, size_t chainLength, uint64_t cycles, void *ctx);
+
+/**
+ * @struct DictLatency
+ * @brief Per-operation latency histograms and slow-operation hook, allocated by enableLatency_dict.
+ */
+typedef struct DictLatency
+{
+    Histogram histograms[DICT_OP_COUNT]; /**< One histogram of cycleCounter ticks per DictOp */
+    uint64_t slowThreshold; /**< Operations taking more ticks than this trigger slowHook */
+    DictSlowOpHook slowHook; /**< Slow-operation callback, or NULL */
+    void *slowHookCtx; /**< User pointer passed to slowHook */
+} DictLatency;
+
+/**
+ * @enum DictEvictionPolicy
+ * @brief How a dictionary in cache mode chooses which pair to evict when it is full.
+ */
+typedef enum DictEvictionPolicy
+{
+    DICT_EVICT_NONE, /**< Not a cache: never evict */
+    DICT_EVICT_LRU, /**< Exact LRU: every read moves the pair to the front of a recency list */
+    DICT_EVICT_SAMPLED_LRU, /**< Approximate LRU: reads only stamp the pair; eviction takes the oldest of a few sampled pairs */
+    DICT_EVICT_LFU /**< Approximate LFU: reads bump a decaying logarithmic counter; eviction takes the least frequent of a few sampled pairs */
+} DictEvictionPolicy;
+
+/**
+ * @brief Callback invoked with each evicted pair just before it is freed
+ */
+typedef void (*DictEvictCallback)(const char *key, const char *value, void *ctx);
+
+/**
+ * @struct DictCacheConfig
+ * @brief Parameters for setCacheMode_dict.
+ */
+typedef struct DictCacheConfig
 {
-    KeyValue *buckets_dict[TABLE_SIZE]; /**< Array of pointers to key-value pairs, serving as the dictionary's buckets */
+    DictEvictionPolicy policy; /**< Eviction policy, DICT_EVICT_NONE turns cache mode off */
+    size_t maxEntries; /**< Maximum number of pairs, 0 for no entry limit */
+    size_t maxBytes; /**< Maximum bytes allocated for nodes, keys, values and timers, 0 for no byte limit */
+    int sampleSize; /**< Pairs sampled per eviction by DICT_EVICT_SAMPLED_LRU and DICT_EVICT_LFU, 0 for the default of 5 */
+    unsigned int lfuLogFactor; /**< DICT_EVICT_LFU: higher values make the counter grow more slowly, 0 for the default of 10 */
+    unsigned int lfuDecaySeconds; /**< DICT_EVICT_LFU: seconds of idleness per counter decrement, 0 for the default of 60 */
+    DictEvictCallback onEvict; /**< Called for every evicted pair, may be NULL */
+    void *onEvictCtx; /**< User pointer passed to onEvict */
+} DictCacheConfig;
 
-    /* Function pointers for various dictionary operations */
+/**
+ * @struct DictCache
+ * @brief Cache-mode state, allocated by setCacheMode_dict.
+ */
+typedef struct DictCache
+{
+    DictCacheConfig config; /**< Active configuration */
+    size_t usedBytes; /**< Bytes allocated for nodes, keys, values and timers (sum of KeyValue::cacheBytes) */
+    KeyValue *head; /**< Most recently used pair (DICT_EVICT_LRU) */
+    KeyValue *tail; /**< Least recently used pair, the next to evict (DICT_EVICT_LRU) */
+    KeyValue **samples; /**< Every tracked pair in no particular order, for uniform sampling (sampled policies) */
+    size_t sampleCount; /**< Pairs in samples */
+    size_t sampleCapacity; /**< Allocated length of samples */
+    uint64_t rng; /**< State of the sampling generator */
+    unsigned long long evictions; /**< Pairs evicted so far */
+    bool requestedBytes; /**< Count requested sizes rather than malloc_usable_size: the blocks come from a custom allocator */
+} DictCache;
+
+/**
+ * @brief Computes the value of a key missing from the dictionary, for getOrLoad_dict
+ *
+ * @param key Key that missed
+ * @param ctx User pointer given to getOrLoad_dict
+ * @return char* Newly malloc'd value, or NULL if the load failed; for a dictionary from
+ *               createDictWithAllocator, allocate it with that allocator instead. It is returned to the
+ *               caller of getOrLoad_dict, who frees it; the dictionary stores a copy of its own
+ */
+typedef char *(*DictLoader)(const char *key, void *ctx);
+
+/**
+ * @brief Callback receiving one pair during an iteration; it must not modify the dictionary
+ *
+ * @return bool true to continue, false to stop the iteration
+ */
+typedef bool (*DictVisitor)(const char *key, const char *value, void *ctx);
+
+/**
+ * @brief Callback folding one pair into a thread's accumulator, see parallelReduce_dict
+ *
+ * @param acc Accumulator of the calling thread, never shared with another thread
+ * @param key Borrowed key, valid until the reduction returns
+ * @param value Borrowed value, valid until the reduction returns
+ * @param ctx User pointer given to parallelReduce_dict
+ */
+typedef void (*DictFoldFn)(void *acc, const char *key, const char *value, void *ctx);
+
+/**
+ * @brief Callback merging one thread's accumulator into the result, see parallelReduce_dict
+ *
+ * @param into Accumulator receiving the merge
+ * @param from Accumulator of one worker thread
+ * @param ctx User pointer given to parallelReduce_dict
+ */
+typedef void (*DictCombineFn)(void *into, const void *from, void *ctx);
+
+/**
+ * @struct DictBloom
+ * @brief Bloom filter over the keys, allocated by setBloomFilter_dict.
+ */
+typedef struct DictBloom
+{
+    BloomFilter *filter; /**< Holds every key in the dictionary, plus removed keys until the next rebuild */
+    unsigned int bitsPerKey; /**< Sizing used for every rebuild */
+    size_t removed; /**< Pairs removed since the last rebuild, still set in the filter */
+    unsigned long long negatives; /**< Lookups answered by the filter alone */
+    unsigned long long falsePositives; /**< Lookups the filter let through for a key that was absent */
+} DictBloom;
+
+struct Dict;
+struct DictEngine;
+
+/**
+ * @enum DictBackend
+ * @brief Storage layout chosen when the dictionary is created, see createDictWithBackend.
+ */
+typedef enum DictBackend
+{
+    DICT_BACKEND_CHAINING, /**< Fixed table of TABLE_SIZE buckets, each a linked list of pairs (createDict) */
+    DICT_BACKEND_ROBIN_HOOD, /**< Open addressing with Robin Hood displacement and backward-shift deletion, grown past 90% load */
+    DICT_BACKEND_CUCKOO, /**< Bucketized cuckoo hashing: each key in one of two 4-slot, cache-line buckets */
+    DICT_BACKEND_BUCKET_VECTOR, /**< TABLE_SIZE buckets, each a contiguous array of {hash tag, key, pair} instead of a linked list */
+    DICT_BACKEND_SMALL, /**< Up to 16 keys inline in the Dict allocation, found by comparing one-byte tags; switches to DICT_BACKEND_ROBIN_HOOD on the 17th key */
+} DictBackend;
+
+/**
+ * @enum DictHugePages
+ * @brief Page size backing the bucket or slot table, see DictMemoryPolicy.
+ */
+typedef enum DictHugePages
+{
+    DICT_HUGE_PAGES_OFF, /**< Regular pages */
+    DICT_HUGE_PAGES_TRANSPARENT, /**< Huge-page aligned mapping with madvise(MADV_HUGEPAGE) */
+    DICT_HUGE_PAGES_EXPLICIT /**< MAP_HUGETLB from the reserved pool, transparent huge pages when it is empty */
+} DictHugePages;
+
+/**
+ * @enum DictNumaPolicy
+ * @brief NUMA placement of the bucket or slot table, see DictMemoryPolicy.
+ */
+typedef enum DictNumaPolicy
+{
+    DICT_NUMA_DEFAULT, /**< The calling thread's policy, usually the node of whichever thread first touches a page */
+    DICT_NUMA_INTERLEAVE, /**< Pages spread round-robin over every node, evening out latency for threads on all sockets */
+    DICT_NUMA_BIND /**< Pages only on DictMemoryPolicy::node */
+} DictNumaPolicy;
+
+/**
+ * @struct DictMemoryPolicy
+ * @brief Where the engine's table lives, for createDictWithMemory; all zero means plain malloc.
+ *
+ * Only the table the backend indexes pairs with is affected (chaining's bucket array, the slot
+ * arrays of the open-addressing backends). Tables of 1 MB or more are mapped directly with mmap on
+ * Linux, rounded up to whole huge pages when those are asked for; smaller tables, and any table
+ * elsewhere, come from malloc as if there were no policy.
+ */
+typedef struct DictMemoryPolicy
+{
+    DictHugePages hugePages;
+    DictNumaPolicy numa;
+    int node; /**< Node for DICT_NUMA_BIND */
+} DictMemoryPolicy;
+
+/**
+ * @brief Allocate size bytes for a dictionary created by createDictWithAllocator, NULL if out of memory
+ */
+typedef void *(*DictAllocFn)(size_t size, void *ctx);
+
+/**
+ * @brief Resize a block like realloc, including a NULL block
+ */
+typedef void *(*DictReallocFn)(void *block, size_t size, void *ctx);
+
+/**
+ * @brief Release a block
+ */
+typedef void (*DictFreeFn)(void *block, void *ctx);
+
+/**
+ * @struct DictAllocator
+ * @brief Memory functions of a dictionary created by createDictWithAllocator; alloc is NULL for malloc.
+ */
+typedef struct DictAllocator
+{
+    DictAllocFn alloc;
+    DictReallocFn realloc;
+    DictFreeFn free; /**< NULL for arena mode: blocks are never freed one by one */
+    void *ctx; /**< User pointer passed to every call */
+} DictAllocator;
+
+/**
+ * @struct DictVTable
+ * @brief Table of dictionary operations shared by every Dict instance.
+ *
+ * A single static const instance lives in Dict.c; each Dict only stores a pointer to it.
+ * Callers on a hot path should prefer the direct functions declared below, which the
+ * compiler can inline, and keep the vtable for code that needs runtime dispatch.
+ */
+typedef struct DictVTable
+{
     unsigned int (*hash_dict)(const char *key);
-    void (*insert_dict)(struct Dict *self, const char *key, const char *value);
+    bool (*insert_dict)(struct Dict *self, const char *key, const char *value);
     char *(*get_dict)(struct Dict *self, const char *key);
     void (*removeKey_dict)(struct Dict *self, const char *key);
     int (*size_dict)(struct Dict *self);
     int (*exists_dict)(struct Dict *self, const char *key);
-    void (*update_dict)(struct Dict *self, const char *key, const char *value);
+    bool (*update_dict)(struct Dict *self, const char *key, const char *value);
     void (*clear_dict)(struct Dict *self);
     char **(*keys_dict)(struct Dict *self);
     char **(*values_dict)(struct Dict *self);
@@ -78,11 +363,148 @@ typedef struct Dict
     void (*merge_dict)(struct Dict *self, struct Dict *other);
     void (*copy_dict)(struct Dict *self, struct Dict *source);
     void (*fromKeys_dict)(struct Dict *self, const char **keys, const char *value, int numKeys);
+} DictVTable;
+
+/**
+ * @struct Dict
+ * @author Amin Tahmasebi
+ * @date 2023-06-26
+ * @brief Structure for a dictionary.
+ *
+ * This structure represents a dictionary, containing the table of its storage engine (see DictEngine.h)
+ * and a pointer to the shared table of operations.
+ */
+typedef struct Dict
+{
+    KeyValue **buckets_dict; /**< TABLE_SIZE bucket chains of the chaining backend, NULL for the other backends */
+
+    const DictVTable *vtable; /**< Shared operations table, identical for every instance */
+
+    const struct DictEngine *engine_dict; /**< Storage engine of the backend the dictionary was created with */
+
+    void *table_dict; /**< Engine-specific table of the backends other than chaining */
     
     int size_field_dict;
 
+    DictCache *cache_dict; /**< Cache-mode state, NULL unless setCacheMode_dict enabled it */
+
+    TimerWheel *wheel_dict; /**< Expiry timers, NULL until the first pair is given a TTL */
+
+    DictBloom *bloom_dict; /**< Negative-lookup filter, NULL unless setBloomFilter_dict enabled it */
+
+    RadixTree *index_dict; /**< Ordered index mapping each key to its pair, NULL unless setOrderedIndex_dict enabled it */
+
+    struct DictLoading *loading_dict; /**< Read-through loads in flight and failed-load cache, NULL until setLoadOptions_dict or getOrLoad_dict */
+
+#ifdef DICT_ENABLE_COUNTERS
+    DictCounters counters_dict; /**< Running operation counters */
+#endif
+
+#ifdef DICT_ENABLE_LATENCY
+    DictLatency *latency_dict; /**< Latency instrumentation, NULL until enableLatency_dict is called */
+#endif
+
+#ifdef DICT_ENABLE_TRACE
+    struct TraceWriter *trace_dict; /**< Operation trace being recorded, NULL unless startTrace_dict is active */
+#endif
+
+    DictMemoryPolicy memory_dict; /**< Huge-page and NUMA policy of the engine's table, all zero for plain malloc */
+
+    DictAllocator allocator_dict; /**< Source of every block the dictionary owns or returns, all zero for malloc */
+
+    double shrinkFloor_dict; /**< Load factor under which removals shrink a resizable table, 0 to never shrink */
+
+#ifdef DICT_ENABLE_THREADS
+    bool lazyFree_dict; /**< Clears and large values are freed by the reclaim thread, see setLazyFree_dict */
+#endif
+
+    max_align_t inline_dict[]; /**< Engine table allocated with the dictionary, see DictEngine::inlineBytes */
 } Dict;
 
 Dict* createDict();
+Dict *createDictWithBackend(DictBackend backend);
+Dict *createDictWithMemory(DictBackend backend, const DictMemoryPolicy *policy);
+Dict *createDictWithAllocator(DictBackend backend, DictAllocFn allocFn, DictReallocFn reallocFn, DictFreeFn freeFn, void *ctx);
+void destroyDict(Dict *self);
+
+/* Direct-call API, equivalent to going through self->vtable but resolvable at compile time */
+unsigned int hash_dict(const char *key);
+bool insert_dict(Dict *self, const char *key, const char *value);
+char *get_dict(Dict *self, const char *key);
+void removeKey_dict(Dict *self, const char *key);
+int exists_dict(Dict *self, const char *key);
+bool update_dict(Dict *self, const char *key, const char *value);
+void clear_dict(Dict *self);
+char **keys_dict(Dict *self);
+char **values_dict(Dict *self);
+DictItem *items_dict(Dict *self);
+double loadFactor_dict(Dict *self);
+char *pop_dict(Dict *self, const char *key, const char *defaultVal);
+void print_dict(Dict *self);
+DictItem *popItem_dict(Dict *self, const char *key);
+void merge_dict(Dict *self, Dict *other);
+void copy_dict(Dict *self, Dict *source);
+void fromKeys_dict(Dict *self, const char **keys, const char *value, int numKeys);
+void stats_dict(Dict *self, DictStats *out);
+bool setCacheMode_dict(Dict *self, const DictCacheConfig *config);
+bool insertTTL_dict(Dict *self, const char *key, const char *value, uint64_t ttlMs);
+bool expire_dict(Dict *self, const char *key, uint64_t ttlMs);
+bool persist_dict(Dict *self, const char *key);
+long long ttl_dict(Dict *self, const char *key);
+size_t expireTick_dict(Dict *self, size_t budget);
+bool setLoadOptions_dict(Dict *self, uint64_t negativeTtlMs);
+char *getOrLoad_dict(Dict *self, const char *key, DictLoader loader, void *ctx);
+bool setBloomFilter_dict(Dict *self, unsigned int bitsPerKey);
+bool setOrderedIndex_dict(Dict *self, bool enable);
+void setShrinkFloor_dict(Dict *self, double floor);
+bool compact_dict(Dict *self);
+size_t range_dict(Dict *self, const char *lo, const char *hi, DictVisitor visitor, void *ctx);
+size_t prefix_dict(Dict *self, const char *prefix, DictVisitor visitor, void *ctx);
+size_t scanMatch_dict(Dict *self, const char *pattern, DictVisitor visitor, void *ctx);
+size_t scan_dict(Dict *self, size_t cursor, size_t count, DictVisitor visitor, void *ctx);
+size_t sortedItems_dict(Dict *self, DictVisitor visitor, void *ctx);
+
+#ifdef DICT_ENABLE_LATENCY
+void enableLatency_dict(Dict *self, bool enable);
+void resetLatency_dict(Dict *self);
+const Histogram *latency_dict(Dict *self, DictOp op);
+void setSlowOpHook_dict(Dict *self, uint64_t thresholdCycles, DictSlowOpHook hook, void *ctx);
+#endif
+
+#ifdef DICT_ENABLE_TRACE
+bool startTrace_dict(Dict *self, const char *path);
+bool stopTrace_dict(Dict *self);
+#endif
+
+#ifdef DICT_ENABLE_THREADS
+size_t scanMatchParallel_dict(Dict *self, const char *pattern, DictVisitor visitor, void *ctx, int threads);
+size_t parallelForEach_dict(Dict *self, int threads, DictVisitor visitor, void *ctx);
+size_t parallelReduce_dict(Dict *self, int threads, void *acc, size_t accBytes, DictFoldFn fold, DictCombineFn combine, void *ctx);
+size_t sortedItemsParallel_dict(Dict *self, DictVisitor visitor, void *ctx, int threads);
+void setLazyFree_dict(Dict *self, bool enable);
+void waitLazyFree_dict(void);
+#endif
+
+/**
+ * @brief Retrieve the number of key-value pairs in the dictionary
+ * 
+ * @param self Pointer to the dictionary for which to retrieve the size
+ * @return int Number of key-value pairs in the dictionary
+ */
+static inline int size_dict(Dict *self)
+{
+    return self->size_field_dict;
+}
+
+/**
+ * @brief Check if the dictionary is empty
+ * 
+ * @param self Pointer to the dictionary to check
+ * @return bool Boolean indicating whether the dictionary is empty (true) or not (false)
+ */
+static inline bool isEmpty_dict(Dict *self)
+{
+    return self->size_field_dict == 0;
+}
 
 #endif
\ No newline at end of file
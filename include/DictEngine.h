@@ -0,0 +1,187 @@
+/**
+ * @file DictEngine.h
+ * @brief Storage engines behind Dict: how the KeyValue nodes are laid out and found.
+ *
+ * Dict.c keeps everything that works on whole pairs (TTL, cache mode, Bloom filter, ordered index,
+ * instrumentation) and delegates placing and finding the nodes to the engine chosen when the
+ * dictionary is created. Engines link and unlink pairs but never allocate or free them.
+ *
+ * A key inserted twice is stored twice and lookups return the earlier pair. Engines with one slot
+ * per key keep the later pairs behind the first through KeyValue::next, in insertion order.
+ *
+ * Engines allocate through the mem*_dict helpers and their tables through engineAlloc_dict, so that
+ * the dictionary's allocator and memory policy apply to them too.
+ */
+
+#ifndef DICT_ENGINE_H_
+#define DICT_ENGINE_H_
+
+#include "Dict.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct DictCursor
+ * @brief Position of an iteration over an engine's slots; start it zeroed with end set.
+ */
+typedef struct DictCursor
+{
+    size_t slot; /**< Next slot to look at */
+    size_t end; /**< Slot to stop before; SIZE_MAX for the whole table */
+    KeyValue *pair; /**< Pair returned last, whose duplicates or chain come next */
+    size_t offset; /**< Pairs of the current slot returned so far, for engines that keep a slot's pairs in an array */
+} DictCursor;
+
+/**
+ * @brief Receives the pairs of one step of a scan; it must not modify the dictionary
+ */
+typedef void (*DictEmit)(KeyValue *pair, void *ctx);
+
+/**
+ * @struct DictEngine
+ * @brief Operations of one storage engine; a single static const instance per engine.
+ *
+ * probes arguments receive the number of entries examined beyond the first, the chain length the
+ * latency instrumentation reports.
+ */
+typedef struct DictEngine
+{
+    const char *name; /**< Name used by the benchmarks, e.g. "robin_hood" */
+    size_t inlineBytes; /**< Table bytes allocated together with the Dict at Dict::inline_dict, 0 if create allocates its own */
+    bool (*create)(Dict *self); /**< Allocate an empty table; false if out of memory */
+    void (*destroy)(Dict *self); /**< Free the table; the pairs must already be gone */
+    KeyValue *(*find)(Dict *self, const char *key, size_t *probes);
+    bool (*link)(Dict *self, KeyValue *pair, size_t *probes); /**< Add a new pair, behind any pair with the same key; false if out of memory, in which case the pair is not linked */
+    KeyValue *(*remove)(Dict *self, const char *key, size_t *probes); /**< Unlink and return the pair find would return */
+    void (*unlink)(Dict *self, KeyValue *pair); /**< Unlink a pair known to be linked */
+    size_t (*slotCount)(const Dict *self); /**< Slots a DictCursor ranges over */
+    KeyValue *(*next)(const Dict *self, DictCursor *cursor); /**< Next pair of the iteration, NULL once past end */
+    void (*clear)(Dict *self, void (*release)(Dict *dict, KeyValue *pair)); /**< Pass every pair to release and empty the table */
+    /** Move the keys into a fresh table sized for half the maximum load if that is smaller than the
+     *  current one, or whatever its size when always is set; false if the table was left as it was.
+     *  NULL for engines whose table never grows. */
+    bool (*shrink)(Dict *self, bool always);
+    /** Pass the pairs of one step of a scan to emit and return the cursor of the next step, 0 once
+     *  the table is covered. Every key present throughout a scan must be passed at least once, even
+     *  if the table is resized between two steps; cuckoo only manages that while the table is not
+     *  modified, see scan_cuckoo. */
+    size_t (*scan)(const Dict *self, size_t cursor, DictEmit emit, void *ctx);
+    void (*stats)(const Dict *self, DictStats *out); /**< Fill the bucket, chain and probe fields of out */
+} DictEngine;
+
+extern const DictEngine robinHoodEngine_dict;
+extern const DictEngine cuckooEngine_dict;
+extern const DictEngine bucketVectorEngine_dict;
+extern const DictEngine smallEngine_dict;
+
+static inline size_t reverseBits_dict(size_t value)
+{
+    size_t swap = ~(size_t)0;
+
+    // swap ever smaller halves: 32-bit halves, then 16-bit quarters, down to single bits
+    for (size_t s = 4 * sizeof(value); s; s >>= 1)
+    {
+        swap ^= swap << s;
+        value = ((value >> s) & swap) | ((value << s) & ~swap);
+    }
+    return value;
+}
+
+/**
+ * @brief Cursor after cursor in a scan of a power-of-two table with mask + 1 slots
+ *
+ * The cursor is incremented in its high bits first (reverse binary), so the slots already visited
+ * form the same set of hash suffixes whatever the table size: when the table doubles, slot i splits
+ * into i and i + size, both visited or both not; when it halves, i and i + size merge into a slot
+ * that is visited again at most. Keys placed by hash & mask are therefore never skipped.
+ */
+static inline size_t scanNext_dict(size_t cursor, size_t mask)
+{
+    return reverseBits_dict(reverseBits_dict(cursor | ~mask) + 1);
+}
+
+void *engineAlloc_dict(const Dict *self, size_t bytes, size_t alignment);
+void engineFree_dict(const Dict *self, void *table, size_t bytes);
+
+/**
+ * @brief Allocate a block the dictionary owns, from its allocator
+ */
+static inline void *memAlloc_dict(const Dict *self, size_t size)
+{
+    return self->allocator_dict.alloc ? self->allocator_dict.alloc(size, self->allocator_dict.ctx) : malloc(size);
+}
+
+static inline void *memCalloc_dict(const Dict *self, size_t size)
+{
+    if (!self->allocator_dict.alloc)
+        return calloc(1, size);
+
+    void *block = self->allocator_dict.alloc(size, self->allocator_dict.ctx);
+
+    if (block)
+        memset(block, 0, size);
+    return block;
+}
+
+static inline void *memRealloc_dict(const Dict *self, void *block, size_t size)
+{
+    return self->allocator_dict.alloc ? self->allocator_dict.realloc(block, size, self->allocator_dict.ctx) : realloc(block, size);
+}
+
+/**
+ * @brief Release a block from memAlloc_dict; nothing happens in arena mode
+ */
+static inline void memFree_dict(const Dict *self, void *block)
+{
+    if (!self->allocator_dict.alloc)
+        free(block);
+    else if (self->allocator_dict.free && block)
+        self->allocator_dict.free(block, self->allocator_dict.ctx);
+}
+
+static inline char *memStrdup_dict(const Dict *self, const char *text)
+{
+    size_t bytes = strlen(text) + 1;
+    char *copy = memAlloc_dict(self, bytes);
+
+    if (copy)
+        memcpy(copy, text, bytes);
+    return copy;
+}
+
+/**
+ * @brief engineHash_dict with the seed mixed into the starting state
+ *
+ * Keys whose hashes collide under one seed, even on all 64 bits, are scattered again under another,
+ * which a seed applied to the finished hash cannot do.
+ */
+static inline uint64_t engineSeededHash_dict(const char *key, uint64_t seed)
+{
+    uint64_t hash = 0xcbf29ce484222325ull ^ seed;
+
+    while (*key)
+    {
+        hash ^= (unsigned char)*key++;
+        hash *= 0x100000001b3ull;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * @brief 64-bit hash of a key for the engines that need more than hash_dict's bucket index
+ *
+ * FNV-1a followed by a murmur3 finaliser, so every bit of the result depends on every key byte.
+ */
+static inline uint64_t engineHash_dict(const char *key)
+{
+    return engineSeededHash_dict(key, 0);
+}
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file Glob.h
+ * @brief Glob patterns compiled once and matched against many strings without allocating.
+ *
+ * Supported syntax: `*` matches any run of characters, `?` any single character, `[abc]`, `[a-z]`
+ * and `[^abc]` (or `[!abc]`) a character class, and `\` escapes the next character. A pattern is
+ * split at its stars into segments; literal segments are located with strstr and the others are
+ * tried at each position. Matching each segment at its leftmost position is exact for this syntax,
+ * so a match costs one pass over the string per segment at most.
+ */
+
+#ifndef GLOB_H_
+#define GLOB_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @struct GlobSegment
+ * @brief Part of a pattern between two stars.
+ */
+typedef struct GlobSegment
+{
+    const char *text; /**< Unescaped literal text if literal, otherwise the pattern syntax; NUL-terminated */
+    size_t width; /**< Number of characters the segment matches */
+    bool literal; /**< No `?` or character class, so strstr can find it */
+} GlobSegment;
+
+/**
+ * @struct GlobMatcher
+ * @brief Compiled pattern, filled in by globCompile and released by globFree.
+ */
+typedef struct GlobMatcher
+{
+    char *storage; /**< Segment texts and literal prefix, one allocation */
+    GlobSegment *segments;
+    size_t segmentCount;
+    bool hasStar; /**< false if the whole pattern is a single anchored segment */
+    bool anchoredStart; /**< Pattern does not start with a star */
+    bool anchoredEnd; /**< Pattern does not end with a star */
+    const char *literalPrefix; /**< Characters every match starts with, unescaped; may be empty */
+    size_t prefixLength;
+} GlobMatcher;
+
+bool globCompile(GlobMatcher *matcher, const char *pattern);
+void globFree(GlobMatcher *matcher);
+bool globMatch(const GlobMatcher *matcher, const char *text);
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file Histogram.h
+ * @brief Log-linear (HDR-style) latency histogram and a cheap cycle counter.
+ *
+ * Values are bucketed by their power of two and then split linearly into
+ * 2^HISTOGRAM_SUB_BUCKET_BITS sub-buckets, so every recorded value is kept
+ * within ~6% of its true magnitude over the whole 64-bit range.
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1u << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKET_COUNT (HISTOGRAM_SUB_BUCKETS * (64 - HISTOGRAM_SUB_BUCKET_BITS + 1))
+
+/**
+ * @struct Histogram
+ * @brief Fixed-size log-linear histogram of unsigned 64-bit values.
+ */
+typedef struct Histogram
+{
+    uint64_t counts[HISTOGRAM_BUCKET_COUNT]; /**< Number of samples per bucket */
+    uint64_t total; /**< Number of samples recorded */
+    uint64_t sum; /**< Sum of all samples, for the mean */
+    uint64_t min; /**< Smallest sample, UINT64_MAX when empty */
+    uint64_t max; /**< Largest sample */
+} Histogram;
+
+void histogramReset(Histogram *hist);
+void histogramMerge(Histogram *dest, const Histogram *src);
+uint64_t histogramPercentile(const Histogram *hist, double percentile);
+double histogramMean(const Histogram *hist);
+double cycleCounterFrequency(void);
+
+/**
+ * @brief Map a value to its bucket index
+ */
+static inline unsigned int histogramBucketIndex(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return (unsigned int)value;
+
+    unsigned int magnitude = 63 - (unsigned int)__builtin_clzll(value);
+    unsigned int shift = magnitude - HISTOGRAM_SUB_BUCKET_BITS;
+    unsigned int sub = (unsigned int)(value >> shift) - HISTOGRAM_SUB_BUCKETS;
+
+    return HISTOGRAM_SUB_BUCKETS * (shift + 1) + sub;
+}
+
+/**
+ * @brief Record one sample. Kept inline because it sits on instrumented hot paths.
+ */
+static inline void histogramRecord(Histogram *hist, uint64_t value)
+{
+    hist->counts[histogramBucketIndex(value)]++;
+    hist->total++;
+    hist->sum += value;
+
+    if (value < hist->min)
+        hist->min = value;
+    if (value > hist->max)
+        hist->max = value;
+}
+
+/**
+ * @brief Read a monotonically increasing tick counter as cheaply as the platform allows
+ *
+ * Uses the time-stamp counter on x86, the virtual counter on AArch64 and a monotonic
+ * clock elsewhere. Use cycleCounterFrequency to convert ticks to seconds.
+ */
+static inline uint64_t cycleCounter(void)
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#endif
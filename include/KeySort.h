@@ -0,0 +1,42 @@
+/**
+ * @file KeySort.h
+ * @brief Stable MSD radix sort of string keys into strcmp order, without copying the strings.
+ *
+ * Items are distributed by one key byte at a time. The next 8 bytes of every key are kept next to
+ * its item and moved with it, so that most passes, and most comparisons of the insertion sort
+ * that finishes runs of 32 keys or fewer, read the items and those bytes in order instead of
+ * following every key pointer: the keys are only read again once a run is 8 bytes past them.
+ * Built with DICT_ENABLE_THREADS, large inputs are first split into independent runs of keys
+ * that several threads then sort at once.
+ */
+
+#ifndef KEY_SORT_H_
+#define KEY_SORT_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @struct KeySortItem
+ * @brief A key to sort and the payload that travels with it; neither is copied or dereferenced beyond the key's bytes.
+ */
+typedef struct KeySortItem
+{
+    const char *key;
+    void *value;
+} KeySortItem;
+
+/**
+ * @brief Allocate size bytes of scratch space, NULL if out of memory
+ */
+typedef void *(*KeySortAllocFn)(size_t size, void *ctx);
+
+/**
+ * @brief Release a block from KeySortAllocFn
+ */
+typedef void (*KeySortFreeFn)(void *block, void *ctx);
+
+bool keySort(KeySortItem *items, size_t count, int threads);
+bool keySortWithAllocator(KeySortItem *items, size_t count, int threads, KeySortAllocFn allocFn, KeySortFreeFn freeFn, void *ctx);
+
+#endif
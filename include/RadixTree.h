@@ -0,0 +1,63 @@
+/**
+ * @file RadixTree.h
+ * @brief Adaptive radix tree over NUL-terminated string keys, iterated in strcmp order.
+ *
+ * Inner nodes grow and shrink between 4, 16, 48 and 256 children, and single-child paths are
+ * compressed into the node below, so memory stays proportional to the number of keys and a lookup
+ * costs O(key length) whatever the tree size. Keys are not copied: a leaf keeps the caller's key
+ * pointer, which must stay valid until the key is removed.
+ */
+
+#ifndef RADIX_TREE_H_
+#define RADIX_TREE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Callback receiving one key during an ordered iteration
+ *
+ * @return bool true to continue, false to stop the iteration
+ */
+typedef bool (*RadixVisitor)(const char *key, void *value, void *ctx);
+
+/**
+ * @brief Allocate size bytes for a tree's nodes and leaves, NULL if out of memory
+ */
+typedef void *(*RadixAllocFn)(size_t size, void *ctx);
+
+/**
+ * @brief Release a block from RadixAllocFn
+ */
+typedef void (*RadixFreeFn)(void *block, void *ctx);
+
+/**
+ * @struct RadixTree
+ * @brief Tree root and bookkeeping; zero-initialised by radixTreeInit.
+ */
+typedef struct RadixTree
+{
+    void *root; /**< Inner node, tagged leaf or NULL */
+    size_t size; /**< Number of keys */
+    size_t bytes; /**< Bytes allocated for nodes and leaves */
+    RadixAllocFn alloc; /**< Source of nodes and leaves, NULL for malloc */
+    RadixFreeFn free; /**< With alloc set, NULL to never free a block one by one (arena mode) */
+    void *allocCtx; /**< User pointer passed to alloc and free */
+} RadixTree;
+
+/* Returned by radixTreeInsert when a node or leaf could not be allocated; the tree is unchanged */
+extern const char radixTreeNoMemory;
+#define RADIX_TREE_NO_MEMORY ((void *)&radixTreeNoMemory)
+
+void radixTreeInit(RadixTree *tree);
+void radixTreeInitWithAllocator(RadixTree *tree, RadixAllocFn allocFn, RadixFreeFn freeFn, void *ctx);
+void radixTreeFree(RadixTree *tree);
+void *radixTreeInsert(RadixTree *tree, const char *key, void *value);
+void *radixTreeReplace(RadixTree *tree, const char *key, void *value);
+void *radixTreeSearch(const RadixTree *tree, const char *key);
+void *radixTreeRemove(RadixTree *tree, const char *key);
+size_t radixTreeRange(const RadixTree *tree, const char *lo, const char *hi, RadixVisitor visitor, void *ctx);
+size_t radixTreePrefix(const RadixTree *tree, const char *prefix, RadixVisitor visitor, void *ctx);
+
+#endif
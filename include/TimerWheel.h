@@ -0,0 +1,56 @@
+/**
+ * @file TimerWheel.h
+ * @brief Hierarchical timing wheel with millisecond resolution.
+ *
+ * Four levels of 256 slots cover 2^8, 2^16, 2^24 and 2^32 milliseconds ahead of the current
+ * tick; timers further out are parked in the last slot of the top level and re-placed when it
+ * cascades. Scheduling and cancelling are O(1). Advancing the wheel skips empty levels, so its
+ * cost is proportional to the timers that fire and cascade, not to the elapsed time.
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 8
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_DUE TIMER_WHEEL_LEVELS /* WheelTimer::level of timers waiting in the due list */
+
+/**
+ * @struct WheelTimer
+ * @brief One scheduled timer; owned and allocated by the caller.
+ */
+typedef struct WheelTimer
+{
+    void *data; /**< Caller's payload */
+    uint64_t expireAt; /**< Absolute expiry time in milliseconds */
+    struct WheelTimer *prev; /**< Previous timer in the same slot */
+    struct WheelTimer *next; /**< Next timer in the same slot */
+    uint8_t level; /**< Wheel level, or TIMER_WHEEL_DUE once fired */
+    uint8_t slot; /**< Slot within the level */
+} WheelTimer;
+
+/**
+ * @struct TimerWheel
+ * @brief The wheel and the list of timers that have fired but were not yet consumed.
+ */
+typedef struct TimerWheel
+{
+    uint64_t current; /**< Next tick to process, in milliseconds */
+    WheelTimer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    size_t levelCount[TIMER_WHEEL_LEVELS]; /**< Timers per level, used to skip empty levels */
+    WheelTimer *due; /**< Fired timers, consumed by timerWheelPopDue */
+    size_t dueCount;
+} TimerWheel;
+
+void timerWheelInit(TimerWheel *wheel, uint64_t nowMs);
+void timerWheelSchedule(TimerWheel *wheel, WheelTimer *timer, uint64_t expireAt);
+void timerWheelCancel(TimerWheel *wheel, WheelTimer *timer);
+void timerWheelAdvance(TimerWheel *wheel, uint64_t nowMs, size_t maxDue);
+WheelTimer *timerWheelPopDue(TimerWheel *wheel);
+uint64_t timerWheelNowMs(void);
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file Trace.h
+ * @brief Compact binary trace of Dict operations, for capture in production and replay in benchmarks.
+ *
+ * A trace starts with an 8-byte magic and the tick frequency of the recording machine, followed by
+ * one record per operation: the DictOp byte, the varint tick delta since the previous record, the
+ * varint key length and key bytes, and the varint value length. Values themselves are not stored.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "Dict.h"
+
+#define TRACE_MAGIC "DICTTRC1"
+#define TRACE_BUFFER_SIZE (64 * 1024)
+
+/**
+ * @struct TraceRecord
+ * @brief One decoded trace record; key points into the reader's buffer and is NUL-terminated.
+ */
+typedef struct TraceRecord
+{
+    DictOp op; /**< Operation kind */
+    uint64_t ticks; /**< Ticks since the trace was opened */
+    const char *key; /**< Key, empty for whole-table operations */
+    size_t keyLength; /**< Length of key in bytes */
+    size_t valueLength; /**< Length of the value passed to insert/update, 0 otherwise */
+} TraceRecord;
+
+/**
+ * @struct TraceWriter
+ * @brief Buffered trace output, created by traceWriterOpen.
+ */
+typedef struct TraceWriter
+{
+    FILE *file;
+    unsigned char buffer[TRACE_BUFFER_SIZE];
+    size_t used; /**< Bytes of buffer not yet written */
+    uint64_t lastTicks; /**< cycleCounter value of the previous record, 0 before the first */
+    uint64_t records; /**< Records written so far */
+} TraceWriter;
+
+/**
+ * @struct TraceReader
+ * @brief Sequential trace input, created by traceReaderOpen.
+ */
+typedef struct TraceReader
+{
+    FILE *file;
+    double ticksPerSecond; /**< Tick frequency of the machine that recorded the trace */
+    uint64_t ticks; /**< Timestamp of the last record returned */
+    char *key; /**< Key buffer, grown as needed */
+    size_t keyCapacity;
+} TraceReader;
+
+TraceWriter *traceWriterOpen(const char *path);
+void traceWriterRecord(TraceWriter *writer, DictOp op, const char *key, const char *value);
+bool traceWriterFlush(TraceWriter *writer);
+bool traceWriterClose(TraceWriter *writer);
+
+TraceReader *traceReaderOpen(const char *path);
+bool traceReaderNext(TraceReader *reader, TraceRecord *record);
+void traceReaderClose(TraceReader *reader);
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file Workload.h
+ * @brief YCSB-style workload generator for benchmarking Dict.
+ *
+ * Produces record ids from uniform, Zipfian, latest and hotspot distributions, formats
+ * them into keys without allocating, and mixes read/update/insert/scan/read-modify-write
+ * operations in the proportions of the YCSB core workloads A-F. The runner drives any
+ * Dict through its vtable and records per-operation latency histograms.
+ */
+
+#ifndef WORKLOAD_H_
+#define WORKLOAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Dict.h"
+#include "Histogram.h"
+
+/* Keys are "user" followed by 20 digits, so shorter keys would collide */
+#define WORKLOAD_MIN_KEY_LENGTH 24
+
+typedef enum WorkloadDistribution
+{
+    WORKLOAD_UNIFORM, /**< Every existing record equally likely */
+    WORKLOAD_ZIPFIAN, /**< Zipfian popularity, hot records scattered over the key space */
+    WORKLOAD_LATEST, /**< Zipfian popularity skewed towards the most recently inserted records */
+    WORKLOAD_HOTSPOT /**< A hot fraction of records receives a fixed fraction of operations */
+} WorkloadDistribution;
+
+typedef enum WorkloadOp
+{
+    WORKLOAD_READ,
+    WORKLOAD_UPDATE,
+    WORKLOAD_INSERT,
+    WORKLOAD_SCAN,
+    WORKLOAD_READ_MODIFY_WRITE,
+    WORKLOAD_OP_COUNT /**< Number of operation kinds, not an operation */
+} WorkloadOp;
+
+/**
+ * @struct WorkloadConfig
+ * @brief Parameters of a workload; workloadPreset fills in the YCSB core workloads.
+ */
+typedef struct WorkloadConfig
+{
+    uint64_t recordCount; /**< Records inserted by workloadLoad */
+    uint64_t operationCount; /**< Operations executed by workloadRun */
+    double readProportion;
+    double updateProportion;
+    double insertProportion;
+    double scanProportion;
+    double readModifyWriteProportion;
+    WorkloadDistribution distribution; /**< Distribution of record ids for non-insert operations */
+    double zipfianTheta; /**< Skew of the Zipfian and latest distributions, in (0, 1) */
+    double hotsetFraction; /**< Hotspot: fraction of records that are hot */
+    double hotOperationFraction; /**< Hotspot: fraction of operations that go to hot records */
+    int maxScanLength; /**< Scans read a uniform number of records in [1, maxScanLength] */
+    int keyLength; /**< Key length in bytes, at least WORKLOAD_MIN_KEY_LENGTH */
+    int valueLength; /**< Value length in bytes */
+    uint64_t seed; /**< PRNG seed */
+} WorkloadConfig;
+
+/**
+ * @struct Xoshiro256
+ * @brief State of the xoshiro256** generator.
+ */
+typedef struct Xoshiro256
+{
+    uint64_t s[4];
+} Xoshiro256;
+
+/**
+ * @struct Zipfian
+ * @brief Zipfian generator over [0, itemCount) using the Gray et al. method YCSB uses.
+ */
+typedef struct Zipfian
+{
+    uint64_t itemCount; /**< Items the zeta constant currently covers */
+    double theta;
+    double alpha;
+    double zeta2;
+    double zetaN;
+    double eta;
+} Zipfian;
+
+/**
+ * @struct Workload
+ * @brief Generator state. Created by createWorkload, released by destroyWorkload.
+ */
+typedef struct Workload
+{
+    WorkloadConfig config;
+    Xoshiro256 rng;
+    Zipfian zipfian;
+    uint64_t insertedCount; /**< Record ids [0, insertedCount) exist */
+    char *keyBuffer; /**< Preallocated key, keyLength + 1 bytes */
+    char *valueBuffer; /**< Preallocated value, valueLength + 1 bytes */
+} Workload;
+
+/**
+ * @struct WorkloadResult
+ * @brief Outcome of workloadRun.
+ */
+typedef struct WorkloadResult
+{
+    double seconds; /**< Wall time of the run */
+    uint64_t operations[WORKLOAD_OP_COUNT]; /**< Operations executed per kind */
+    uint64_t readMisses; /**< Reads (including scan and read-modify-write reads) that found no value */
+    Histogram latency[WORKLOAD_OP_COUNT]; /**< Per-kind latency in cycleCounter ticks */
+} WorkloadResult;
+
+void xoshiroSeed(Xoshiro256 *rng, uint64_t seed);
+uint64_t xoshiroNext(Xoshiro256 *rng);
+double xoshiroNextDouble(Xoshiro256 *rng);
+
+void zipfianInit(Zipfian *zipfian, uint64_t itemCount, double theta);
+uint64_t zipfianNext(Zipfian *zipfian, Xoshiro256 *rng, uint64_t itemCount);
+
+bool workloadPreset(WorkloadConfig *config, char name);
+const char *workloadOpName(WorkloadOp op);
+
+Workload *createWorkload(const WorkloadConfig *config);
+void destroyWorkload(Workload *workload);
+
+WorkloadOp workloadNextOp(Workload *workload);
+uint64_t workloadNextRecord(Workload *workload);
+const char *workloadFormatKey(Workload *workload, uint64_t record);
+const char *workloadNextValue(Workload *workload);
+
+void workloadLoad(Workload *workload, Dict *dict);
+void workloadRun(Workload *workload, Dict *dict, WorkloadResult *result);
+
+#endif
@@ -0,0 +1,113 @@
+#include "../include/BloomFilter.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void release_bloom(const BloomFilter *filter, void *block)
+{
+    if (!filter->alloc)
+        free(block);
+    else if (filter->free)
+        filter->free(block, filter->allocCtx);
+}
+
+/**
+ * @brief Create an empty filter sized for capacity keys
+ *
+ * @param capacity Number of keys expected; the false-positive rate rises once more are added
+ * @param bitsPerKey Filter bits per expected key, e.g. 10 for about 1% false positives
+ * @return BloomFilter* New filter, or NULL if out of memory
+ */
+BloomFilter *createBloomFilter(size_t capacity, unsigned int bitsPerKey)
+{
+    return createBloomFilterWithAllocator(capacity, bitsPerKey, NULL, NULL, NULL);
+}
+
+/**
+ * @brief Create an empty filter that takes its memory from the caller's allocator
+ *
+ * The allocator need not align blocks to a cache line: the bit array is carved out of a block
+ * BLOOM_BLOCK_BYTES - 1 bytes larger.
+ *
+ * @param allocFn Returns size bytes, or NULL if out of memory; NULL for malloc
+ * @param freeFn Releases a block, or NULL to never free, for arenas released as a whole
+ * @param ctx User pointer passed to both
+ * @return BloomFilter* New filter, or NULL if out of memory
+ */
+BloomFilter *createBloomFilterWithAllocator(size_t capacity, unsigned int bitsPerKey, BloomAllocFn allocFn, BloomFreeFn freeFn, void *ctx)
+{
+    BloomFilter *filter = allocFn ? allocFn(sizeof(BloomFilter), ctx) : malloc(sizeof(BloomFilter));
+    size_t bits = (capacity ? capacity : 1) * (bitsPerKey ? bitsPerKey : 1);
+
+    if (!filter)
+        return NULL;
+
+    filter->alloc = allocFn;
+    filter->free = allocFn ? freeFn : NULL;
+    filter->allocCtx = ctx;
+    filter->blockCount = (bits + BLOOM_BLOCK_BITS - 1) / BLOOM_BLOCK_BITS;
+    if (allocFn)
+    {
+        filter->wordsBlock = allocFn(filter->blockCount * BLOOM_BLOCK_BYTES + BLOOM_BLOCK_BYTES - 1, ctx);
+        filter->words = (uint64_t *)(((uintptr_t)filter->wordsBlock + BLOOM_BLOCK_BYTES - 1) & ~(uintptr_t)(BLOOM_BLOCK_BYTES - 1));
+    }
+    else
+    {
+        filter->wordsBlock = filter->words = aligned_alloc(BLOOM_BLOCK_BYTES, filter->blockCount * BLOOM_BLOCK_BYTES);
+    }
+    if (!filter->wordsBlock)
+    {
+        release_bloom(filter, filter);
+        return NULL;
+    }
+
+    // k = bitsPerKey * ln 2 minimises the false-positive rate
+    filter->probes = (unsigned int)(bitsPerKey * 0.693 + 0.5);
+    if (filter->probes < 1)
+        filter->probes = 1;
+    if (filter->probes > 16)
+        filter->probes = 16;
+    filter->capacity = capacity;
+
+    bloomFilterClear(filter);
+    return filter;
+}
+
+void destroyBloomFilter(BloomFilter *filter)
+{
+    if (!filter)
+        return;
+
+    release_bloom(filter, filter->wordsBlock);
+    release_bloom(filter, filter);
+}
+
+/**
+ * @brief Forget every key
+ */
+void bloomFilterClear(BloomFilter *filter)
+{
+    memset(filter->words, 0, filter->blockCount * BLOOM_BLOCK_BYTES);
+}
+
+/**
+ * @brief 64-bit hash of a key for the filter: FNV-1a followed by a murmur3 finaliser
+ *
+ * Independent of hash_dict, whose result is already reduced modulo the table size.
+ */
+uint64_t bloomFilterHash(const char *key)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    while (*key)
+    {
+        hash ^= (unsigned char)*key++;
+        hash *= 0x100000001b3ull;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
@@ -0,0 +1,470 @@
+#include "../include/CompactDict.h"
+#include "../include/DictEngine.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DICT_COMPACT_MIN_SLOTS 16
+#define DICT_COMPACT_MAX_LOAD 87 /* percent of the slots in use beyond which the index grows by half */
+#define DICT_COMPACT_FIRST_SEGMENT_BYTES 4096 /* segments start small and double, so small dicts stay small */
+#define DICT_COMPACT_MIN_RECLAIM ((uint64_t)1 << 20) /* garbage bytes below which the pool is never rewritten */
+
+static inline uint32_t hash_compact(const char *key)
+{
+    return (uint32_t)engineHash_dict(key);
+}
+
+/**
+ * @brief Address of the record a reference points to
+ */
+static inline char *record_compact(const CompactDict *dict, uint32_t ref)
+{
+    uint64_t offset = (uint64_t)ref * DICT_COMPACT_GRANULE;
+
+    return dict->segments[offset >> DICT_COMPACT_SEGMENT_SHIFT] + (offset & (DICT_COMPACT_SEGMENT_BYTES - 1));
+}
+
+static inline size_t recordBytes_compact(size_t keyLength, size_t valueLength)
+{
+    size_t bytes = keyLength + valueLength + 2;
+
+    return (bytes + DICT_COMPACT_GRANULE - 1) / DICT_COMPACT_GRANULE * DICT_COMPACT_GRANULE;
+}
+
+static inline size_t home_compact(const CompactDict *dict, uint32_t hash)
+{
+    return (size_t)(((uint64_t)hash * dict->slotCount) >> 32);
+}
+
+static inline size_t step_compact(const CompactDict *dict, size_t i)
+{
+    return i + 1 == dict->slotCount ? 0 : i + 1;
+}
+
+/**
+ * @brief Distance of slot i from the home slot of a hash
+ */
+static inline size_t distance_compact(const CompactDict *dict, size_t i, uint32_t hash)
+{
+    size_t home = home_compact(dict, hash);
+
+    return i >= home ? i - home : i + dict->slotCount - home;
+}
+
+static void freePool_compact(CompactDict *dict)
+{
+    for (size_t i = 0; i < dict->segmentCount; i++)
+        free(dict->segments[i]);
+    free(dict->segments);
+}
+
+static void resetPool_compact(CompactDict *dict)
+{
+    dict->segments = NULL;
+    dict->segmentCount = 0;
+    dict->segmentCapacity = 0;
+    dict->lastBytes = 0;
+    dict->poolBytes = 0;
+    dict->tail = DICT_COMPACT_GRANULE; // offset 0 stays unused so that ref 0 can mark empty slots
+    dict->garbageBytes = 0;
+}
+
+static bool addSegment_compact(CompactDict *dict, size_t needed)
+{
+    size_t bytes = DICT_COMPACT_FIRST_SEGMENT_BYTES;
+    char *segment;
+
+    if (dict->segmentCount == dict->segmentCapacity)
+    {
+        size_t capacity = dict->segmentCapacity ? dict->segmentCapacity * 2 : 4;
+        char **segments = realloc(dict->segments, capacity * sizeof(char *));
+
+        if (!segments)
+            return false;
+        dict->segments = segments;
+        dict->segmentCapacity = capacity;
+    }
+
+    while (bytes < needed)
+        bytes *= 2;
+    segment = malloc(bytes);
+    if (!segment)
+        return false;
+
+    dict->segments[dict->segmentCount++] = segment;
+    dict->lastBytes = bytes;
+    dict->poolBytes += bytes;
+    return true;
+}
+
+/**
+ * @brief Reserve bytes at the end of the pool; a record never straddles two segments
+ *
+ * @return uint32_t Reference to the reserved bytes, 0 if out of memory or the pool is out of references
+ */
+static uint32_t allocRecord_compact(CompactDict *dict, size_t bytes)
+{
+    uint64_t start = dict->tail;
+    size_t within = (size_t)(start & (DICT_COMPACT_SEGMENT_BYTES - 1));
+    size_t skipped = 0;
+    size_t segment;
+
+    if (bytes > DICT_COMPACT_SEGMENT_BYTES)
+        return 0;
+    if (within + bytes > DICT_COMPACT_SEGMENT_BYTES)
+    {
+        skipped = DICT_COMPACT_SEGMENT_BYTES - within;
+        start += skipped;
+        within = 0;
+    }
+    if ((start + bytes) / DICT_COMPACT_GRANULE > UINT32_MAX)
+        return 0;
+
+    segment = (size_t)(start >> DICT_COMPACT_SEGMENT_SHIFT);
+    if (segment == dict->segmentCount)
+    {
+        // the record starts at within, which is not 0 at the start of the pool
+        if (!addSegment_compact(dict, within + bytes))
+            return 0;
+    }
+    else if (within + bytes > dict->lastBytes)
+    {
+        size_t grown = dict->lastBytes;
+        char *last;
+
+        while (grown < within + bytes)
+            grown *= 2;
+        last = realloc(dict->segments[segment], grown);
+        if (!last)
+            return 0;
+        dict->segments[segment] = last;
+        dict->poolBytes += grown - dict->lastBytes;
+        dict->lastBytes = grown;
+    }
+
+    dict->garbageBytes += skipped;
+    dict->tail = start + bytes;
+    return (uint32_t)(start / DICT_COMPACT_GRANULE);
+}
+
+static uint32_t storeRecord_compact(CompactDict *dict, const char *key, size_t keyLength, const char *value, size_t valueLength)
+{
+    uint32_t ref = allocRecord_compact(dict, recordBytes_compact(keyLength, valueLength));
+    char *record;
+
+    if (!ref)
+        return 0;
+
+    record = record_compact(dict, ref);
+    memcpy(record, key, keyLength + 1);
+    memcpy(record + keyLength + 1, value, valueLength + 1);
+    return ref;
+}
+
+/**
+ * @brief Copy the live records into a fresh pool once more than half of the pool is garbage
+ *
+ * Nothing changes if the copy runs out of memory; the garbage is simply kept for now.
+ */
+static void reclaim_compact(CompactDict *dict)
+{
+    if (dict->garbageBytes < DICT_COMPACT_MIN_RECLAIM || dict->garbageBytes * 2 < dict->tail)
+        return;
+
+    size_t slotCount = dict->slotCount;
+    uint32_t *refs = malloc(slotCount * sizeof(uint32_t));
+    CompactDict fresh;
+
+    if (!refs)
+        return;
+
+    resetPool_compact(&fresh);
+    for (size_t i = 0; i < slotCount; i++)
+    {
+        uint32_t ref = dict->slots[i].ref;
+
+        refs[i] = 0;
+        if (!ref)
+            continue;
+
+        const char *record = record_compact(dict, ref);
+        size_t keyLength = strlen(record);
+        const char *value = record + keyLength + 1;
+
+        refs[i] = storeRecord_compact(&fresh, record, keyLength, value, strlen(value));
+        if (!refs[i])
+        {
+            freePool_compact(&fresh);
+            free(refs);
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < slotCount; i++)
+        dict->slots[i].ref = refs[i];
+    free(refs);
+
+    freePool_compact(dict);
+    dict->segments = fresh.segments;
+    dict->segmentCount = fresh.segmentCount;
+    dict->segmentCapacity = fresh.segmentCapacity;
+    dict->lastBytes = fresh.lastBytes;
+    dict->poolBytes = fresh.poolBytes;
+    dict->tail = fresh.tail;
+    dict->garbageBytes = fresh.garbageBytes;
+}
+
+/**
+ * @brief Store an entry for a key not in the index, taking slots from entries closer to their home
+ */
+static void place_compact(CompactDict *dict, CompactSlot entry)
+{
+    size_t i = home_compact(dict, entry.hash);
+
+    for (size_t distance = 0;; distance++, i = step_compact(dict, i))
+    {
+        CompactSlot *slot = &dict->slots[i];
+        size_t resident;
+
+        if (!slot->ref)
+        {
+            *slot = entry;
+            return;
+        }
+
+        resident = distance_compact(dict, i, slot->hash);
+        if (resident < distance)
+        {
+            CompactSlot displaced = *slot;
+
+            *slot = entry;
+            entry = displaced;
+            distance = resident;
+        }
+    }
+}
+
+static bool grow_compact(CompactDict *dict, size_t slotCount)
+{
+    CompactSlot *old = dict->slots;
+    size_t oldCount = dict->slotCount;
+    CompactSlot *slots = calloc(slotCount, sizeof(CompactSlot));
+
+    if (!slots)
+        return false;
+
+    dict->slots = slots;
+    dict->slotCount = slotCount;
+    for (size_t i = 0; i < oldCount; i++)
+    {
+        if (old[i].ref)
+            place_compact(dict, old[i]);
+    }
+    free(old);
+    return true;
+}
+
+/**
+ * @brief Slot of a key, stopping at the first slot whose entry is closer to its home than the key would be
+ *
+ * @return size_t Slot index, or SIZE_MAX if the key is absent
+ */
+static size_t locate_compact(const CompactDict *dict, const char *key, uint32_t hash)
+{
+    size_t i = home_compact(dict, hash);
+
+    for (size_t distance = 0;; distance++, i = step_compact(dict, i))
+    {
+        const CompactSlot *slot = &dict->slots[i];
+
+        if (!slot->ref || distance_compact(dict, i, slot->hash) < distance)
+            return SIZE_MAX;
+        if (slot->hash == hash && strcmp(record_compact(dict, slot->ref), key) == 0)
+            return i;
+    }
+}
+
+/**
+ * @brief Create an empty compact dictionary
+ *
+ * @param capacity Number of keys to size the index for, so that loading them never rehashes; 0 for the minimum
+ * @return CompactDict* New dictionary, or NULL if out of memory
+ */
+CompactDict *createCompactDict(size_t capacity)
+{
+    CompactDict *dict = malloc(sizeof(CompactDict));
+    size_t slotCount = capacity * 100 / DICT_COMPACT_MAX_LOAD + 1;
+
+    if (!dict)
+        return NULL;
+
+    if (slotCount < DICT_COMPACT_MIN_SLOTS)
+        slotCount = DICT_COMPACT_MIN_SLOTS;
+
+    dict->slots = calloc(slotCount, sizeof(CompactSlot));
+    if (!dict->slots)
+    {
+        free(dict);
+        return NULL;
+    }
+    dict->slotCount = slotCount;
+    dict->count = 0;
+    dict->payloadBytes = 0;
+    resetPool_compact(dict);
+    return dict;
+}
+
+/**
+ * @brief Free the dictionary, its index and its pool
+ */
+void destroyCompactDict(CompactDict *dict)
+{
+    if (!dict)
+        return;
+
+    freePool_compact(dict);
+    free(dict->slots);
+    free(dict);
+}
+
+/**
+ * @brief Set the value of a key, adding the key if it is absent
+ *
+ * A value of the same length is overwritten in place; otherwise the pair is appended to the pool and
+ * the old record becomes garbage, reclaimed once garbage outweighs live records.
+ * key and value must not point into the dictionary's own pool.
+ *
+ * @param dict Pointer to the dictionary
+ * @param key Key to set
+ * @param value Value to store
+ * @return bool false if out of memory, the pair is larger than a segment or the pool is out of references
+ */
+bool compactDictPut(CompactDict *dict, const char *key, const char *value)
+{
+    uint32_t hash = hash_compact(key);
+    size_t i = locate_compact(dict, key, hash);
+    size_t keyLength = strlen(key);
+    size_t valueLength = strlen(value);
+    uint32_t ref;
+
+    if (i != SIZE_MAX)
+    {
+        char *old = record_compact(dict, dict->slots[i].ref) + keyLength + 1;
+        size_t oldLength = strlen(old);
+
+        if (oldLength == valueLength)
+        {
+            memcpy(old, value, valueLength);
+            return true;
+        }
+
+        ref = storeRecord_compact(dict, key, keyLength, value, valueLength);
+        if (!ref)
+            return false;
+
+        dict->slots[i].ref = ref;
+        dict->garbageBytes += recordBytes_compact(keyLength, oldLength);
+        dict->payloadBytes = dict->payloadBytes - oldLength + valueLength;
+        reclaim_compact(dict);
+        return true;
+    }
+
+    if ((dict->count + 1) * 100 > dict->slotCount * DICT_COMPACT_MAX_LOAD && !grow_compact(dict, dict->slotCount + dict->slotCount / 2))
+        return false;
+
+    ref = storeRecord_compact(dict, key, keyLength, value, valueLength);
+    if (!ref)
+        return false;
+
+    place_compact(dict, (CompactSlot){hash, ref});
+    dict->count++;
+    dict->payloadBytes += keyLength + valueLength;
+    return true;
+}
+
+/**
+ * @brief Value of a key
+ *
+ * @return const char* The value, valid until the next put or remove, or NULL if the key is absent
+ */
+const char *compactDictGet(const CompactDict *dict, const char *key)
+{
+    size_t i = locate_compact(dict, key, hash_compact(key));
+
+    if (i == SIZE_MAX)
+        return NULL;
+    return record_compact(dict, dict->slots[i].ref) + strlen(key) + 1;
+}
+
+/**
+ * @brief Remove a key; the following displaced entries move back one slot, leaving no tombstone
+ *
+ * @return bool false if the key was absent
+ */
+bool compactDictRemove(CompactDict *dict, const char *key)
+{
+    size_t i = locate_compact(dict, key, hash_compact(key));
+
+    if (i == SIZE_MAX)
+        return false;
+
+    const char *record = record_compact(dict, dict->slots[i].ref);
+    size_t keyLength = strlen(record);
+    size_t valueLength = strlen(record + keyLength + 1);
+
+    for (size_t next = step_compact(dict, i); dict->slots[next].ref && distance_compact(dict, next, dict->slots[next].hash); next = step_compact(dict, next))
+    {
+        dict->slots[i] = dict->slots[next];
+        i = next;
+    }
+    dict->slots[i] = (CompactSlot){0, 0};
+
+    dict->count--;
+    dict->garbageBytes += recordBytes_compact(keyLength, valueLength);
+    dict->payloadBytes -= keyLength + valueLength;
+    reclaim_compact(dict);
+    return true;
+}
+
+size_t compactDictSize(const CompactDict *dict)
+{
+    return dict->count;
+}
+
+/**
+ * @brief Pass every pair to visitor, in no particular order, until it returns false
+ *
+ * The dictionary must not change during the iteration.
+ *
+ * @return size_t Number of pairs passed to visitor
+ */
+size_t compactDictForEach(const CompactDict *dict, DictVisitor visitor, void *ctx)
+{
+    size_t visited = 0;
+
+    for (size_t i = 0; i < dict->slotCount; i++)
+    {
+        if (!dict->slots[i].ref)
+            continue;
+
+        const char *record = record_compact(dict, dict->slots[i].ref);
+
+        visited++;
+        if (!visitor(record, record + strlen(record) + 1, ctx))
+            break;
+    }
+    return visited;
+}
+
+/**
+ * @brief Fill out with the dictionary's memory use
+ */
+void compactDictStats(const CompactDict *dict, CompactDictStats *out)
+{
+    out->entryCount = dict->count;
+    out->slotCount = dict->slotCount;
+    out->indexBytes = out->slotCount * sizeof(CompactSlot);
+    out->poolBytes = dict->poolBytes;
+    out->garbageBytes = dict->garbageBytes;
+    out->payloadBytes = dict->payloadBytes;
+    out->overheadPerEntry = dict->count ? (double)(out->indexBytes + out->poolBytes - out->payloadBytes) / dict->count : 0.0;
+}
@@ -1,4 +1,54 @@
+#define _POSIX_C_SOURCE 200809L /* strdup */
+
 #include "../include/Dict.h"
+#include "../include/DictEngine.h"
+#include "../include/KeySort.h"
+
+#ifdef __GLIBC__
+#include <malloc.h> /* malloc_usable_size, malloc_trim */
+#endif
+
+#include <stdatomic.h>
+
+#ifdef DICT_ENABLE_THREADS
+#include <pthread.h>
+#endif
+
+#ifdef DICT_ENABLE_TRACE
+#include "../include/Trace.h"
+
+#define DICT_TRACE(self, op, key, value) \
+    do { if ((self)->trace_dict) traceWriterRecord((self)->trace_dict, (op), (key), (value)); } while (0)
+#else
+#define DICT_TRACE(self, op, key, value) ((void)0)
+#endif
+
+#ifdef DICT_ENABLE_COUNTERS
+#define DICT_COUNT(self, field) ((self)->counters_dict.field++)
+#else
+#define DICT_COUNT(self, field) ((void)0)
+#endif
+
+#ifdef DICT_ENABLE_LATENCY
+#define DICT_LATENCY_BEGIN(self) uint64_t latencyStart = (self)->latency_dict ? cycleCounter() : 0
+#define DICT_LATENCY_END(self, op, key, chain) \
+    do { if ((self)->latency_dict) recordLatency_dict((self)->latency_dict, (op), (key), (chain), latencyStart); } while (0)
+
+/**
+ * @brief Record one timed operation and fire the slow-operation hook if it ran past the threshold
+ */
+static void recordLatency_dict(DictLatency *latency, DictOp op, const char *key, size_t chainLength, uint64_t start)
+{
+    uint64_t cycles = cycleCounter() - start;
+
+    histogramRecord(&latency->histograms[op], cycles);
+    if (latency->slowHook && cycles > latency->slowThreshold)
+        latency->slowHook(key, op, chainLength, cycles, latency->slowHookCtx);
+}
+#else
+#define DICT_LATENCY_BEGIN(self) ((void)0)
+#define DICT_LATENCY_END(self, op, key, chain) ((void)(chain))
+#endif
 
 /**
  * @brief Compute the hash of a key
@@ -17,422 +67,3075 @@ unsigned int hash_dict(const char *key)
 /**
  * @brief Create a new key-value pair
  * 
+ * @param self Dictionary whose allocator provides the pair
  * @param key Key for the new pair
  * @param value Value for the new pair
- * @return KeyValue* Pointer to the new key-value pair
+ * @return KeyValue* Pointer to the new key-value pair, or NULL if out of memory
  */
-KeyValue *pair_dict(const char *key, const char *value)
+KeyValue *pair_dict(const Dict *self, const char *key, const char *value)
 {
-    KeyValue *pair = malloc(sizeof(*pair));
-    pair->key = strdup(key);
-    pair->value = strdup(value);
+    KeyValue *pair = memAlloc_dict(self, sizeof(*pair));
+
+    if (!pair)
+        return NULL;
+    pair->key = memStrdup_dict(self, key);
+    pair->value = memStrdup_dict(self, value);
+    if (!pair->key || !pair->value)
+    {
+        memFree_dict(self, pair->key);
+        memFree_dict(self, pair->value);
+        memFree_dict(self, pair);
+        return NULL;
+    }
     pair->next = NULL;
+    pair->timer = NULL;
     return pair;
 }
 
+#ifdef DICT_ENABLE_THREADS
+/* Values at least this large are freed by the reclaim thread in lazy-free mode */
+#ifndef DICT_LAZY_FREE_MIN_BYTES
+#define DICT_LAZY_FREE_MIN_BYTES (64 * 1024)
+#endif
+
+/* Tables with fewer pairs are cleared inline even in lazy-free mode: handing them over costs more */
+#ifndef DICT_LAZY_FREE_MIN_PAIRS
+#define DICT_LAZY_FREE_MIN_PAIRS 64
+#endif
+
 /**
- * @brief Retrieve a value associated with a given key from the dictionary
- * 
- * @param table Pointer to the dictionary from which to retrieve the value
- * @param key Key for which to retrieve the value
- * @return char* Value associated with the given key, or NULL if the key does not exist
+ * @struct DictReclaim
+ * @brief One block of work for the reclaim thread, allocated with the allocator of the dictionary it came from.
  */
-char *get_dict(Dict *table, const char *key)
+typedef struct DictReclaim
 {
-    unsigned int idx = table->hash_dict(key);
-    KeyValue *pair = table->buckets_dict[idx];
-
-    while (pair && strcmp(key, pair->key) != 0)
-        pair = pair->next;
+    void (*run)(const DictAllocator *allocator, void *block); /**< Frees block, called on the reclaim thread */
+    void *block;
+    DictAllocator allocator; /**< Copy of the dictionary's allocator, which may be gone by the time run is called */
+    struct DictReclaim *next;
+} DictReclaim;
 
-    return pair ? pair->value : NULL;
-}
+/**
+ * @struct DictReclaimQueue
+ * @brief The process-wide queue of the reclaim thread, started on first use and never stopped.
+ */
+static struct DictReclaimQueue
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t work; /**< Signalled when a job is queued */
+    pthread_cond_t idle; /**< Signalled when the last pending job is done */
+    DictReclaim *head;
+    DictReclaim *tail;
+    size_t pending; /**< Jobs queued or running */
+    bool started;
+} reclaimQueue_dict = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, false};
 
 /**
- * @brief Insert a new key-value pair into the dictionary
- * 
- * @param table Pointer to the dictionary into which to insert the pair
- * @param key Key for the new pair
- * @param value Value for the new pair
+ * @brief Free a block the way memFree_dict would for a dictionary with this allocator
  */
-void insert_dict(Dict *table, const char *key, const char *value)
+static void releaseBlock_dict(const DictAllocator *allocator, void *block)
 {
-    unsigned int idx = table->hash_dict(key);
-    KeyValue *newpair = pair_dict(key, value);
-    KeyValue **next = &(table->buckets_dict[idx]);
+    if (!allocator->alloc)
+        free(block);
+    else if (allocator->free && block)
+        allocator->free(block, allocator->ctx);
+}
 
-    while (*next)
-        next = &((*next)->next);
+static void *reclaimWorker_dict(void *arg)
+{
+    struct DictReclaimQueue *queue = arg;
+
+    pthread_mutex_lock(&queue->mutex);
+    for (;;)
+    {
+        while (!queue->head)
+            pthread_cond_wait(&queue->work, &queue->mutex);
 
-    *next = newpair;
+        DictReclaim *job = queue->head;
+        DictAllocator allocator = job->allocator;
 
-    table->size_field_dict++;
+        queue->head = job->next;
+        if (!queue->head)
+            queue->tail = NULL;
+        pthread_mutex_unlock(&queue->mutex);
+
+        job->run(&allocator, job->block);
+        releaseBlock_dict(&allocator, job);
+
+        pthread_mutex_lock(&queue->mutex);
+        if (--queue->pending == 0)
+            pthread_cond_broadcast(&queue->idle);
+    }
+    return NULL;
 }
 
 /**
- * @brief Remove a key-value pair from the dictionary
+ * @brief Hand a block to the reclaim thread, starting it if need be
  * 
- * @param table Pointer to the dictionary from which to remove the pair
- * @param key Key for the pair to remove
+ * @return bool false if the job or the thread could not be created, in which case the caller frees the block itself
  */
-void removeKey_dict(Dict *table, const char *key)
+static bool reclaimLater_dict(const Dict *self, void (*run)(const DictAllocator *allocator, void *block), void *block)
 {
-    unsigned int idx = table->hash_dict(key);
-    KeyValue **pair = &(table->buckets_dict[idx]);
+    struct DictReclaimQueue *queue = &reclaimQueue_dict;
+    DictReclaim *job = memAlloc_dict(self, sizeof(DictReclaim));
 
-    while (*pair && stringCompare(key, (*pair)->key) == 0)
-        pair = &((*pair)->next);
+    if (!job)
+        return false;
+    *job = (DictReclaim){run, block, self->allocator_dict, NULL};
 
-    if (*pair)
+    pthread_mutex_lock(&queue->mutex);
+    if (!queue->started)
     {
-        KeyValue *temp = *pair;
-        *pair = (*pair)->next;
-        free(temp->key);
-        free(temp->value);
-        free(temp);
-        table->size_field_dict--;
+        pthread_t thread;
+
+        queue->started = pthread_create(&thread, NULL, reclaimWorker_dict, queue) == 0;
+        if (queue->started)
+            pthread_detach(thread);
+    }
+    if (!queue->started)
+    {
+        pthread_mutex_unlock(&queue->mutex);
+        memFree_dict(self, job);
+        return false;
     }
+
+    if (queue->tail)
+        queue->tail->next = job;
+    else
+        queue->head = job;
+    queue->tail = job;
+    queue->pending++;
+    pthread_cond_signal(&queue->work);
+    pthread_mutex_unlock(&queue->mutex);
+    return true;
 }
 
 /**
- * @brief Check if a key exists in the dictionary
- * 
- * @param table Pointer to the dictionary in which to check for the key
- * @param key Key for which to check
- * @return int Boolean indicating whether the key exists (non-zero) or not (zero)
+ * @brief Size of a value, from the allocator when it can tell
  */
-int exists_dict(Dict *table, const char *key)
+static inline size_t valueBytes_dict(const Dict *self, const char *value)
 {
-    return table->get_dict(table, key) != NULL;
+#ifdef __GLIBC__
+    if (!self->allocator_dict.alloc)
+        return malloc_usable_size((void *)value);
+#endif
+    (void)self;
+    return strlen(value) + 1;
 }
+#endif
 
 /**
- * @brief Retrieve the number of key-value pairs in the dictionary
+ * @brief Free a value, on the reclaim thread if it is large and the dictionary is in lazy-free mode
+ */
+static inline void freeValue_dict(Dict *self, char *value)
+{
+#ifdef DICT_ENABLE_THREADS
+    if (self->lazyFree_dict && value && valueBytes_dict(self, value) >= DICT_LAZY_FREE_MIN_BYTES &&
+        reclaimLater_dict(self, releaseBlock_dict, value))
+        return;
+#endif
+    memFree_dict(self, value);
+}
+
+/**
+ * @brief Free a pair's key, value, expiry timer and node
  * 
- * @param table Pointer to the dictionary for which to retrieve the size
- * @return int Number of key-value pairs in the dictionary
+ * @param pair Pair already unlinked from its bucket and, if it has a timer, from the timer wheel
  */
-int size_dict(Dict *table)
+static void freePair_dict(Dict *self, KeyValue *pair)
 {
-    return table->size_field_dict;
+    memFree_dict(self, pair->key);
+    freeValue_dict(self, pair->value);
+    memFree_dict(self, pair->timer);
+    memFree_dict(self, pair);
 }
 
 /**
- * @brief Update the value associated with a given key in the dictionary, or insert a new key-value pair if the key does not exist
+ * @brief Unlink a pair from the table, found by identity rather than by key
+ */
+static inline void unlinkPair_dict(Dict *self, KeyValue *pair)
+{
+    self->engine_dict->unlink(self, pair);
+}
+
+/**
+ * @brief Next pair of an iteration over the table, or over the run of slots the cursor was started on
  * 
- * @param table Pointer to the dictionary in which to update or insert the pair
- * @param key Key for the pair to update or insert
- * @param value New value for the pair
+ * Start the cursor as {first slot, slot to stop before or SIZE_MAX, NULL, 0}. The table must not change
+ * during the iteration.
  */
-void update_dict(Dict *table, const char *key, const char *value)
+static inline KeyValue *nextPair_dict(const Dict *self, DictCursor *cursor)
 {
-    unsigned int idx = table->hash_dict(key);
-    KeyValue *pair = table->buckets_dict[idx];
-    while (pair)
-    {
-        if (stringCompare(key, pair->key))
-        {
-            free(pair->value);
-            pair->value = strdup(value);
-            return;
-        }
-        pair = pair->next;
-    }
-    // If key does not exist, insert new key-value pair
-    table->insert_dict(table, key, value);
+    return self->engine_dict->next(self, cursor);
 }
 
+#define DICT_BLOOM_MIN_CAPACITY 1024
+
 /**
- * @brief Clear all key-value pairs from the dictionary
+ * @brief Rebuild the Bloom filter from the keys currently linked, sized for twice as many
  * 
- * @param table Pointer to the dictionary to clear
+ * Called when more keys were added than the filter was sized for, which would make false positives
+ * climb, and when removed keys still set in the filter outnumber half of its capacity.
+ * 
+ * @return bool false if out of memory, leaving the old filter in place
  */
-void clear_dict(Dict *table)
+static bool bloomRebuild_dict(Dict *self, DictBloom *bloom)
 {
-    KeyValue *pair;
-    KeyValue *tmp;
+    size_t capacity = (size_t)self->size_field_dict * 2;
+    BloomFilter *filter = createBloomFilterWithAllocator(capacity > DICT_BLOOM_MIN_CAPACITY ? capacity : DICT_BLOOM_MIN_CAPACITY, bloom->bitsPerKey,
+                                                         self->allocator_dict.alloc, self->allocator_dict.free, self->allocator_dict.ctx);
 
-    for (int i = 0; i < TABLE_SIZE; i++)
-    {
-        pair = table->buckets_dict[i];
-        while (pair)
-        {
-            tmp = pair;
-            pair = pair->next;
-            free(tmp->key);
-            free(tmp->value);
-            free(tmp);
-        }
+    // out of memory: keep the old filter, which may be less selective but never misses a key
+    if (!filter)
+        return false;
 
-        table->buckets_dict[i] = NULL;
-    }
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
 
-    // Reset size
-    table->size_field_dict = 0;
+    for (KeyValue *pair = nextPair_dict(self, &cursor); pair; pair = nextPair_dict(self, &cursor))
+        bloomFilterAdd(filter, bloomFilterHash(pair->key));
+
+    destroyBloomFilter(bloom->filter);
+    bloom->filter = filter;
+    bloom->removed = 0;
+    return true;
 }
 
 /**
- * @brief Retrieve a list of all keys in the dictionary
- * 
- * @param table Pointer to the dictionary for which to retrieve the keys
- * @return char** List of all keys in the dictionary, terminated by a NULL pointer
+ * @brief Add a newly linked key to the Bloom filter, growing the filter once it is full
  */
-char **keys_dict(Dict *table)
+static void bloomAdd_dict(Dict *self, DictBloom *bloom, const char *key)
 {
-    int size = table->size_dict(table);
-    char **keysArray = malloc(sizeof(char *) * (size + 1)); // extra space for NULL terminator
-    int index = 0;
-
-    for (int i = 0; i < TABLE_SIZE; i++)
-    {
-        KeyValue *pair = table->buckets_dict[i];
-        while (pair)
-        {
-            keysArray[index++] = strdup(pair->key);
-            pair = pair->next;
-        }
-    }
+    // a rebuild takes in the new key along with the others; the old filter still needs it added
+    if ((size_t)self->size_field_dict <= bloom->filter->capacity || !bloomRebuild_dict(self, bloom))
+        bloomFilterAdd(bloom->filter, bloomFilterHash(key));
+}
 
-    keysArray[index] = NULL; // NULL terminator
-    return keysArray;
+/**
+ * @brief Note that a pair was unlinked; its bits stay set until enough removals trigger a rebuild
+ */
+static void bloomRemoved_dict(Dict *self, DictBloom *bloom)
+{
+    if (++bloom->removed > bloom->filter->capacity / 2)
+        bloomRebuild_dict(self, bloom);
 }
 
 /**
- * @brief Retrieve a list of all values in the dictionary
- * 
- * @param table Pointer to the dictionary for which to retrieve the values
- * @return char** List of all values in the dictionary, terminated by a NULL pointer
+ * @brief Check whether the Bloom filter proves that a key is absent, which costs one cache line
  */
-char **values_dict(Dict *table)
+static inline bool bloomExcludes_dict(const DictBloom *bloom, const char *key)
 {
-    int size = table->size_dict(table);
-    char **valuesArray = malloc(sizeof(char *) * (size + 1)); // extra space for NULL terminator
-    int index = 0;
-    for (int i = 0; i < TABLE_SIZE; i++)
-    {
-        KeyValue *pair = table->buckets_dict[i];
-        while (pair)
-        {
-            valuesArray[index++] = strdup(pair->value);
-            pair = pair->next;
-        }
-    }
-    valuesArray[index] = NULL; // NULL terminator
-    return valuesArray;
+    return !bloomFilterMayContain(bloom->filter, bloomFilterHash(key));
+}
+
+static void freeBloom_dict(Dict *self, DictBloom *bloom)
+{
+    if (bloom)
+        destroyBloomFilter(bloom->filter);
+    memFree_dict(self, bloom);
 }
 
 /**
- * @brief Retrieve a list of all items (key-value pairs) in the dictionary
+ * @brief Drop an unlinked pair from the ordered index
  * 
- * @param table Pointer to the dictionary for which to retrieve the items
- * @return DictItem* List of all items in the dictionary, terminated by a NULL pointer
+ * With duplicate keys the index points at the pair lookups return; if that pair goes, the next
+ * duplicate takes its place.
  */
-DictItem *items_dict(Dict *table)
+static void indexRemove_dict(Dict *self, KeyValue *pair)
 {
-    int size = table->size_dict(table);
-    DictItem *itemsArray = malloc(sizeof(DictItem) * (size + 1)); // extra space for NULL terminator
-    int index = 0;
-    for (int i = 0; i < TABLE_SIZE; i++)
-    {
-        KeyValue *pair = table->buckets_dict[i];
-        while (pair)
-        {
-            itemsArray[index].key = strdup(pair->key);
-            itemsArray[index].value = strdup(pair->value);
-            index++;
-            pair = pair->next;
-        }
-    }
-    itemsArray[index].key = NULL;   // NULL terminator
-    itemsArray[index].value = NULL; // NULL terminator
-    return itemsArray;
+    if (radixTreeSearch(self->index_dict, pair->key) != pair)
+        return;
+
+    size_t probes;
+    KeyValue *other = self->engine_dict->find(self, pair->key, &probes);
+
+    // repointing the leaf allocates nothing, unlike removing it and inserting it again
+    if (other)
+        radixTreeReplace(self->index_dict, other->key, other);
+    else
+        radixTreeRemove(self->index_dict, pair->key);
+}
+
+#define DICT_CACHE_DEFAULT_SAMPLES 5
+#define DICT_LFU_INIT_VAL 5 /* counter of a new pair, so that it is not the first victim before its second access */
+#define DICT_LFU_DEFAULT_LOG_FACTOR 10
+#define DICT_LFU_DEFAULT_DECAY_SECONDS 60
+
+/* Access clock for sampled LRU, read without touching shared state: 2^16 cycles per tick (tens of
+ * microseconds), wrapping after about a day and a half at 2 GHz */
+static inline uint32_t lruClock_dict(void)
+{
+    return (uint32_t)(cycleCounter() >> 16);
+}
+
+static inline uint64_t cacheRandom_dict(DictCache *cache)
+{
+    // xorshift64
+    cache->rng ^= cache->rng << 13;
+    cache->rng ^= cache->rng >> 7;
+    cache->rng ^= cache->rng << 17;
+    return cache->rng;
+}
+
+/* LFU decay clock in seconds, kept to the 24 bits stored in KeyValue::accessTime */
+static inline uint32_t lfuClock_dict(void)
+{
+    return (uint32_t)(timerWheelNowMs() / 1000) & 0xFFFFFF;
 }
 
 /**
- * @brief Compute the load factor of the dictionary (number of items / table size)
- * 
- * @param table Pointer to the dictionary for which to compute the load factor
- * @return double Load factor of the dictionary
+ * @brief LFU counter of a pair after one decrement per lfuDecaySeconds of idleness
  */
-double loadFactor_dict(Dict *table)
+static unsigned int lfuDecayed_dict(const DictCache *cache, uint32_t accessTime, uint32_t now)
 {
-    int size = table->size_dict(table);
-    return (double)size / TABLE_SIZE;
+    unsigned int counter = accessTime & 0xFF;
+    uint32_t periods = ((now - (accessTime >> 8)) & 0xFFFFFF) / cache->config.lfuDecaySeconds;
+
+    return periods >= counter ? 0 : counter - (unsigned int)periods;
 }
 
 /**
- * @brief Remove a key-value pair from the dictionary and return its value, or return a default value if the key does not exist
+ * @brief Record an access in a pair's LFU counter
  * 
- * @param self Pointer to the dictionary from which to remove the pair
- * @param key Key for the pair to remove
- * @param default_value Default value to return if the key does not exist
- * @return char* Value associated with the removed pair, or the default value if the key did not exist
+ * The counter is incremented with probability 1 / ((counter - DICT_LFU_INIT_VAL) * lfuLogFactor + 1),
+ * so 8 bits cover millions of accesses and a one-off scan cannot lift a pair above the hot set.
  */
-char *pop_dict(Dict *self, const char *key, const char *default_value)
+static void lfuTouch_dict(DictCache *cache, KeyValue *pair)
 {
-    char *value = get_dict(self, key);
-    if (value)
-    {
-        removeKey_dict(self, key);
-        return value;
-    }
-    else
+    uint32_t now = lfuClock_dict();
+    unsigned int counter = lfuDecayed_dict(cache, pair->accessTime, now);
+
+    if (counter < 255)
     {
-        return (char *)default_value;
+        double base = counter > DICT_LFU_INIT_VAL ? counter - DICT_LFU_INIT_VAL : 0;
+        double r = (double)(cacheRandom_dict(cache) >> 11) / 9007199254740992.0; // uniform in [0, 1)
+
+        if (r * (base * cache->config.lfuLogFactor + 1) < 1.0)
+            counter++;
     }
+    pair->accessTime = now << 8 | counter;
 }
 
 /**
- * @brief Print all key-value pairs in the dictionary
- * 
- * @param self Pointer to the dictionary to print
+ * @brief Bytes the allocator reserved for a block, including its chunk header where that can be queried
  */
-void print_dict(struct Dict *self)
+static inline size_t allocBytes_dict(const DictCache *cache, void *block, size_t requested)
 {
-    for (int i = 0; i < TABLE_SIZE; i++)
-    {
-        KeyValue *pair = self->buckets_dict[i];
-        while (pair)
-        {
-            printf("%s: %s\n", pair->key, pair->value);
-            pair = pair->next;
-        }
-    }
+#ifdef __GLIBC__
+    if (!cache->requestedBytes)
+        return malloc_usable_size(block) + sizeof(size_t);
+#endif
+    (void)cache;
+    (void)block;
+    return requested;
 }
 
 /**
- * @brief Check if the dictionary is empty
- * 
- * @param self Pointer to the dictionary to check
- * @return bool Boolean indicating whether the dictionary is empty (true) or not (false)
+ * @brief Bytes a pair accounts for against the cache byte budget: node, key, value and expiry timer
  */
-bool isEmpty_dict(Dict* self)
+static size_t pairBytes_dict(const DictCache *cache, KeyValue *pair)
+{
+    size_t bytes = allocBytes_dict(cache, pair, sizeof(KeyValue)) +
+                   allocBytes_dict(cache, pair->key, strlen(pair->key) + 1) +
+                   allocBytes_dict(cache, pair->value, strlen(pair->value) + 1);
+
+    if (pair->timer)
+        bytes += allocBytes_dict(cache, pair->timer, sizeof(WheelTimer));
+    return bytes;
+}
+
+static void lruUnlink_dict(DictCache *cache, KeyValue *pair)
+{
+    if (pair->lruPrev)
+        pair->lruPrev->lruNext = pair->lruNext;
+    else
+        cache->head = pair->lruNext;
+
+    if (pair->lruNext)
+        pair->lruNext->lruPrev = pair->lruPrev;
+    else
+        cache->tail = pair->lruPrev;
+
+    pair->lruPrev = pair->lruNext = NULL;
+}
+
+static void lruPushHead_dict(DictCache *cache, KeyValue *pair)
 {
-    return self->size_dict(self) == 0 ? 1 : 0;
+    pair->lruPrev = NULL;
+    pair->lruNext = cache->head;
+
+    if (cache->head)
+        cache->head->lruPrev = pair;
+    else
+        cache->tail = pair;
+
+    cache->head = pair;
 }
 
 /**
- * @brief Remove a key-value pair from the dictionary and return it as a DictItem, or return NULL if the key does not exist
+ * @brief Make room in the samples array for count more pairs, so that cacheAdd_dict cannot fail
  * 
- * @param self Pointer to the dictionary from which to remove the pair
- * @param key Key for the pair to remove
- * @return DictItem* Pointer to the removed pair as a DictItem, or NULL if the key does not exist
+ * @return bool false if out of memory, leaving the array as it was
  */
-DictItem *popItem_dict(Dict *self, const char *key)
+static bool cacheReserve_dict(Dict *self, DictCache *cache, size_t count)
 {
-    unsigned int idx = self->hash_dict(key);
-    KeyValue **pair = &(self->buckets_dict[idx]);
+    size_t capacity = cache->sampleCapacity ? cache->sampleCapacity : 64;
+    KeyValue **samples;
 
-    while (*pair && strcmp(key, (*pair)->key) != 0)
-        pair = &((*pair)->next);
+    if (cache->config.policy == DICT_EVICT_LRU || cache->sampleCount + count <= cache->sampleCapacity)
+        return true;
 
-    if (*pair)
-    {
-        KeyValue *temp = *pair;
-        DictItem *item = malloc(sizeof(*item));
-        item->key = strdup(temp->key);
-        item->value = strdup(temp->value);
-        *pair = (*pair)->next;
-        free(temp->key);
-        free(temp->value);
-        free(temp);
-        self->size_field_dict--;
-        return item;
-    }
-    return NULL;
+    while (capacity < cache->sampleCount + count)
+        capacity *= 2;
+    samples = memRealloc_dict(self, cache->samples, capacity * sizeof(KeyValue *));
+    if (!samples)
+        return false;
+    cache->samples = samples;
+    cache->sampleCapacity = capacity;
+    return true;
 }
 
 /**
- * @brief Merge two dictionaries, adding key-value pairs from the other dictionary to this one if the key does not exist
- * 
- * @param self Pointer to the dictionary into which to merge the other dictionary
- * @param other Pointer to the dictionary to merge into this one
+ * @brief Start tracking a newly linked pair, after cacheReserve_dict made room for it
  */
-void merge_dict(Dict *self, Dict *other)
+static void cacheAdd_dict(DictCache *cache, KeyValue *pair)
 {
-    char **otherKeys = other->keys_dict(other);
-    int i = 0;
+    pair->cacheBytes = pairBytes_dict(cache, pair);
+    cache->usedBytes += pair->cacheBytes;
 
-    while(otherKeys[i]) 
+    if (cache->config.policy == DICT_EVICT_LRU)
     {
-        if(!self->exists_dict(self, otherKeys[i])) 
-        {
-            char *value = other->get_dict(other, otherKeys[i]);
-            self->insert_dict(self, otherKeys[i], value);
-        }
-
-        i++;
+        lruPushHead_dict(cache, pair);
+        return;
     }
+
+    pair->sampleIndex = cache->sampleCount;
+    cache->samples[cache->sampleCount++] = pair;
+
+    if (cache->config.policy == DICT_EVICT_LFU)
+        pair->accessTime = lfuClock_dict() << 8 | DICT_LFU_INIT_VAL;
+    else
+        pair->accessTime = lruClock_dict();
 }
 
 /**
- * @brief Copy all key-value pairs from a source dictionary to this one, overwriting any existing pairs
- * 
- * @param self Pointer to the dictionary into which to copy the pairs
- * @param source Pointer to the dictionary from which to copy the pairs
+ * @brief Re-measure a pair whose value or timer was reallocated
  */
-void copy_dict(Dict *self, Dict *source)
+static void cacheRecharge_dict(DictCache *cache, KeyValue *pair)
 {
-    // Clear the current dictionary first
-    self->clear_dict(self);
+    cache->usedBytes -= pair->cacheBytes;
+    pair->cacheBytes = pairBytes_dict(cache, pair);
+    cache->usedBytes += pair->cacheBytes;
+}
 
-    for (int i = 0; i < TABLE_SIZE; i++)
+/**
+ * @brief Stop tracking a pair that is about to be freed
+ */
+static void cacheRemove_dict(DictCache *cache, KeyValue *pair)
+{
+    cache->usedBytes -= pair->cacheBytes;
+
+    if (cache->config.policy == DICT_EVICT_LRU)
     {
-        KeyValue *pair = source->buckets_dict[i];
-        while (pair)
-        {
-            self->insert_dict(self, pair->key, pair->value);
-            pair = pair->next;
-        }
+        lruUnlink_dict(cache, pair);
+    }
+    else
+    {
+        // swap the last tracked pair into the hole
+        KeyValue *last = cache->samples[--cache->sampleCount];
+
+        cache->samples[pair->sampleIndex] = last;
+        last->sampleIndex = pair->sampleIndex;
     }
 }
 
 /**
- * @brief Insert a set of keys into the dictionary with the same value for each
- * 
- * @param self Pointer to the dictionary into which to insert the keys
- * @param keys Pointer to an array of keys to insert
- * @param value Value to associate with each key
- * @param numKeys Number of keys in the array
+ * @brief Detach an unlinked pair that is about to be freed from the ordered index, the cache bookkeeping, the Bloom filter and the timer wheel
  */
-void fromKeys_dict(Dict *self, const char **keys, const char *value, int numKeys)
+static void forgetPair_dict(Dict *self, KeyValue *pair)
 {
-    for (int i = 0; i < numKeys; i++)
+    if (self->index_dict)
+        indexRemove_dict(self, pair);
+    if (self->cache_dict)
+        cacheRemove_dict(self->cache_dict, pair);
+    if (self->bloom_dict)
+        bloomRemoved_dict(self, self->bloom_dict);
+
+    if (pair->timer)
     {
-        self->insert_dict(self, keys[i], value);
+        timerWheelCancel(self->wheel_dict, pair->timer);
+        memFree_dict(self, pair->timer);
+        pair->timer = NULL;
     }
 }
 
 /**
- * @brief Create a new dictionary and initialize its functions
- * 
- * @return Dict* Pointer to the newly created dictionary
+ * @brief Record a read of a pair: exact LRU relinks it, sampled LRU only stamps it, LFU bumps its counter
  */
-Dict* createDict()
+static inline void cacheTouch_dict(DictCache *cache, KeyValue *pair)
 {
-    Dict *table = malloc(sizeof(Dict));
-    memset(table, 0, sizeof(Dict));
-
-    table->hash_dict = hash_dict;
-    table->insert_dict = insert_dict;
-    table->get_dict = get_dict;
-    table->removeKey_dict = removeKey_dict;
-    table->size_dict = size_dict;
-    table->exists_dict = exists_dict;
-    table->update_dict = update_dict;
-    table->clear_dict = clear_dict;
-    table->keys_dict = keys_dict;
-    table->values_dict = values_dict;
-    table->items_dict = items_dict;
-    table->loadFactor_dict = loadFactor_dict;
-    table->pop_dict = pop_dict;
-    table->size_field_dict = 0;
-    table->print_dict = print_dict;
-    table->isEmpty_dict = isEmpty_dict;
-    table->popItem_dict = popItem_dict;
-    table->merge_dict = merge_dict;
-    table->copy_dict = copy_dict;
-    table->fromKeys_dict = fromKeys_dict;
-
-    return table;
+    if (cache->config.policy == DICT_EVICT_LRU)
+    {
+        if (cache->head != pair)
+        {
+            lruUnlink_dict(cache, pair);
+            lruPushHead_dict(cache, pair);
+        }
+    }
+    else if (cache->config.policy == DICT_EVICT_LFU)
+    {
+        lfuTouch_dict(cache, pair);
+    }
+    else
+    {
+        pair->accessTime = lruClock_dict();
+    }
+}
+
+/**
+ * @brief Draw count pairs at random, with replacement, from the tracked pairs other than skip
+ * 
+ * Sampling from the dense samples array rather than from random buckets costs O(1) per pair
+ * whatever the load factor, and is not biased by keys whose hashes cluster in a few buckets. A draw
+ * landing on skip steps to the next slot instead.
+ * 
+ * @return int Number of pairs written to out, 0 if no pair other than skip is tracked
+ */
+static int sampleEntries_dict(DictCache *cache, KeyValue **out, int count, const KeyValue *skip)
+{
+    size_t tracked = cache->sampleCount;
+
+    if (tracked == 0 || (tracked == 1 && cache->samples[0] == skip))
+        return 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        size_t index = cacheRandom_dict(cache) % tracked;
+
+        out[i] = cache->samples[index] != skip ? cache->samples[index] : cache->samples[(index + 1) % tracked];
+    }
+    return count;
+}
+
+/**
+ * @brief Pick the pair to evict next, never the one just inserted or updated
+ * 
+ * @return KeyValue* Victim, or NULL only if no pair other than keep is tracked
+ */
+static KeyValue *cacheVictim_dict(DictCache *cache, KeyValue *keep)
+{
+    if (cache->config.policy == DICT_EVICT_LRU)
+    {
+        KeyValue *victim = cache->tail;
+        return victim == keep ? victim->lruPrev : victim;
+    }
+
+    KeyValue *samples[16];
+    int wanted = cache->config.sampleSize;
+    int found = sampleEntries_dict(cache, samples, wanted < 16 ? wanted : 16, keep);
+    bool lfu = cache->config.policy == DICT_EVICT_LFU;
+    uint32_t now = lfu ? lfuClock_dict() : lruClock_dict();
+    KeyValue *victim = NULL;
+    uint32_t best = 0;
+
+    for (int i = 0; i < found; i++)
+    {
+        // higher is a better victim: rarest for LFU, idle longest for LRU (wraps correctly for unsigned clocks)
+        uint32_t score = lfu ? 255 - lfuDecayed_dict(cache, samples[i]->accessTime, now) : now - samples[i]->accessTime;
+
+        if (!victim || score > best)
+        {
+            victim = samples[i];
+            best = score;
+        }
+    }
+
+    // every draw hit keep: any other tracked pair will do, keep is at most one of the first two
+    if (!victim && cache->sampleCount > 1)
+        victim = cache->samples[0] != keep ? cache->samples[0] : cache->samples[1];
+    return victim;
+}
+
+/**
+ * @brief Unlink a pair from its bucket, report it to the eviction callback and free it
+ */
+static void evictPair_dict(Dict *self, DictCache *cache, KeyValue *victim)
+{
+    unlinkPair_dict(self, victim);
+    forgetPair_dict(self, victim);
+    if (cache->config.onEvict)
+        cache->config.onEvict(victim->key, victim->value, cache->config.onEvictCtx);
+
+    freePair_dict(self, victim);
+    self->size_field_dict--;
+    cache->evictions++;
+}
+
+static void freeCache_dict(Dict *self, DictCache *cache)
+{
+    if (cache)
+        memFree_dict(self, cache->samples);
+    memFree_dict(self, cache);
+}
+
+/**
+ * @brief Evict pairs until the dictionary is back within its entry and byte limits
+ * 
+ * @param keep Pair that must survive (the one just written), or NULL
+ */
+static void cacheEnforce_dict(Dict *self, DictCache *cache, KeyValue *keep)
+{
+    while ((cache->config.maxEntries && (size_t)self->size_field_dict > cache->config.maxEntries) ||
+           (cache->config.maxBytes && cache->usedBytes > cache->config.maxBytes))
+    {
+        KeyValue *victim = cacheVictim_dict(cache, keep);
+
+        // only keep is left: a single pair over the limits stays rather than the write being undone
+        if (!victim)
+            break;
+        evictPair_dict(self, cache, victim);
+    }
+}
+
+/**
+ * @brief Check whether a pair's TTL has run out; pairs without a TTL never expire
+ */
+static inline bool expired_dict(const KeyValue *pair)
+{
+    return pair->timer && pair->timer->expireAt <= timerWheelNowMs();
+}
+
+/* Load factor under which removals shrink a resizable table, until setShrinkFloor_dict says otherwise */
+#ifndef DICT_SHRINK_DEFAULT_FLOOR
+#define DICT_SHRINK_DEFAULT_FLOOR 0.10
+#endif
+
+/**
+ * @brief Shrink the engine's table after removals have left it sparser than the dictionary's floor
+ */
+static inline void shrinkIfSparse_dict(Dict *self)
+{
+    const DictEngine *engine = self->engine_dict;
+
+    if (engine->shrink && self->shrinkFloor_dict > 0 &&
+        self->size_field_dict < self->shrinkFloor_dict * (double)engine->slotCount(self))
+        engine->shrink(self, false);
+}
+
+/**
+ * @brief Unlink and free a linked pair
+ */
+static void discardPair_dict(Dict *self, KeyValue *pair)
+{
+    unlinkPair_dict(self, pair);
+    forgetPair_dict(self, pair);
+    freePair_dict(self, pair);
+    self->size_field_dict--;
+}
+
+/**
+ * @brief Unlink and free a pair whose TTL has run out
+ */
+static void dropExpired_dict(Dict *self, KeyValue *pair)
+{
+    discardPair_dict(self, pair);
+    DICT_COUNT(self, removes);
+    shrinkIfSparse_dict(self);
+}
+
+/**
+ * @brief Schedule or reschedule a pair's expiry, creating the timer wheel on first use
+ * 
+ * @param expireAt Absolute expiry time in timerWheelNowMs milliseconds
+ * @return bool false if out of memory, leaving the pair's expiry as it was
+ */
+static bool setTimer_dict(Dict *self, KeyValue *pair, uint64_t expireAt)
+{
+    if (!self->wheel_dict)
+    {
+        TimerWheel *wheel = memAlloc_dict(self, sizeof(TimerWheel));
+
+        if (!wheel)
+            return false;
+        timerWheelInit(wheel, timerWheelNowMs());
+        self->wheel_dict = wheel;
+    }
+
+    if (pair->timer)
+    {
+        timerWheelCancel(self->wheel_dict, pair->timer);
+    }
+    else
+    {
+        WheelTimer *timer = memAlloc_dict(self, sizeof(WheelTimer));
+
+        if (!timer)
+            return false;
+        pair->timer = timer;
+        pair->timer->data = pair;
+        if (self->cache_dict)
+        {
+            cacheRecharge_dict(self->cache_dict, pair);
+            cacheEnforce_dict(self, self->cache_dict, pair);
+        }
+    }
+    timerWheelSchedule(self->wheel_dict, pair->timer, expireAt);
+    return true;
+}
+
+/**
+ * @brief Find a live pair without touching counters, traces or cache recency, dropping it if it has expired
+ */
+static KeyValue *findLive_dict(Dict *self, const char *key)
+{
+    size_t probes;
+    KeyValue *pair = self->engine_dict->find(self, key, &probes);
+
+    if (pair && expired_dict(pair))
+    {
+        dropExpired_dict(self, pair);
+        return NULL;
+    }
+    return pair;
+}
+
+/**
+ * @brief Retrieve a value associated with a given key from the dictionary
+ * 
+ * @param table Pointer to the dictionary from which to retrieve the value
+ * @param key Key for which to retrieve the value
+ * @return char* Value associated with the given key, or NULL if the key does not exist
+ */
+char *get_dict(Dict *table, const char *key)
+{
+    DICT_TRACE(table, DICT_OP_GET, key, NULL);
+    DICT_LATENCY_BEGIN(table);
+    KeyValue *pair = NULL;
+    size_t chain = 0;
+
+    if (table->bloom_dict && bloomExcludes_dict(table->bloom_dict, key))
+    {
+        table->bloom_dict->negatives++;
+    }
+    else
+    {
+        pair = table->engine_dict->find(table, key, &chain);
+
+        if (!pair && table->bloom_dict)
+            table->bloom_dict->falsePositives++;
+    }
+
+    // lazy expiry: a pair past its TTL is reclaimed by the first lookup that sees it
+    if (pair && expired_dict(pair))
+    {
+        dropExpired_dict(table, pair);
+        pair = NULL;
+    }
+
+    DICT_COUNT(table, lookups);
+    DICT_LATENCY_END(table, DICT_OP_GET, key, chain);
+    if (pair)
+    {
+        DICT_COUNT(table, hits);
+        if (table->cache_dict)
+            cacheTouch_dict(table->cache_dict, pair);
+        return pair->value;
+    }
+    DICT_COUNT(table, misses);
+    return NULL;
+}
+
+/**
+ * @brief Link a new pair into the table, behind any pair with the same key, and return it
+ * 
+ * Everything the pair needs is allocated before it is linked, so running out of memory leaves the
+ * dictionary as it was.
+ * 
+ * @return KeyValue* The new pair, or NULL if out of memory
+ */
+static KeyValue *insertPair_dict(Dict *table, const char *key, const char *value)
+{
+    DICT_TRACE(table, DICT_OP_INSERT, key, value);
+    DICT_LATENCY_BEGIN(table);
+    KeyValue *newpair = pair_dict(table, key, value);
+    size_t chain = 0;
+
+    if (!newpair || (table->cache_dict && !cacheReserve_dict(table, table->cache_dict, 1)) ||
+        !table->engine_dict->link(table, newpair, &chain))
+    {
+        if (newpair)
+            freePair_dict(table, newpair);
+        DICT_LATENCY_END(table, DICT_OP_INSERT, key, chain);
+        return NULL;
+    }
+
+    // keeps an earlier duplicate in place
+    if (table->index_dict && radixTreeInsert(table->index_dict, newpair->key, newpair) == RADIX_TREE_NO_MEMORY)
+    {
+        unlinkPair_dict(table, newpair);
+        freePair_dict(table, newpair);
+        DICT_LATENCY_END(table, DICT_OP_INSERT, key, chain);
+        return NULL;
+    }
+
+    table->size_field_dict++;
+    DICT_COUNT(table, inserts);
+    if (table->bloom_dict)
+        bloomAdd_dict(table, table->bloom_dict, key);
+    if (table->cache_dict)
+    {
+        cacheAdd_dict(table->cache_dict, newpair);
+        cacheEnforce_dict(table, table->cache_dict, newpair);
+    }
+    DICT_LATENCY_END(table, DICT_OP_INSERT, key, chain);
+    return newpair;
+}
+
+/**
+ * @brief Insert a new key-value pair into the dictionary
+ * 
+ * @param table Pointer to the dictionary into which to insert the pair
+ * @param key Key for the new pair
+ * @param value Value for the new pair
+ * @return bool false if out of memory, leaving the dictionary unchanged
+ */
+bool insert_dict(Dict *table, const char *key, const char *value)
+{
+    return insertPair_dict(table, key, value) != NULL;
+}
+
+/**
+ * @brief Remove a key-value pair from the dictionary
+ * 
+ * @param table Pointer to the dictionary from which to remove the pair
+ * @param key Key for the pair to remove
+ */
+void removeKey_dict(Dict *table, const char *key)
+{
+    DICT_TRACE(table, DICT_OP_REMOVE, key, NULL);
+    DICT_LATENCY_BEGIN(table);
+    if (table->bloom_dict && bloomExcludes_dict(table->bloom_dict, key))
+    {
+        DICT_LATENCY_END(table, DICT_OP_REMOVE, key, 0);
+        return;
+    }
+
+    size_t chain = 0;
+    KeyValue *temp = table->engine_dict->remove(table, key, &chain);
+
+    if (temp)
+    {
+        forgetPair_dict(table, temp);
+        freePair_dict(table, temp);
+        table->size_field_dict--;
+        DICT_COUNT(table, removes);
+        shrinkIfSparse_dict(table);
+    }
+    DICT_LATENCY_END(table, DICT_OP_REMOVE, key, chain);
+}
+
+/**
+ * @brief Check if a key exists in the dictionary
+ * 
+ * @param table Pointer to the dictionary in which to check for the key
+ * @param key Key for which to check
+ * @return int Boolean indicating whether the key exists (non-zero) or not (zero)
+ */
+int exists_dict(Dict *table, const char *key)
+{
+    return get_dict(table, key) != NULL;
+}
+
+/**
+ * @brief Update the value associated with a given key in the dictionary, or insert a new key-value pair if the key does not exist
+ * 
+ * @param table Pointer to the dictionary in which to update or insert the pair
+ * @param key Key for the pair to update or insert
+ * @param value New value for the pair
+ * @return bool false if out of memory, leaving the old value, or no pair, in place
+ */
+bool update_dict(Dict *table, const char *key, const char *value)
+{
+    DICT_LATENCY_BEGIN(table);
+    size_t chain = 0;
+    bool stored = true;
+    KeyValue *pair = table->engine_dict->find(table, key, &chain);
+
+    if (pair && expired_dict(pair))
+    {
+        dropExpired_dict(table, pair);
+        pair = NULL;
+    }
+
+    if (pair)
+    {
+        char *copy = memStrdup_dict(table, value);
+
+        DICT_TRACE(table, DICT_OP_UPDATE, key, value);
+        if (table->cache_dict)
+            cacheTouch_dict(table->cache_dict, pair);
+        if (copy)
+        {
+            freeValue_dict(table, pair->value);
+            pair->value = copy;
+            if (table->cache_dict)
+            {
+                cacheRecharge_dict(table->cache_dict, pair);
+                cacheEnforce_dict(table, table->cache_dict, pair);
+            }
+        }
+        stored = copy != NULL;
+    }
+    else
+    {
+        // If key does not exist or has expired, insert new key-value pair (traced and timed as the insert it becomes)
+        return insert_dict(table, key, value);
+    }
+    DICT_LATENCY_END(table, DICT_OP_UPDATE, key, chain);
+    return stored;
+}
+
+#ifdef DICT_ENABLE_THREADS
+/**
+ * @brief Free a table detached by detachTable_dict: every pair, the engine's table, the index and the shell
+ */
+static void reclaimTable_dict(const DictAllocator *allocator, void *block)
+{
+    Dict *detached = block;
+
+    (void)allocator; // the shell carries its own copy
+    detached->engine_dict->clear(detached, freePair_dict);
+    detached->engine_dict->destroy(detached);
+    if (detached->index_dict)
+    {
+        radixTreeFree(detached->index_dict);
+        memFree_dict(detached, detached->index_dict);
+    }
+    memFree_dict(detached, detached);
+}
+
+/**
+ * @brief Move the engine's table, with its pairs, and the ordered index into a new shell dictionary
+ * and give the dictionary an empty table
+ * 
+ * The timer wheel, cache lists and Bloom filter still point at the pairs; clear_dict resets them
+ * before the shell may be reclaimed.
+ * 
+ * @param replace false when the dictionary is being destroyed: it is left without a table, which
+ *                its engine must then not destroy, rather than given an empty one only to free it
+ * @return Dict* The shell, or NULL if the table is better cleared inline or memory ran out
+ */
+static Dict *detachTable_dict(Dict *self, bool replace)
+{
+    Dict *detached;
+
+    if (self->size_field_dict < DICT_LAZY_FREE_MIN_PAIRS || self->table_dict == (void *)self->inline_dict)
+        return NULL;
+
+    detached = memCalloc_dict(self, sizeof(Dict));
+    if (!detached)
+        return NULL;
+
+    detached->engine_dict = self->engine_dict;
+    detached->buckets_dict = self->buckets_dict;
+    detached->table_dict = self->table_dict;
+    detached->memory_dict = self->memory_dict;
+    detached->allocator_dict = self->allocator_dict;
+    if (!replace)
+    {
+        self->buckets_dict = NULL;
+        self->table_dict = NULL;
+    }
+    else if (!self->engine_dict->create(self))
+    {
+        self->buckets_dict = detached->buckets_dict;
+        self->table_dict = detached->table_dict;
+        memFree_dict(self, detached);
+        return NULL;
+    }
+
+    // the index only holds pointers into the pairs, so its nodes go along with them
+    if (self->index_dict && (detached->index_dict = memAlloc_dict(self, sizeof(RadixTree))))
+    {
+        *detached->index_dict = *self->index_dict;
+        radixTreeInitWithAllocator(self->index_dict, self->allocator_dict.alloc, self->allocator_dict.free, self->allocator_dict.ctx);
+    }
+    return detached;
+}
+#endif
+
+/**
+ * @brief Clear all key-value pairs from the dictionary
+ * 
+ * @param table Pointer to the dictionary to clear
+ */
+void clear_dict(Dict *table)
+{
+    DICT_TRACE(table, DICT_OP_CLEAR, NULL, NULL);
+    DICT_LATENCY_BEGIN(table);
+    size_t freed = (size_t)table->size_field_dict;
+#ifdef DICT_ENABLE_THREADS
+    Dict *detached = table->lazyFree_dict ? detachTable_dict(table, true) : NULL;
+
+    if (!detached)
+#endif
+        table->engine_dict->clear(table, freePair_dict);
+
+    // Reset size
+    table->size_field_dict = 0;
+    if (table->cache_dict)
+    {
+        table->cache_dict->head = table->cache_dict->tail = NULL;
+        table->cache_dict->sampleCount = 0;
+        table->cache_dict->usedBytes = 0;
+    }
+    // every timer was freed with its pair
+    if (table->wheel_dict)
+        timerWheelInit(table->wheel_dict, timerWheelNowMs());
+    if (table->bloom_dict)
+    {
+        bloomFilterClear(table->bloom_dict->filter);
+        table->bloom_dict->removed = 0;
+    }
+    if (table->index_dict)
+        radixTreeFree(table->index_dict);
+    shrinkIfSparse_dict(table);
+#ifdef DICT_ENABLE_THREADS
+    // only now that nothing of the dictionary points into them any more
+    if (detached && !reclaimLater_dict(table, reclaimTable_dict, detached))
+        reclaimTable_dict(&table->allocator_dict, detached);
+#endif
+    DICT_LATENCY_END(table, DICT_OP_CLEAR, NULL, freed);
+}
+
+#ifdef DICT_ENABLE_THREADS
+/**
+ * @brief Set lazy-free mode, in which large clears and large values are freed by a background thread
+ * 
+ * clear_dict moves the engine's table with all its pairs, and the ordered index, to a detached
+ * dictionary and starts over with an empty table; a single process-wide reclaim thread then frees
+ * the detached one. The caller pays for allocating an empty table instead of one free per node, key
+ * and value. destroyDict hands the table over the same way without making an empty one. Removing or updating a key whose value is at least
+ * DICT_LAZY_FREE_MIN_BYTES hands just that value to the same thread. Tables of fewer than
+ * DICT_LAZY_FREE_MIN_PAIRS pairs, and the inline table of DICT_BACKEND_SMALL, are still cleared inline.
+ * 
+ * The allocator of a dictionary from createDictWithAllocator must be safe to call from the reclaim
+ * thread; in arena mode there is nothing to free and lazy-free mode stays off. Use waitLazyFree_dict
+ * to know when the memory has actually been returned.
+ * 
+ * @param self Pointer to the dictionary to configure
+ * @param enable true to free in the background, false to free inline
+ */
+void setLazyFree_dict(Dict *self, bool enable)
+{
+    self->lazyFree_dict = enable && !(self->allocator_dict.alloc && !self->allocator_dict.free);
+}
+
+/**
+ * @brief Wait until the reclaim thread has freed everything handed to it so far, by any dictionary
+ * 
+ * For tests, benchmarks and leak checkers, and before releasing the state of a custom allocator.
+ */
+void waitLazyFree_dict(void)
+{
+    struct DictReclaimQueue *queue = &reclaimQueue_dict;
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->pending)
+        pthread_cond_wait(&queue->idle, &queue->mutex);
+    pthread_mutex_unlock(&queue->mutex);
+}
+#endif
+
+/**
+ * @brief Free a pair's node, key and value but not its timer, which has moved to the pair's copy
+ */
+static void freeNode_dict(Dict *self, KeyValue *pair)
+{
+    memFree_dict(self, pair->key);
+    memFree_dict(self, pair->value);
+    memFree_dict(self, pair);
+}
+
+/**
+ * @brief Give free heap pages back to the OS, merging the free chunks on the way
+ */
+static void trimHeap_dict(const Dict *self)
+{
+#ifdef __GLIBC__
+    if (!self->allocator_dict.alloc)
+        malloc_trim(0);
+#else
+    (void)self;
+#endif
+}
+
+/**
+ * @brief Repack the dictionary into fresh memory and give what it no longer needs back to the OS
+ * 
+ * After mass removals the surviving pairs are spread thinly over the heap, pinning pages that are
+ * mostly free. The heap is first trimmed, which under glibc merges the free chunks, and every pair
+ * is copied, in table order, out of the merged free space, so that each node, key and value sits
+ * next to the others and walking the table touches neighbouring memory. Only once every copy
+ * exists does each one take the place of its pair, which is then freed; the engine's table is
+ * rebuilt at the size the keys need and the heap trimmed again, malloc_trim returning the pages
+ * the old pairs leave empty, including those in the middle of the heap, with madvise(MADV_DONTNEED).
+ * Tables placed by createDictWithMemory are unmapped as soon as they are replaced.
+ * 
+ * Pairs keep their TTL, cache recency and order among duplicates. Call it after the dictionary has
+ * shrunk a lot, e.g. after a traffic spike: it runs in time proportional to the number of pairs and
+ * needs about as much temporary memory as they take. If that memory cannot be allocated every
+ * pair stays where it was.
+ * 
+ * @param self Pointer to the dictionary to compact
+ * @return true if the pairs were repacked, false in arena mode, whose memory is only released with
+ * the arena, or if memory ran out
+ */
+bool compact_dict(Dict *self)
+{
+    size_t count = (size_t)self->size_field_dict;
+    DictCache *cache = self->cache_dict;
+    bool lru = cache && cache->config.policy == DICT_EVICT_LRU;
+    size_t made = 0;
+    size_t probes;
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    if (self->allocator_dict.alloc && !self->allocator_dict.free)
+        return false;
+
+    KeyValue **pairs = memAlloc_dict(self, (count ? count : 1) * 2 * sizeof(KeyValue *));
+    KeyValue **copies;
+
+    if (!pairs)
+        return false;
+    copies = pairs + count;
+
+    // table order, with duplicates after the pair they follow
+    for (KeyValue *pair = nextPair_dict(self, &cursor); pair; pair = nextPair_dict(self, &cursor))
+        pairs[made++] = pair;
+
+    trimHeap_dict(self);
+    for (made = 0; made < count; made++)
+    {
+        if (!(copies[made] = pair_dict(self, pairs[made]->key, pairs[made]->value)))
+        {
+            while (made-- > 0)
+                freeNode_dict(self, copies[made]);
+            memFree_dict(self, pairs);
+            return false;
+        }
+    }
+
+    // each copy is linked behind its pair, so duplicates keep their order once the pairs are unlinked
+    for (made = 0; made < count; made++)
+    {
+        if (!self->engine_dict->link(self, copies[made], &probes))
+        {
+            while (made-- > 0)
+                self->engine_dict->unlink(self, copies[made]);
+            for (size_t i = 0; i < count; i++)
+                freeNode_dict(self, copies[i]);
+            memFree_dict(self, pairs);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        KeyValue *pair = pairs[i];
+        KeyValue *copy = copies[i];
+
+        copy->timer = pair->timer;
+        if (copy->timer)
+            copy->timer->data = copy;
+        copy->accessTime = pair->accessTime;
+        copy->cacheBytes = pair->cacheBytes;
+        if (lru)
+        {
+            copy->lruPrev = pair->lruPrev;
+            copy->lruNext = pair->lruNext;
+            *(pair->lruPrev ? &pair->lruPrev->lruNext : &cache->head) = copy;
+            *(pair->lruNext ? &pair->lruNext->lruPrev : &cache->tail) = copy;
+        }
+        else if (cache)
+        {
+            copy->sampleIndex = pair->sampleIndex;
+            cache->samples[copy->sampleIndex] = copy;
+        }
+        if (self->index_dict && radixTreeSearch(self->index_dict, pair->key) == pair)
+            radixTreeReplace(self->index_dict, copy->key, copy);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        self->engine_dict->unlink(self, pairs[i]);
+        freeNode_dict(self, pairs[i]);
+    }
+    memFree_dict(self, pairs);
+
+    if (self->engine_dict->shrink)
+        self->engine_dict->shrink(self, true);
+    trimHeap_dict(self);
+    return true;
+}
+
+/**
+ * @brief Set the load factor under which removing keys shrinks the table
+ * 
+ * Applies to the backends whose table grows with the keys, DICT_BACKEND_ROBIN_HOOD and
+ * DICT_BACKEND_CUCKOO; the others have a fixed number of buckets. Once the load falls under floor,
+ * the table is rebuilt at the size that leaves it at most half full at its maximum load. The gap
+ * between the two thresholds is the hysteresis: the keys have to double before the table grows
+ * again, and fall under the floor again before it shrinks, so a workload hovering around either
+ * threshold does not resize back and forth. New dictionaries start with a floor of 0.10.
+ * 
+ * @param self Pointer to the dictionary to configure
+ * @param floor Load factor, keys per slot, below which to shrink; 0 never shrinks
+ */
+void setShrinkFloor_dict(Dict *self, double floor)
+{
+    self->shrinkFloor_dict = floor > 0 ? floor : 0;
+    shrinkIfSparse_dict(self);
+}
+
+/**
+ * @brief Copy the key or the value of every pair into a NULL-terminated array
+ * 
+ * @return char** The array, or NULL if out of memory, in which case nothing stays allocated
+ */
+static char **strings_dict(Dict *table, bool values)
+{
+    int size = size_dict(table);
+    char **strings = memAlloc_dict(table, sizeof(char *) * (size + 1)); // extra space for NULL terminator
+    int index = 0;
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    if (!strings)
+        return NULL;
+
+    for (KeyValue *pair = nextPair_dict(table, &cursor); pair; pair = nextPair_dict(table, &cursor))
+    {
+        if (!(strings[index] = memStrdup_dict(table, values ? pair->value : pair->key)))
+        {
+            while (index > 0)
+                memFree_dict(table, strings[--index]);
+            memFree_dict(table, strings);
+            return NULL;
+        }
+        index++;
+    }
+    strings[index] = NULL; // NULL terminator
+    return strings;
+}
+
+/**
+ * @brief Retrieve a list of all keys in the dictionary
+ * 
+ * @param table Pointer to the dictionary for which to retrieve the keys
+ * @return char** List of all keys in the dictionary, terminated by a NULL pointer, or NULL if out of memory
+ */
+char **keys_dict(Dict *table)
+{
+    DICT_TRACE(table, DICT_OP_KEYS, NULL, NULL);
+    DICT_LATENCY_BEGIN(table);
+    char **keysArray = strings_dict(table, false);
+
+    DICT_LATENCY_END(table, DICT_OP_KEYS, NULL, (size_t)size_dict(table));
+    return keysArray;
+}
+
+/**
+ * @brief Retrieve a list of all values in the dictionary
+ * 
+ * @param table Pointer to the dictionary for which to retrieve the values
+ * @return char** List of all values in the dictionary, terminated by a NULL pointer, or NULL if out of memory
+ */
+char **values_dict(Dict *table)
+{
+    DICT_TRACE(table, DICT_OP_VALUES, NULL, NULL);
+    DICT_LATENCY_BEGIN(table);
+    char **valuesArray = strings_dict(table, true);
+
+    DICT_LATENCY_END(table, DICT_OP_VALUES, NULL, (size_t)size_dict(table));
+    return valuesArray;
+}
+
+/**
+ * @brief Retrieve a list of all items (key-value pairs) in the dictionary
+ * 
+ * @param table Pointer to the dictionary for which to retrieve the items
+ * @return DictItem* List of all items in the dictionary, terminated by a NULL pointer, or NULL if out of memory
+ */
+DictItem *items_dict(Dict *table)
+{
+    DICT_TRACE(table, DICT_OP_ITEMS, NULL, NULL);
+    DICT_LATENCY_BEGIN(table);
+    int size = size_dict(table);
+    DictItem *itemsArray = memAlloc_dict(table, sizeof(DictItem) * (size + 1)); // extra space for NULL terminator
+    int index = 0;
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    for (KeyValue *pair = itemsArray ? nextPair_dict(table, &cursor) : NULL; pair; pair = nextPair_dict(table, &cursor))
+    {
+        itemsArray[index].key = memStrdup_dict(table, pair->key);
+        itemsArray[index].value = memStrdup_dict(table, pair->value);
+        index++;
+        if (!itemsArray[index - 1].key || !itemsArray[index - 1].value)
+        {
+            // out of memory: release everything copied so far
+            while (index > 0)
+            {
+                index--;
+                memFree_dict(table, itemsArray[index].key);
+                memFree_dict(table, itemsArray[index].value);
+            }
+            memFree_dict(table, itemsArray);
+            itemsArray = NULL;
+            break;
+        }
+    }
+    if (itemsArray)
+    {
+        itemsArray[index].key = NULL;   // NULL terminator
+        itemsArray[index].value = NULL; // NULL terminator
+    }
+    DICT_LATENCY_END(table, DICT_OP_ITEMS, NULL, (size_t)index);
+    return itemsArray;
+}
+
+/**
+ * @brief Compute the load factor of the dictionary (number of items / number of buckets or slots)
+ * 
+ * @param table Pointer to the dictionary for which to compute the load factor
+ * @return double Load factor of the dictionary
+ */
+double loadFactor_dict(Dict *table)
+{
+    int size = size_dict(table);
+    return (double)size / table->engine_dict->slotCount(table);
+}
+
+/**
+ * @brief Remove a key-value pair from the dictionary and return its value, or return a default value if the key does not exist
+ * 
+ * @param self Pointer to the dictionary from which to remove the pair
+ * @param key Key for the pair to remove
+ * @param default_value Default value to return if the key does not exist
+ * @return char* Value associated with the removed pair, or the default value if the key did not exist
+ */
+char *pop_dict(Dict *self, const char *key, const char *default_value)
+{
+    char *value = get_dict(self, key);
+    if (value)
+    {
+        removeKey_dict(self, key);
+        return value;
+    }
+    else
+    {
+        return (char *)default_value;
+    }
+}
+
+/**
+ * @brief Print all key-value pairs in the dictionary
+ * 
+ * @param self Pointer to the dictionary to print
+ */
+void print_dict(struct Dict *self)
+{
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    for (KeyValue *pair = nextPair_dict(self, &cursor); pair; pair = nextPair_dict(self, &cursor))
+        printf("%s: %s\n", pair->key, pair->value);
+}
+
+/**
+ * @brief Remove a key-value pair from the dictionary and return it as a DictItem, or return NULL if the key does not exist
+ * 
+ * The item takes over the pair's key and value rather than copying them.
+ * 
+ * @param self Pointer to the dictionary from which to remove the pair
+ * @param key Key for the pair to remove
+ * @return DictItem* Pointer to the removed pair as a DictItem, or NULL if the key does not exist or
+ *                   the item could not be allocated, in which case the pair stays
+ */
+DictItem *popItem_dict(Dict *self, const char *key)
+{
+    DICT_TRACE(self, DICT_OP_POP_ITEM, key, NULL);
+    DICT_LATENCY_BEGIN(self);
+    if (self->bloom_dict && bloomExcludes_dict(self->bloom_dict, key))
+    {
+        DICT_COUNT(self, lookups);
+        DICT_COUNT(self, misses);
+        DICT_LATENCY_END(self, DICT_OP_POP_ITEM, key, 0);
+        return NULL;
+    }
+
+    // allocated up front so that running out of memory cannot lose the pair
+    DictItem *item = memAlloc_dict(self, sizeof(*item));
+    size_t chain = 0;
+    KeyValue *temp = item ? self->engine_dict->remove(self, key, &chain) : NULL;
+
+    DICT_COUNT(self, lookups);
+    if (temp && expired_dict(temp))
+    {
+        // already unlinked: the rest of dropExpired_dict
+        forgetPair_dict(self, temp);
+        freePair_dict(self, temp);
+        self->size_field_dict--;
+        DICT_COUNT(self, removes);
+        DICT_COUNT(self, misses);
+        memFree_dict(self, item);
+        item = NULL;
+    }
+    else if (temp)
+    {
+        forgetPair_dict(self, temp);
+        item->key = temp->key;
+        item->value = temp->value;
+        temp->key = temp->value = NULL;
+        freePair_dict(self, temp);
+        self->size_field_dict--;
+        DICT_COUNT(self, hits);
+        DICT_COUNT(self, removes);
+    }
+    else
+    {
+        DICT_COUNT(self, misses);
+        memFree_dict(self, item);
+        item = NULL;
+    }
+    if (temp)
+        shrinkIfSparse_dict(self);
+    DICT_LATENCY_END(self, DICT_OP_POP_ITEM, key, chain);
+    return item;
+}
+
+/**
+ * @brief Merge two dictionaries, adding key-value pairs from the other dictionary to this one if the key does not exist
+ * 
+ * Out of memory, the keys that could not be added are left out.
+ * 
+ * @param self Pointer to the dictionary into which to merge the other dictionary
+ * @param other Pointer to the dictionary to merge into this one
+ */
+void merge_dict(Dict *self, Dict *other)
+{
+    DICT_LATENCY_BEGIN(self);
+    char **otherKeys = keys_dict(other);
+    int i = 0;
+
+    while(otherKeys && otherKeys[i]) 
+    {
+        if(!exists_dict(self, otherKeys[i])) 
+        {
+            char *value = get_dict(other, otherKeys[i]);
+            insert_dict(self, otherKeys[i], value);
+        }
+
+        memFree_dict(other, otherKeys[i]);
+        i++;
+    }
+    memFree_dict(other, otherKeys);
+    DICT_LATENCY_END(self, DICT_OP_MERGE, NULL, (size_t)i);
+}
+
+/**
+ * @brief Copy all key-value pairs from a source dictionary to this one, overwriting any existing pairs
+ * 
+ * Pairs with a TTL keep the same absolute expiry time in the copy. Out of memory, the pairs that
+ * could not be copied are left out.
+ * 
+ * @param self Pointer to the dictionary into which to copy the pairs
+ * @param source Pointer to the dictionary from which to copy the pairs
+ */
+void copy_dict(Dict *self, Dict *source)
+{
+    DICT_LATENCY_BEGIN(self);
+    // Clear the current dictionary first
+    clear_dict(self);
+
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    for (KeyValue *pair = nextPair_dict(source, &cursor); pair; pair = nextPair_dict(source, &cursor))
+    {
+        KeyValue *copied = insertPair_dict(self, pair->key, pair->value);
+
+        // a copy that could not get its TTL would never expire, so it goes too
+        if (copied && pair->timer && !setTimer_dict(self, copied, pair->timer->expireAt))
+            discardPair_dict(self, copied);
+    }
+    DICT_LATENCY_END(self, DICT_OP_COPY, NULL, (size_t)source->size_field_dict);
+}
+
+/**
+ * @brief Insert a set of keys into the dictionary with the same value for each
+ * 
+ * @param self Pointer to the dictionary into which to insert the keys
+ * @param keys Pointer to an array of keys to insert
+ * @param value Value to associate with each key
+ * @param numKeys Number of keys in the array
+ */
+void fromKeys_dict(Dict *self, const char **keys, const char *value, int numKeys)
+{
+    for (int i = 0; i < numKeys; i++)
+    {
+        insert_dict(self, keys[i], value);
+    }
+}
+
+/**
+ * @brief Collect a structural snapshot of the dictionary: chain lengths, probe costs and memory footprint
+ * 
+ * Walks every bucket or slot once, so the cost is proportional to the table size plus the number of pairs.
+ * 
+ * @param self Pointer to the dictionary to inspect
+ * @param out Pointer to the DictStats structure to fill in
+ */
+void stats_dict(Dict *self, DictStats *out)
+{
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    memset(out, 0, sizeof(*out));
+    self->engine_dict->stats(self, out);
+
+    for (KeyValue *pair = nextPair_dict(self, &cursor); pair; pair = nextPair_dict(self, &cursor))
+    {
+        out->entryCount++;
+        out->keyBytes += strlen(pair->key) + 1;
+        out->valueBytes += strlen(pair->value) + 1;
+        if (pair->timer)
+            out->timerBytes += sizeof(WheelTimer);
+    }
+
+    out->nodeBytes = out->entryCount * sizeof(KeyValue);
+    if (self->wheel_dict)
+        out->timerBytes += sizeof(TimerWheel);
+    if (self->bloom_dict)
+    {
+        unsigned long long absent = self->bloom_dict->negatives + self->bloom_dict->falsePositives;
+
+        out->bloomBytes = sizeof(DictBloom) + sizeof(BloomFilter) + self->bloom_dict->filter->blockCount * BLOOM_BLOCK_BYTES;
+        out->bloomFalsePositiveRate = absent ? (double)self->bloom_dict->falsePositives / absent : 0.0;
+    }
+    if (self->index_dict)
+        out->indexBytes = sizeof(RadixTree) + self->index_dict->bytes;
+    out->totalBytes = out->nodeBytes + out->keyBytes + out->valueBytes + out->bucketBytes + out->timerBytes + out->bloomBytes + out->indexBytes;
+
+#ifdef DICT_ENABLE_COUNTERS
+    out->counters = self->counters_dict;
+#endif
+}
+
+/**
+ * @brief Turn the dictionary into a bounded cache, or back into a plain dictionary
+ * 
+ * Once a limit is set, insert_dict and update_dict evict pairs until the dictionary fits again.
+ * DICT_EVICT_LRU keeps an intrusive recency list: get_dict moves the pair to the front and the
+ * least recently used pair is evicted in O(1). DICT_EVICT_SAMPLED_LRU avoids any list update on
+ * reads, so concurrent readers only store a coarse timestamp into the pair they read; eviction
+ * samples a few pairs uniformly at random and removes the one idle longest. DICT_EVICT_LFU samples
+ * the same way but removes the least frequently used pair, judged by an 8-bit logarithmic counter
+ * that decays while the pair is idle, so one pass over cold keys does not flush the hot set.
+ * The byte limit is checked against what the allocator actually reserved for each pair, or against
+ * the requested sizes for a dictionary with its own allocator.
+ * Pairs already in the dictionary are tracked in bucket order and evicted at once if over the limit.
+ * 
+ * @param self Pointer to the dictionary to configure
+ * @param config Cache parameters, or NULL to leave cache mode
+ * @return bool false if out of memory, leaving the dictionary out of cache mode
+ */
+bool setCacheMode_dict(Dict *self, const DictCacheConfig *config)
+{
+    freeCache_dict(self, self->cache_dict);
+    self->cache_dict = NULL;
+
+    if (!config || config->policy == DICT_EVICT_NONE)
+        return true;
+
+    DictCache *cache = memCalloc_dict(self, sizeof(DictCache));
+    if (!cache)
+        return false;
+    cache->config = *config;
+    cache->requestedBytes = self->allocator_dict.alloc != NULL;
+    if (cache->config.sampleSize <= 0)
+        cache->config.sampleSize = DICT_CACHE_DEFAULT_SAMPLES;
+    if (!cache->config.lfuLogFactor)
+        cache->config.lfuLogFactor = DICT_LFU_DEFAULT_LOG_FACTOR;
+    if (!cache->config.lfuDecaySeconds)
+        cache->config.lfuDecaySeconds = DICT_LFU_DEFAULT_DECAY_SECONDS;
+    cache->rng = (uint64_t)(uintptr_t)self ^ cycleCounter();
+    if (!cache->rng)
+        cache->rng = 0x9E3779B97F4A7C15ull;
+
+    if (!cacheReserve_dict(self, cache, (size_t)self->size_field_dict))
+    {
+        freeCache_dict(self, cache);
+        return false;
+    }
+
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    for (KeyValue *pair = nextPair_dict(self, &cursor); pair; pair = nextPair_dict(self, &cursor))
+        cacheAdd_dict(cache, pair);
+
+    self->cache_dict = cache;
+    cacheEnforce_dict(self, cache, NULL);
+    return true;
+}
+
+/**
+ * @brief Insert a new key-value pair that expires after a time-to-live
+ * 
+ * Expired pairs are invisible to get_dict, exists_dict, update_dict and popItem_dict, which reclaim
+ * them on sight. Pairs nobody looks up again are reclaimed by expireTick_dict; until then they still
+ * count towards size_dict and show up in keys_dict, values_dict and items_dict.
+ * 
+ * @param self Pointer to the dictionary into which to insert the pair
+ * @param key Key for the new pair
+ * @param value Value for the new pair
+ * @param ttlMs Time to live in milliseconds
+ * @return bool false if out of memory, leaving the dictionary without the pair
+ */
+bool insertTTL_dict(Dict *self, const char *key, const char *value, uint64_t ttlMs)
+{
+    KeyValue *pair = insertPair_dict(self, key, value);
+
+    if (!pair)
+        return false;
+    if (!setTimer_dict(self, pair, timerWheelNowMs() + ttlMs))
+    {
+        discardPair_dict(self, pair);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Set or replace the time-to-live of an existing key
+ * 
+ * @param self Pointer to the dictionary holding the key
+ * @param key Key whose expiry to set
+ * @param ttlMs Time to live in milliseconds, counted from now
+ * @return bool false if the key does not exist or has already expired, or if out of memory for its timer
+ */
+bool expire_dict(Dict *self, const char *key, uint64_t ttlMs)
+{
+    KeyValue *pair = findLive_dict(self, key);
+
+    if (!pair)
+        return false;
+
+    return setTimer_dict(self, pair, timerWheelNowMs() + ttlMs);
+}
+
+/**
+ * @brief Remove the time-to-live of a key so that it never expires
+ * 
+ * @param self Pointer to the dictionary holding the key
+ * @param key Key to make persistent
+ * @return bool true if the key existed and had a TTL
+ */
+bool persist_dict(Dict *self, const char *key)
+{
+    KeyValue *pair = findLive_dict(self, key);
+
+    if (!pair || !pair->timer)
+        return false;
+
+    timerWheelCancel(self->wheel_dict, pair->timer);
+    memFree_dict(self, pair->timer);
+    pair->timer = NULL;
+    if (self->cache_dict)
+        cacheRecharge_dict(self->cache_dict, pair);
+    return true;
+}
+
+/**
+ * @brief Retrieve the remaining time-to-live of a key
+ * 
+ * @param self Pointer to the dictionary holding the key
+ * @param key Key to query
+ * @return long long Milliseconds left, -1 if the key has no TTL, -2 if it does not exist
+ */
+long long ttl_dict(Dict *self, const char *key)
+{
+    KeyValue *pair = findLive_dict(self, key);
+
+    if (!pair)
+        return -2;
+    if (!pair->timer)
+        return -1;
+    return (long long)(pair->timer->expireAt - timerWheelNowMs());
+}
+
+/**
+ * @brief Reclaim up to budget expired pairs
+ * 
+ * Advances the timer wheel to the current time and frees the pairs whose timers fired. The wheel
+ * stops advancing once budget timers are due, so each call does work proportional to budget and to
+ * the timers it cascades, never to the size of the table. Call it periodically, e.g. from an event loop.
+ * 
+ * @param self Pointer to the dictionary to reclaim from
+ * @param budget Maximum number of pairs to free
+ * @return size_t Number of pairs freed; a result equal to budget means more may be waiting
+ */
+size_t expireTick_dict(Dict *self, size_t budget)
+{
+    size_t reclaimed = 0;
+    WheelTimer *timer;
+
+    if (!self->wheel_dict || budget == 0)
+        return 0;
+
+    timerWheelAdvance(self->wheel_dict, timerWheelNowMs(), budget);
+    while (reclaimed < budget && (timer = timerWheelPopDue(self->wheel_dict)))
+    {
+        KeyValue *pair = timer->data;
+
+        // already out of the wheel: release the timer here so dropExpired_dict does not cancel it again
+        memFree_dict(self, timer);
+        pair->timer = NULL;
+        dropExpired_dict(self, pair);
+        reclaimed++;
+    }
+    return reclaimed;
+}
+
+/**
+ * @brief Put a Bloom filter in front of the buckets so that most lookups for absent keys skip the chain walk
+ * 
+ * get_dict, exists_dict, removeKey_dict and popItem_dict first probe one cache line of the filter
+ * and only walk the chain if it may contain the key. Inserts add to the filter incrementally; since
+ * bits cannot be cleared, the filter is rebuilt from the live keys when it outgrows its capacity
+ * or after heavy deletes. stats_dict reports its size and measured false-positive rate.
+ * 
+ * @param self Pointer to the dictionary to configure
+ * @param bitsPerKey Filter bits per key, e.g. 10 for about 1% false positives; 0 removes the filter
+ * @return bool false if out of memory, leaving the dictionary without a filter
+ */
+bool setBloomFilter_dict(Dict *self, unsigned int bitsPerKey)
+{
+    freeBloom_dict(self, self->bloom_dict);
+    self->bloom_dict = NULL;
+
+    if (!bitsPerKey)
+        return true;
+
+    DictBloom *bloom = memCalloc_dict(self, sizeof(DictBloom));
+    if (!bloom)
+        return false;
+    bloom->bitsPerKey = bitsPerKey;
+    bloomRebuild_dict(self, bloom);
+
+    if (bloom->filter)
+        self->bloom_dict = bloom;
+    else
+        memFree_dict(self, bloom);
+    return self->bloom_dict != NULL;
+}
+
+/**
+ * @brief Maintain an ordered index of the keys for range_dict and prefix_dict, or drop it
+ * 
+ * The index is an adaptive radix tree updated by every insert and removal, at a cost of O(key length)
+ * per update and one leaf plus a share of an inner node per key. Enabling it indexes the pairs
+ * already in the dictionary.
+ * 
+ * @param self Pointer to the dictionary to configure
+ * @param enable true to build and maintain the index, false to free it
+ * @return bool false if out of memory, leaving the dictionary without an index
+ */
+bool setOrderedIndex_dict(Dict *self, bool enable)
+{
+    if (!enable)
+    {
+        if (self->index_dict)
+            radixTreeFree(self->index_dict);
+        memFree_dict(self, self->index_dict);
+        self->index_dict = NULL;
+        return true;
+    }
+
+    if (self->index_dict)
+        return true;
+
+    RadixTree *index = memAlloc_dict(self, sizeof(RadixTree));
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+
+    if (!index)
+        return false;
+    radixTreeInitWithAllocator(index, self->allocator_dict.alloc, self->allocator_dict.free, self->allocator_dict.ctx);
+    for (KeyValue *pair = nextPair_dict(self, &cursor); pair; pair = nextPair_dict(self, &cursor))
+    {
+        if (radixTreeInsert(index, pair->key, pair) == RADIX_TREE_NO_MEMORY)
+        {
+            radixTreeFree(index);
+            memFree_dict(self, index);
+            return false;
+        }
+    }
+    self->index_dict = index;
+    return true;
+}
+
+typedef struct DictIndexWalk
+{
+    DictVisitor visitor;
+    void *ctx;
+    const GlobMatcher *matcher; /**< Pattern the keys must match, NULL to report every key */
+    uint64_t now; /**< Expiry reference time, 0 to read the clock on the first pair with a TTL */
+    size_t skipped; /**< Expired or non-matching pairs not reported */
+} DictIndexWalk;
+
+/**
+ * @brief Adapt a radix tree leaf to a DictVisitor call, hiding pairs whose TTL has run out or whose key misses the pattern
+ */
+static bool indexVisit_dict(const char *key, void *value, void *ctx)
+{
+    DictIndexWalk *walk = ctx;
+    KeyValue *pair = value;
+
+    if (walk->matcher && !globMatch(walk->matcher, key))
+    {
+        walk->skipped++;
+        return true;
+    }
+    if (pair->timer)
+    {
+        if (!walk->now)
+            walk->now = timerWheelNowMs();
+        if (pair->timer->expireAt <= walk->now)
+        {
+            walk->skipped++;
+            return true;
+        }
+    }
+    return walk->visitor(key, pair->value, walk->ctx);
+}
+
+/**
+ * @brief Visit the pairs whose keys fall in [lo, hi), in strcmp order
+ * 
+ * Requires the ordered index (setOrderedIndex_dict). Only the part of the index between the bounds
+ * is walked, so the cost is the key length plus the number of pairs visited. Expired pairs are skipped.
+ * 
+ * @param self Pointer to the dictionary to iterate
+ * @param lo Smallest key to visit, or NULL to start at the first key
+ * @param hi Key to stop before, or NULL to run to the last key
+ * @param visitor Called for each pair until it returns false
+ * @param ctx User pointer passed to visitor
+ * @return size_t Number of pairs passed to visitor, 0 if the dictionary has no ordered index
+ */
+size_t range_dict(Dict *self, const char *lo, const char *hi, DictVisitor visitor, void *ctx)
+{
+    DictIndexWalk walk = {visitor, ctx, NULL, 0, 0};
+
+    if (!self->index_dict)
+        return 0;
+    return radixTreeRange(self->index_dict, lo, hi, indexVisit_dict, &walk) - walk.skipped;
+}
+
+/**
+ * @brief Visit the pairs whose keys start with prefix, in strcmp order
+ * 
+ * Requires the ordered index (setOrderedIndex_dict). The cost is the prefix length plus the number
+ * of matching pairs, independent of the dictionary size. Expired pairs are skipped.
+ * 
+ * @param self Pointer to the dictionary to iterate
+ * @param prefix Leading characters of the keys to visit; "" visits every pair
+ * @param visitor Called for each pair until it returns false
+ * @param ctx User pointer passed to visitor
+ * @return size_t Number of pairs passed to visitor, 0 if the dictionary has no ordered index
+ */
+size_t prefix_dict(Dict *self, const char *prefix, DictVisitor visitor, void *ctx)
+{
+    DictIndexWalk walk = {visitor, ctx, NULL, 0, 0};
+
+    if (!self->index_dict)
+        return 0;
+    return radixTreePrefix(self->index_dict, prefix, indexVisit_dict, &walk) - walk.skipped;
+}
+
+/**
+ * @brief Visit every live key once, in strcmp order, sorting with up to threads threads
+ */
+static size_t sortedWalk_dict(Dict *self, DictVisitor visitor, void *ctx, int threads)
+{
+    if (self->index_dict)
+        return prefix_dict(self, "", visitor, ctx);
+
+    KeySortItem *items = memAlloc_dict(self, (size_t)size_dict(self) * sizeof(KeySortItem) + 1);
+    DictCursor cursor = {0, SIZE_MAX, NULL, 0};
+    uint64_t now = timerWheelNowMs();
+    size_t count = 0;
+    size_t visited = 0;
+
+    if (!items)
+        return 0;
+
+    // in table order, so that duplicates come after the pair lookups return
+    for (KeyValue *pair = nextPair_dict(self, &cursor); pair; pair = nextPair_dict(self, &cursor))
+    {
+        if (!pair->timer || pair->timer->expireAt > now)
+            items[count++] = (KeySortItem){pair->key, pair};
+    }
+
+    if (keySortWithAllocator(items, count, threads, self->allocator_dict.alloc, self->allocator_dict.free, self->allocator_dict.ctx))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            KeyValue *pair = items[i].value;
+
+            // the sort is stable: the first of equal keys is the one lookups return
+            if (i && strcmp(pair->key, items[i - 1].key) == 0)
+                continue;
+            visited++;
+            if (!visitor(pair->key, pair->value, ctx))
+                break;
+        }
+    }
+    memFree_dict(self, items);
+    return visited;
+}
+
+/**
+ * @brief Visit every pair in strcmp order of the keys, without copying them
+ * 
+ * With the ordered index enabled this walks the index. Otherwise it gathers a pointer to every
+ * pair and sorts the pointers by key with a radix sort (see KeySort.h), which reads the keys in
+ * place, so exporting the whole dictionary in order costs 48 bytes of scratch space per pair, a
+ * 16-byte KeySortItem and the sort's 32, rather than a copy of every key and value. Keys and values are passed as borrowed pointers,
+ * e.g. straight to fprintf for a dump. Expired pairs are skipped, and the dictionary must not be
+ * modified until the call returns.
+ * 
+ * @param self Pointer to the dictionary to export
+ * @param visitor Called for each pair, in key order, until it returns false
+ * @param ctx User pointer passed to visitor
+ * @return size_t Number of pairs passed to visitor, 0 if out of memory
+ */
+size_t sortedItems_dict(Dict *self, DictVisitor visitor, void *ctx)
+{
+    return sortedWalk_dict(self, visitor, ctx, 1);
+}
+
+/**
+ * @struct DictScanRange
+ * @brief A run of slots scanned for keys matching a pattern, by the caller or by one worker thread
+ */
+typedef struct DictScanRange
+{
+    Dict *self;
+    const GlobMatcher *matcher;
+    DictVisitor visitor;
+    void *ctx;
+    size_t begin; /**< First slot */
+    size_t end; /**< Slot to stop before */
+    uint64_t now; /**< Expiry reference time shared by every range */
+    atomic_bool *stop; /**< Set once any visitor returns false */
+    size_t visited; /**< Pairs passed to visitor by this range */
+} DictScanRange;
+
+/**
+ * @brief Report the live pairs in a run of slots whose keys match the pattern
+ */
+static void scanRange_dict(DictScanRange *range)
+{
+    DictCursor cursor = {range->begin, range->end, NULL, 0};
+    size_t slot = SIZE_MAX;
+
+    for (KeyValue *pair = nextPair_dict(range->self, &cursor); pair; pair = nextPair_dict(range->self, &cursor))
+    {
+        if (cursor.slot != slot)
+        {
+            slot = cursor.slot;
+            if (atomic_load_explicit(range->stop, memory_order_relaxed))
+                return;
+        }
+        if (pair->timer && pair->timer->expireAt <= range->now)
+            continue;
+        if (!globMatch(range->matcher, pair->key))
+            continue;
+
+        range->visited++;
+        if (!range->visitor(pair->key, pair->value, range->ctx))
+        {
+            atomic_store_explicit(range->stop, true, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Single-threaded scan for a compiled pattern, through the ordered index when it can prune
+ */
+static size_t scanCompiled_dict(Dict *self, const GlobMatcher *matcher, DictVisitor visitor, void *ctx)
+{
+    if (self->index_dict && matcher->prefixLength)
+    {
+        DictIndexWalk walk = {visitor, ctx, matcher, 0, 0};
+
+        return radixTreePrefix(self->index_dict, matcher->literalPrefix, indexVisit_dict, &walk) - walk.skipped;
+    }
+
+    atomic_bool stop = false;
+    DictScanRange range = {self, matcher, visitor, ctx, 0, SIZE_MAX, timerWheelNowMs(), &stop, 0};
+
+    scanRange_dict(&range);
+    return range.visited;
+}
+
+/**
+ * @brief Visit the pairs whose keys match a glob pattern
+ * 
+ * The pattern supports `*`, `?`, `[a-z]`/`[^a-z]` classes and `\` escapes, and is compiled once
+ * before the scan; matching a key then allocates nothing. When the pattern starts with literal
+ * characters and the ordered index is enabled (setOrderedIndex_dict), only the keys under that
+ * prefix are examined, in strcmp order. Otherwise every bucket is scanned and pairs are visited in
+ * no particular order. Expired pairs are skipped.
+ * 
+ * @param self Pointer to the dictionary to scan
+ * @param pattern Glob the whole key must match, e.g. "user:*:name"
+ * @param visitor Called for each matching pair until it returns false
+ * @param ctx User pointer passed to visitor
+ * @return size_t Number of pairs passed to visitor
+ */
+size_t scanMatch_dict(Dict *self, const char *pattern, DictVisitor visitor, void *ctx)
+{
+    GlobMatcher matcher;
+    size_t visited;
+
+    if (!globCompile(&matcher, pattern))
+        return 0;
+    visited = scanCompiled_dict(self, &matcher, visitor, ctx);
+    globFree(&matcher);
+    return visited;
+}
+
+/**
+ * @struct DictScanStep
+ * @brief State of one scan_dict call, shared by the steps it takes
+ */
+typedef struct DictScanStep
+{
+    DictVisitor visitor;
+    void *ctx;
+    uint64_t now; /**< Expiry reference time, read on the first pair with a timer */
+    size_t visited; /**< Pairs passed to visitor */
+    bool stopped; /**< Set once visitor returns false; later pairs are dropped */
+} DictScanStep;
+
+static void scanEmit_dict(KeyValue *pair, void *ctx)
+{
+    DictScanStep *step = ctx;
+
+    if (step->stopped)
+        return;
+    if (pair->timer)
+    {
+        if (!step->now)
+            step->now = timerWheelNowMs();
+        if (pair->timer->expireAt <= step->now)
+            return;
+    }
+
+    step->visited++;
+    if (!step->visitor(pair->key, pair->value, step->ctx))
+        step->stopped = true;
+}
+
+/**
+ * @brief Visit a slice of the dictionary and return where the next slice starts
+ * 
+ * Start with cursor 0 and pass each returned cursor back until 0 comes back. The dictionary may be
+ * modified between calls: every key present for the whole scan is visited at least once, even
+ * when the table grows or shrinks in between, while keys added or removed during it may or may
+ * not be, and a key can be visited more than once. The resizing backends advance the cursor in
+ * reverse-binary order so that a slot already covered stays covered at any table size.
+ * 
+ * DICT_BACKEND_CUCKOO is the exception: any insert between two calls can displace keys into a
+ * bucket already scanned, and any resize places every key again, so a key present for the whole
+ * scan can be missed whenever the dictionary is modified during it. Only scan a cuckoo dictionary
+ * nobody modifies until the scan ends.
+ * 
+ * Each call visits about count pairs, and looks at no more than 10 * count slots, so it stays
+ * short however sparse the table is. Expired pairs are skipped.
+ * 
+ * @param self Pointer to the dictionary to scan
+ * @param cursor 0 to start a scan, otherwise the value returned by the previous call
+ * @param count Pairs to visit per call, a hint rather than a limit; 0 counts as 1
+ * @param visitor Called for each pair; returning false ends the whole scan
+ * @param ctx User pointer passed to visitor
+ * @return size_t Cursor for the next call, or 0 once the scan is complete or visitor stopped it
+ */
+size_t scan_dict(Dict *self, size_t cursor, size_t count, DictVisitor visitor, void *ctx)
+{
+    DictScanStep step = {visitor, ctx, 0, 0, false};
+    size_t budget;
+
+    if (!count)
+        count = 1;
+    budget = count > SIZE_MAX / 10 ? SIZE_MAX : count * 10;
+
+    do
+    {
+        cursor = self->engine_dict->scan(self, cursor, scanEmit_dict, &step);
+        if (step.stopped)
+            return 0;
+    } while (cursor && step.visited < count && --budget);
+    return cursor;
+}
+
+#ifdef DICT_ENABLE_THREADS
+#define DICT_MAX_SCAN_THREADS 64
+
+static void *scanWorker_dict(void *arg)
+{
+    scanRange_dict(arg);
+    return NULL;
+}
+
+/**
+ * @brief scanMatch_dict split over worker threads, each scanning its own run of buckets
+ * 
+ * Worth it for a full scan of a large dictionary; a pattern that the ordered index can prune is
+ * handed to scanMatch_dict instead. visitor is called from several threads at once and must be
+ * thread-safe, and once one call returns false the others stop at their next bucket. The dictionary
+ * must not be modified until the scan returns.
+ * 
+ * @param self Pointer to the dictionary to scan
+ * @param pattern Glob the whole key must match
+ * @param visitor Called for each matching pair, concurrently, until one call returns false
+ * @param ctx User pointer passed to visitor
+ * @param threads Number of threads including the caller, at most 64
+ * @return size_t Number of pairs passed to visitor
+ */
+size_t scanMatchParallel_dict(Dict *self, const char *pattern, DictVisitor visitor, void *ctx, int threads)
+{
+    GlobMatcher matcher;
+    DictScanRange ranges[DICT_MAX_SCAN_THREADS];
+    pthread_t workers[DICT_MAX_SCAN_THREADS];
+    bool started[DICT_MAX_SCAN_THREADS] = {false};
+    atomic_bool stop = false;
+    uint64_t now = timerWheelNowMs();
+    size_t visited = 0;
+
+    if (!globCompile(&matcher, pattern))
+        return 0;
+
+    // with the index, a literal prefix prunes better than threads can split
+    if (threads <= 1 || (self->index_dict && matcher.prefixLength))
+    {
+        visited = scanCompiled_dict(self, &matcher, visitor, ctx);
+        globFree(&matcher);
+        return visited;
+    }
+    if (threads > DICT_MAX_SCAN_THREADS)
+        threads = DICT_MAX_SCAN_THREADS;
+
+    size_t slots = self->engine_dict->slotCount(self);
+
+    for (int t = 0; t < threads; t++)
+    {
+        ranges[t] = (DictScanRange){self, &matcher, visitor, ctx, slots * t / threads, slots * (t + 1) / threads, now, &stop, 0};
+    }
+
+    // the caller takes range 0; a range whose thread cannot be started runs on the caller too
+    for (int t = 1; t < threads; t++)
+        started[t] = pthread_create(&workers[t], NULL, scanWorker_dict, &ranges[t]) == 0;
+    scanRange_dict(&ranges[0]);
+    for (int t = 1; t < threads; t++)
+    {
+        if (started[t])
+            pthread_join(workers[t], NULL);
+        else
+            scanRange_dict(&ranges[t]);
+    }
+
+    for (int t = 0; t < threads; t++)
+        visited += ranges[t].visited;
+    globFree(&matcher);
+    return visited;
+}
+
+#define DICT_PARALLEL_CHUNKS_PER_THREAD 16
+
+/**
+ * @struct DictParallel
+ * @brief A pass over every slot shared by a team of threads, which claim runs of slots as they go
+ */
+typedef struct DictParallel
+{
+    Dict *self;
+    DictVisitor visitor; /**< Called for each pair by parallelForEach_dict, NULL when folding */
+    DictFoldFn fold; /**< Called for each pair by parallelReduce_dict, NULL when visiting */
+    void *ctx;
+    size_t slots; /**< Slots to cover */
+    size_t chunk; /**< Slots claimed at a time */
+    atomic_size_t nextSlot; /**< First slot not claimed yet */
+    uint64_t now; /**< Expiry reference time shared by every thread */
+    atomic_bool stop; /**< Set once any visitor returns false */
+} DictParallel;
+
+/**
+ * @struct DictParallelShare
+ * @brief One thread's part of a DictParallel pass
+ */
+typedef struct DictParallelShare
+{
+    DictParallel *pass;
+    void *acc; /**< This thread's accumulator when folding */
+    size_t visited; /**< Pairs handled by this thread */
+} DictParallelShare;
+
+/**
+ * @brief Claim runs of slots until none are left, handing their live pairs to the pass's callback
+ *
+ * Claiming small runs from a shared counter balances the load however unevenly the keys are
+ * spread: a thread that drew dense buckets simply claims fewer runs.
+ */
+static void *parallelWorker_dict(void *arg)
+{
+    DictParallelShare *share = arg;
+    DictParallel *pass = share->pass;
+    size_t visited = 0; // counted locally: the shares sit side by side in one array
+    size_t begin;
+
+    while ((begin = atomic_fetch_add_explicit(&pass->nextSlot, pass->chunk, memory_order_relaxed)) < pass->slots &&
+           !atomic_load_explicit(&pass->stop, memory_order_relaxed))
+    {
+        DictCursor cursor = {begin, begin + pass->chunk, NULL, 0};
+
+        for (KeyValue *pair = nextPair_dict(pass->self, &cursor); pair; pair = nextPair_dict(pass->self, &cursor))
+        {
+            if (pair->timer && pair->timer->expireAt <= pass->now)
+                continue;
+
+            visited++;
+            if (pass->fold)
+                pass->fold(share->acc, pair->key, pair->value, pass->ctx);
+            else if (!pass->visitor(pair->key, pair->value, pass->ctx))
+            {
+                atomic_store_explicit(&pass->stop, true, memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    share->visited = visited;
+    return NULL;
+}
+
+/**
+ * @brief Run a pass on the caller and threads - 1 workers
+ *
+ * A worker that cannot be started just claims no slots; the others cover them.
+ */
+static size_t parallelRun_dict(DictParallel *pass, DictParallelShare *shares, int threads)
+{
+    pthread_t workers[DICT_MAX_SCAN_THREADS];
+    bool started[DICT_MAX_SCAN_THREADS] = {false};
+    size_t visited = 0;
+
+    pass->slots = pass->self->engine_dict->slotCount(pass->self);
+    pass->chunk = pass->slots / ((size_t)threads * DICT_PARALLEL_CHUNKS_PER_THREAD);
+    if (!pass->chunk)
+        pass->chunk = 1;
+    pass->now = timerWheelNowMs();
+    atomic_init(&pass->nextSlot, 0);
+    atomic_init(&pass->stop, false);
+
+    for (int t = 1; t < threads; t++)
+        started[t] = pthread_create(&workers[t], NULL, parallelWorker_dict, &shares[t]) == 0;
+    parallelWorker_dict(&shares[0]);
+    for (int t = 1; t < threads; t++)
+    {
+        if (started[t])
+            pthread_join(workers[t], NULL);
+    }
+
+    for (int t = 0; t < threads; t++)
+        visited += shares[t].visited;
+    return visited;
+}
+
+static inline int teamSize_dict(int threads)
+{
+    if (threads < 1)
+        return 1;
+    return threads < DICT_MAX_SCAN_THREADS ? threads : DICT_MAX_SCAN_THREADS;
+}
+
+/**
+ * @brief Visit every pair from several threads at once
+ * 
+ * The slots are handed out in small runs to whichever thread is free, so the threads finish
+ * together even when some buckets are much fuller than others. Keys and values are passed as
+ * borrowed pointers, nothing is copied. visitor is called concurrently and must be thread-safe;
+ * once one call returns false the others stop at the end of their run. Expired pairs are skipped,
+ * and the dictionary must not be modified until the call returns.
+ * 
+ * @param self Pointer to the dictionary to visit
+ * @param threads Number of threads including the caller, at most 64
+ * @param visitor Called for each pair, concurrently, until one call returns false
+ * @param ctx User pointer passed to visitor
+ * @return size_t Number of pairs passed to visitor
+ */
+size_t parallelForEach_dict(Dict *self, int threads, DictVisitor visitor, void *ctx)
+{
+    DictParallel pass = {.self = self, .visitor = visitor, .ctx = ctx};
+    DictParallelShare shares[DICT_MAX_SCAN_THREADS];
+
+    threads = teamSize_dict(threads);
+    for (int t = 0; t < threads; t++)
+        shares[t] = (DictParallelShare){&pass, NULL, 0};
+    return parallelRun_dict(&pass, shares, threads);
+}
+
+/**
+ * @brief Aggregate every pair from several threads at once, without locks
+ * 
+ * Each thread folds the pairs it claims into an accumulator of its own: the caller's thread into
+ * acc, every other thread into a private copy of acc's initial contents, so acc must start out as
+ * the identity of the aggregation (zero for a sum or a histogram). Once all threads are done,
+ * combine merges their accumulators into acc one at a time on the calling thread. The copies are
+ * laid out a cache line apart so that updates from different threads do not contend. The same
+ * rules as parallelForEach_dict apply to the dictionary and to expired pairs.
+ * 
+ * @param self Pointer to the dictionary to aggregate
+ * @param threads Number of threads including the caller, at most 64
+ * @param acc Accumulator holding the identity on entry and the result on return
+ * @param accBytes Size of the accumulator, copied bytewise to each worker thread
+ * @param fold Called for each pair with the accumulator of the calling thread
+ * @param combine Called once per worker thread, after all of them have finished
+ * @param ctx User pointer passed to fold and combine
+ * @return size_t Number of pairs folded, or 0 if the accumulators could not be allocated
+ */
+size_t parallelReduce_dict(Dict *self, int threads, void *acc, size_t accBytes, DictFoldFn fold, DictCombineFn combine, void *ctx)
+{
+    DictParallel pass = {.self = self, .fold = fold, .ctx = ctx};
+    DictParallelShare shares[DICT_MAX_SCAN_THREADS];
+    size_t stride = (accBytes + 63) / 64 * 64;
+    char *copies = NULL;
+    size_t visited;
+
+    threads = teamSize_dict(threads);
+    if (threads > 1 && !(copies = memAlloc_dict(self, stride * (size_t)(threads - 1))))
+        return 0;
+
+    shares[0] = (DictParallelShare){&pass, acc, 0};
+    for (int t = 1; t < threads; t++)
+    {
+        shares[t] = (DictParallelShare){&pass, copies + stride * (size_t)(t - 1), 0};
+        memcpy(shares[t].acc, acc, accBytes);
+    }
+
+    visited = parallelRun_dict(&pass, shares, threads);
+    for (int t = 1; t < threads; t++)
+        combine(acc, shares[t].acc, ctx);
+    memFree_dict(self, copies);
+    return visited;
+}
+
+/**
+ * @brief sortedItems_dict with the sort split over threads
+ * 
+ * From 64K keys on, the keys are split by their leading bytes into independent runs that the
+ * threads sort at once. visitor is still called on the calling thread only, in key order.
+ * 
+ * @param self Pointer to the dictionary to export
+ * @param visitor Called for each pair, in key order, until it returns false
+ * @param ctx User pointer passed to visitor
+ * @param threads Number of threads including the caller, at most 64
+ * @return size_t Number of pairs passed to visitor, 0 if out of memory
+ */
+size_t sortedItemsParallel_dict(Dict *self, DictVisitor visitor, void *ctx, int threads)
+{
+    return sortedWalk_dict(self, visitor, ctx, threads);
+}
+#endif
+
+/**
+ * @struct DictFlight
+ * @brief One load in progress: the first caller runs the loader, later callers for the same key wait on it
+ */
+typedef struct DictFlight
+{
+    char *key;
+    char *value; /**< Copy of the loaded value for the waiters, NULL if the load failed */
+    bool finished;
+    int waiters; /**< Callers blocked on this load; the last one to leave frees the flight */
+#ifdef DICT_ENABLE_THREADS
+    pthread_cond_t done;
+#endif
+    struct DictFlight *next;
+} DictFlight;
+
+/**
+ * @struct DictLoading
+ * @brief State of getOrLoad_dict, allocated by setLoadOptions_dict.
+ */
+typedef struct DictLoading
+{
+#ifdef DICT_ENABLE_THREADS
+    pthread_mutex_t mutex; /**< Serialises every dictionary access made by getOrLoad_dict */
+#endif
+    DictFlight *flights; /**< Loads in progress, a short list */
+    Dict *negative; /**< Keys whose load failed recently, each with a negativeTtlMs TTL, NULL if disabled */
+    uint64_t negativeTtlMs;
+} DictLoading;
+
+static Dict *newDict_dict(DictBackend backend, const DictMemoryPolicy *policy, const DictAllocator *allocator);
+
+static void freeFlight_dict(Dict *self, DictFlight *flight)
+{
+#ifdef DICT_ENABLE_THREADS
+    pthread_cond_destroy(&flight->done);
+#endif
+    memFree_dict(self, flight->key);
+    memFree_dict(self, flight->value);
+    memFree_dict(self, flight);
+}
+
+static void freeLoading_dict(Dict *self, DictLoading *loading)
+{
+    if (!loading)
+        return;
+
+#ifdef DICT_ENABLE_THREADS
+    pthread_mutex_destroy(&loading->mutex);
+#endif
+    destroyDict(loading->negative);
+    memFree_dict(self, loading);
+}
+
+/**
+ * @brief Configure getOrLoad_dict, in particular the caching of failed loads
+ * 
+ * When the library is built with DICT_ENABLE_THREADS, call this before sharing the dictionary
+ * between threads, because getOrLoad_dict would otherwise set up its state lazily without a lock.
+ * Calling it again while loads are in flight is not supported.
+ * 
+ * @param self Pointer to the dictionary to configure
+ * @param negativeTtlMs How long a failed load is remembered, during which getOrLoad_dict returns NULL
+ *                      for that key without calling the loader; 0 disables negative caching
+ * @return bool false if out of memory, in which case getOrLoad_dict sets up its defaults on its next call
+ */
+bool setLoadOptions_dict(Dict *self, uint64_t negativeTtlMs)
+{
+    freeLoading_dict(self, self->loading_dict);
+    self->loading_dict = NULL;
+
+    DictLoading *loading = memCalloc_dict(self, sizeof(DictLoading));
+    if (!loading)
+        return false;
+    loading->negativeTtlMs = negativeTtlMs;
+    if (negativeTtlMs && !(loading->negative = newDict_dict(DICT_BACKEND_SMALL, NULL, &self->allocator_dict)))
+    {
+        memFree_dict(self, loading);
+        return false;
+    }
+#ifdef DICT_ENABLE_THREADS
+    pthread_mutex_init(&loading->mutex, NULL);
+#endif
+
+    self->loading_dict = loading;
+    return true;
+}
+
+#ifdef DICT_ENABLE_THREADS
+#define DICT_LOADING_LOCK(loading) pthread_mutex_lock(&(loading)->mutex)
+#define DICT_LOADING_UNLOCK(loading) pthread_mutex_unlock(&(loading)->mutex)
+#else
+#define DICT_LOADING_LOCK(loading) ((void)0)
+#define DICT_LOADING_UNLOCK(loading) ((void)0)
+#endif
+
+/**
+ * @brief Retrieve a key's value, computing and inserting it with a loader if it is missing
+ * 
+ * Concurrent misses on the same key are coalesced: exactly one caller runs the loader while the
+ * others wait for its result, so an expensive load happens once per key no matter how many threads
+ * miss together. The loader runs without any lock held while other callers use the dictionary, so
+ * it must not touch self at all. Built without DICT_ENABLE_THREADS, there is no locking and the
+ * dictionary must only be used from one thread; the loader may then use it, but loading the key it
+ * was called for returns NULL.
+ * 
+ * With DICT_ENABLE_THREADS, getOrLoad_dict is safe to call from many threads at once, but other
+ * operations on the same dictionary are not synchronised with it.
+ * 
+ * @param self Pointer to the dictionary to read through
+ * @param key Key to look up
+ * @param loader Function computing the value on a miss
+ * @param ctx User pointer passed to the loader
+ * @return char* Value the caller frees, or NULL if the load failed now or, with negative caching,
+ *               within the last negativeTtlMs, or memory ran out. On a hit it is a copy; after a load
+ *               it is the loader's own value, and the dictionary keeps a copy made with update_dict
+ */
+char *getOrLoad_dict(Dict *self, const char *key, DictLoader loader, void *ctx)
+{
+    if (!self->loading_dict && !setLoadOptions_dict(self, 0))
+        return NULL;
+
+    DictLoading *loading = self->loading_dict;
+    DictFlight *flight;
+    char *value;
+
+    DICT_LOADING_LOCK(loading);
+    value = get_dict(self, key);
+    if (value || (loading->negative && get_dict(loading->negative, key)))
+    {
+        value = value ? memStrdup_dict(self, value) : NULL;
+        DICT_LOADING_UNLOCK(loading);
+        return value;
+    }
+
+    for (flight = loading->flights; flight; flight = flight->next)
+    {
+        if (strcmp(flight->key, key) == 0)
+            break;
+    }
+
+    if (flight)
+    {
+#ifdef DICT_ENABLE_THREADS
+        // someone else is loading this key: wait for their result
+        flight->waiters++;
+        while (!flight->finished)
+            pthread_cond_wait(&flight->done, &loading->mutex);
+
+        value = flight->value ? memStrdup_dict(self, flight->value) : NULL;
+        if (--flight->waiters == 0)
+            freeFlight_dict(self, flight);
+#else
+        // single-threaded, so this is the loader asking for its own key
+        value = NULL;
+#endif
+        DICT_LOADING_UNLOCK(loading);
+        return value;
+    }
+
+    flight = memCalloc_dict(self, sizeof(DictFlight));
+    if (flight && !(flight->key = memStrdup_dict(self, key)))
+    {
+        memFree_dict(self, flight);
+        flight = NULL;
+    }
+    if (!flight)
+    {
+        DICT_LOADING_UNLOCK(loading);
+        return NULL;
+    }
+#ifdef DICT_ENABLE_THREADS
+    pthread_cond_init(&flight->done, NULL);
+#endif
+    flight->next = loading->flights;
+    loading->flights = flight;
+    DICT_LOADING_UNLOCK(loading);
+
+    value = loader(key, ctx);
+
+    DICT_LOADING_LOCK(loading);
+    if (value)
+        update_dict(self, key, value);
+    else if (loading->negative)
+    {
+        insertTTL_dict(loading->negative, key, "", loading->negativeTtlMs);
+        expireTick_dict(loading->negative, 8); // reclaim failures nobody asks about again
+    }
+
+    // unlink so that later misses start a new load, then hand the result to the waiters
+    DictFlight **link = &loading->flights;
+    while (*link != flight)
+        link = &(*link)->next;
+    *link = flight->next;
+
+    flight->finished = true;
+    if (flight->waiters)
+    {
+        flight->value = value ? memStrdup_dict(self, value) : NULL;
+#ifdef DICT_ENABLE_THREADS
+        pthread_cond_broadcast(&flight->done);
+#endif
+    }
+    else
+    {
+        freeFlight_dict(self, flight);
+    }
+    DICT_LOADING_UNLOCK(loading);
+
+    return value;
+}
+
+#ifdef DICT_ENABLE_LATENCY
+/**
+ * @brief Turn per-operation latency recording on or off for this dictionary
+ * 
+ * Enabling allocates one histogram per DictOp; disabling frees them along with any slow-operation hook.
+ * 
+ * @param self Pointer to the dictionary to instrument
+ * @param enable true to start recording, false to stop and release the histograms
+ */
+void enableLatency_dict(Dict *self, bool enable)
+{
+    if (enable && !self->latency_dict)
+    {
+        // out of memory, latency recording just stays off
+        self->latency_dict = memCalloc_dict(self, sizeof(DictLatency));
+        if (self->latency_dict)
+            resetLatency_dict(self);
+    }
+    else if (!enable && self->latency_dict)
+    {
+        memFree_dict(self, self->latency_dict);
+        self->latency_dict = NULL;
+    }
+}
+
+/**
+ * @brief Clear all latency histograms, keeping the slow-operation hook
+ * 
+ * @param self Pointer to the dictionary whose histograms to clear
+ */
+void resetLatency_dict(Dict *self)
+{
+    if (!self->latency_dict)
+        return;
+
+    for (int op = 0; op < DICT_OP_COUNT; op++)
+        histogramReset(&self->latency_dict->histograms[op]);
+}
+
+/**
+ * @brief Retrieve the latency histogram of one operation kind
+ * 
+ * @param self Pointer to the dictionary to query
+ * @param op Operation kind
+ * @return const Histogram* Histogram of cycleCounter ticks, or NULL if recording is not enabled
+ */
+const Histogram *latency_dict(Dict *self, DictOp op)
+{
+    return self->latency_dict ? &self->latency_dict->histograms[op] : NULL;
+}
+
+/**
+ * @brief Register a callback for operations slower than a threshold, enabling latency recording if needed
+ * 
+ * @param self Pointer to the dictionary to instrument
+ * @param thresholdCycles Operations taking more cycleCounter ticks than this invoke the hook
+ * @param hook Callback to invoke, or NULL to remove the current one
+ * @param ctx User pointer passed to the hook
+ */
+void setSlowOpHook_dict(Dict *self, uint64_t thresholdCycles, DictSlowOpHook hook, void *ctx)
+{
+    enableLatency_dict(self, true);
+    self->latency_dict->slowThreshold = thresholdCycles;
+    self->latency_dict->slowHook = hook;
+    self->latency_dict->slowHookCtx = ctx;
+}
+#endif
+
+#ifdef DICT_ENABLE_TRACE
+/**
+ * @brief Start recording every operation on this dictionary to a binary trace file
+ * 
+ * Point operations, clear and the keys/values/items listings are recorded with their key and value length.
+ * merge_dict, copy_dict and fromKeys_dict show up as the individual calls they make. A trace already
+ * being recorded is finished first.
+ * 
+ * @param self Pointer to the dictionary to trace
+ * @param path File to write the trace to
+ * @return bool false if the file cannot be created
+ */
+bool startTrace_dict(Dict *self, const char *path)
+{
+    stopTrace_dict(self);
+    self->trace_dict = traceWriterOpen(path);
+    return self->trace_dict != NULL;
+}
+
+/**
+ * @brief Stop recording and close the trace file
+ * 
+ * @param self Pointer to the traced dictionary
+ * @return bool false if buffered records could not be written
+ */
+bool stopTrace_dict(Dict *self)
+{
+    bool ok = traceWriterClose(self->trace_dict);
+
+    self->trace_dict = NULL;
+    return ok;
+}
+#endif
+
+static bool chainCreate_dict(Dict *self)
+{
+    self->buckets_dict = engineAlloc_dict(self, TABLE_SIZE * sizeof(KeyValue *), _Alignof(KeyValue *));
+    return self->buckets_dict != NULL;
+}
+
+static void chainDestroy_dict(Dict *self)
+{
+    engineFree_dict(self, self->buckets_dict, TABLE_SIZE * sizeof(KeyValue *));
+    self->buckets_dict = NULL;
+}
+
+static KeyValue *chainFind_dict(Dict *self, const char *key, size_t *probes)
+{
+    KeyValue *pair = self->buckets_dict[hash_dict(key)];
+    size_t chain = 0;
+
+    while (pair && strcmp(key, pair->key) != 0)
+    {
+        pair = pair->next;
+        chain++;
+    }
+    *probes = chain;
+    return pair;
+}
+
+/**
+ * @brief Append a pair to the end of its bucket chain, so earlier pairs with the same key keep precedence
+ */
+static bool chainLink_dict(Dict *self, KeyValue *pair, size_t *probes)
+{
+    KeyValue **next = &(self->buckets_dict[hash_dict(pair->key)]);
+    size_t chain = 0;
+
+    while (*next)
+    {
+        next = &((*next)->next);
+        chain++;
+    }
+
+    pair->next = NULL;
+    *next = pair;
+    *probes = chain;
+    return true;
+}
+
+static KeyValue *chainRemove_dict(Dict *self, const char *key, size_t *probes)
+{
+    KeyValue **link = &(self->buckets_dict[hash_dict(key)]);
+    size_t chain = 0;
+
+    while (*link && strcmp(key, (*link)->key) != 0)
+    {
+        link = &((*link)->next);
+        chain++;
+    }
+
+    KeyValue *pair = *link;
+    if (pair)
+        *link = pair->next;
+    *probes = chain;
+    return pair;
+}
+
+static void chainUnlink_dict(Dict *self, KeyValue *pair)
+{
+    KeyValue **link = &(self->buckets_dict[hash_dict(pair->key)]);
+
+    while (*link != pair)
+        link = &((*link)->next);
+    *link = pair->next;
+}
+
+static size_t chainSlotCount_dict(const Dict *self)
+{
+    (void)self;
+    return TABLE_SIZE;
+}
+
+static KeyValue *chainNext_dict(const Dict *self, DictCursor *cursor)
+{
+    size_t end = cursor->end < TABLE_SIZE ? cursor->end : TABLE_SIZE;
+
+    if (cursor->pair && cursor->pair->next)
+        return cursor->pair = cursor->pair->next;
+
+    while (cursor->slot < end)
+    {
+        KeyValue *head = self->buckets_dict[cursor->slot++];
+
+        if (head)
+            return cursor->pair = head;
+    }
+    return cursor->pair = NULL;
+}
+
+static void chainClear_dict(Dict *self, void (*release)(Dict *dict, KeyValue *pair))
+{
+    for (int i = 0; i < TABLE_SIZE; i++)
+    {
+        KeyValue *pair = self->buckets_dict[i];
+
+        while (pair)
+        {
+            KeyValue *next = pair->next;
+
+            release(self, pair);
+            pair = next;
+        }
+        self->buckets_dict[i] = NULL;
+    }
+}
+
+static size_t chainScan_dict(const Dict *self, size_t cursor, DictEmit emit, void *ctx)
+{
+    if (cursor >= TABLE_SIZE)
+        return 0;
+    for (KeyValue *pair = self->buckets_dict[cursor]; pair; pair = pair->next)
+        emit(pair, ctx);
+    return cursor + 1 < TABLE_SIZE ? cursor + 1 : 0;
+}
+
+static void chainStats_dict(const Dict *self, DictStats *out)
+{
+    size_t probeSum = 0;
+    size_t entries = 0;
+
+    out->bucketCount = TABLE_SIZE;
+    out->bucketBytes = TABLE_SIZE * sizeof(KeyValue *);
+
+    for (int i = 0; i < TABLE_SIZE; i++)
+    {
+        size_t chain = 0;
+
+        for (KeyValue *pair = self->buckets_dict[i]; pair; pair = pair->next)
+        {
+            chain++;
+            probeSum += chain; // a hit on this pair compares every pair before it, plus itself
+        }
+
+        entries += chain;
+        out->chainHistogram[chain < DICT_STATS_CHAIN_BINS ? chain : DICT_STATS_CHAIN_BINS - 1]++;
+
+        if (chain)
+            out->usedBuckets++;
+        if (chain > out->longestChain)
+            out->longestChain = chain;
+    }
+
+    out->collisions = entries - out->usedBuckets;
+    out->avgProbesHit = entries ? (double)probeSum / entries : 0.0;
+    // A miss walks the whole chain of the bucket it hashes to
+    out->avgProbesMiss = (double)entries / out->bucketCount;
+}
+
+static const DictEngine chainingEngine_dict = {
+    .name = "chaining",
+    .create = chainCreate_dict,
+    .destroy = chainDestroy_dict,
+    .find = chainFind_dict,
+    .link = chainLink_dict,
+    .remove = chainRemove_dict,
+    .unlink = chainUnlink_dict,
+    .slotCount = chainSlotCount_dict,
+    .next = chainNext_dict,
+    .clear = chainClear_dict,
+    .scan = chainScan_dict,
+    .stats = chainStats_dict,
+};
+
+static const DictVTable chainingVTable_dict = {
+    .hash_dict = hash_dict,
+    .insert_dict = insert_dict,
+    .get_dict = get_dict,
+    .removeKey_dict = removeKey_dict,
+    .size_dict = size_dict,
+    .exists_dict = exists_dict,
+    .update_dict = update_dict,
+    .clear_dict = clear_dict,
+    .keys_dict = keys_dict,
+    .values_dict = values_dict,
+    .items_dict = items_dict,
+    .loadFactor_dict = loadFactor_dict,
+    .pop_dict = pop_dict,
+    .print_dict = print_dict,
+    .isEmpty_dict = isEmpty_dict,
+    .popItem_dict = popItem_dict,
+    .merge_dict = merge_dict,
+    .copy_dict = copy_dict,
+    .fromKeys_dict = fromKeys_dict,
+};
+
+/**
+ * @brief Create a new dictionary with the default chaining backend and attach the shared operations table
+ * 
+ * @return Dict* Pointer to the newly created dictionary
+ */
+Dict* createDict()
+{
+    return createDictWithBackend(DICT_BACKEND_CHAINING);
+}
+
+/**
+ * @brief Create a new dictionary that stores its pairs with the given backend
+ * 
+ * Every operation behaves the same whatever the backend; they differ in memory layout, probe
+ * counts and how the table grows. DICT_BACKEND_CHAINING is what createDict uses.
+ * DICT_BACKEND_ROBIN_HOOD starts small and doubles its slot array past 90% load; misses stop as
+ * soon as they reach a slot closer to its home than the key would be.
+ * DICT_BACKEND_CUCKOO keeps every key in one of two cache-line buckets, so a lookup, hit or miss,
+ * never reads more than two; inserts into two full buckets move keys to their other bucket along
+ * the shortest chain found, and the table doubles when there is none.
+ * DICT_BACKEND_BUCKET_VECTOR has the same fixed buckets as chaining, but each keeps its pairs' hash
+ * tags and key pointers in one array, so a lookup scans sequential memory and only dereferences a
+ * pair whose tag matches. The arrays grow by doubling and halve once a quarter full.
+ * DICT_BACKEND_SMALL is for the many dictionaries that only ever hold a handful of keys: creating
+ * one is a single small allocation, and up to 16 distinct keys live inside it, found by comparing
+ * all their one-byte hash tags at once. The 17th key moves them into a DICT_BACKEND_ROBIN_HOOD table.
+ * 
+ * @param backend Storage layout
+ * @return Dict* Pointer to the newly created dictionary, or NULL if out of memory or backend is unknown
+ */
+Dict *createDictWithBackend(DictBackend backend)
+{
+    return createDictWithMemory(backend, NULL);
+}
+
+/**
+ * @brief Create a new dictionary whose table is placed according to a huge-page and NUMA policy
+ * 
+ * For tables large enough that TLB misses or remote-node accesses dominate lookups. Huge pages let
+ * one TLB entry cover 2 MB of buckets instead of 4 KB; interleaving spreads the table over every
+ * node so threads on all sockets see the same average latency, and binding keeps it next to the
+ * threads that use it. Whatever the kernel refuses (no reserved huge pages, an offline node) falls
+ * back to the default without failing.
+ * 
+ * @param backend Storage layout, as for createDictWithBackend
+ * @param policy Placement of the table, or NULL for plain malloc
+ * @return Dict* Pointer to the newly created dictionary, or NULL if out of memory or backend is unknown
+ */
+Dict *createDictWithMemory(DictBackend backend, const DictMemoryPolicy *policy)
+{
+    return newDict_dict(backend, policy, NULL);
+}
+
+/**
+ * @brief Create a new dictionary that takes all its memory from the caller's allocator
+ * 
+ * Pairs, keys, values, timers, cache and loader state, the engine's table, the Bloom filter, the
+ * ordered index, the scratch space of sortedItems_dict, and the arrays, items and strings returned
+ * by keys_dict, values_dict, items_dict, popItem_dict and getOrLoad_dict all come from allocFn, so
+ * free what those return with freeFn. Only the trace writer, which goes through stdio, uses malloc.
+ * 
+ * With freeFn NULL the dictionary never frees a block one by one: removing a key, clearing and
+ * destroying leave its memory to the allocator, which is meant for arenas released as a whole
+ * once the dictionary is destroyed. This makes destroyDict O(1) in the number of pairs.
+ * 
+ * When allocFn returns NULL the operation that needed the memory fails cleanly: insert_dict,
+ * update_dict and insertTTL_dict return false and leave the dictionary as it was, and the
+ * functions returning arrays or items return NULL.
+ * 
+ * @param backend Storage layout, as for createDictWithBackend; DICT_BACKEND_SMALL keeps a
+ *                dictionary of a few keys in a single block of the arena
+ * @param allocFn Returns size bytes, or NULL if out of memory
+ * @param reallocFn Resizes a block from allocFn, as realloc; a NULL block allocates
+ * @param freeFn Releases a block, or NULL for arena mode
+ * @param ctx User pointer passed to each of them
+ * @return Dict* Pointer to the newly created dictionary, or NULL if out of memory, backend is
+ *               unknown or allocFn or reallocFn is missing
+ */
+Dict *createDictWithAllocator(DictBackend backend, DictAllocFn allocFn, DictReallocFn reallocFn, DictFreeFn freeFn, void *ctx)
+{
+    DictAllocator allocator = {allocFn, reallocFn, freeFn, ctx};
+
+    if (!allocFn || !reallocFn)
+        return NULL;
+    return newDict_dict(backend, NULL, &allocator);
+}
+
+/**
+ * @brief Create a dictionary with a backend, a memory policy and an allocator, each optional but the backend
+ */
+static Dict *newDict_dict(DictBackend backend, const DictMemoryPolicy *policy, const DictAllocator *allocator)
+{
+    const DictEngine *engine;
+
+    switch (backend)
+    {
+    case DICT_BACKEND_CHAINING:
+        engine = &chainingEngine_dict;
+        break;
+    case DICT_BACKEND_ROBIN_HOOD:
+        engine = &robinHoodEngine_dict;
+        break;
+    case DICT_BACKEND_CUCKOO:
+        engine = &cuckooEngine_dict;
+        break;
+    case DICT_BACKEND_BUCKET_VECTOR:
+        engine = &bucketVectorEngine_dict;
+        break;
+    case DICT_BACKEND_SMALL:
+        engine = &smallEngine_dict;
+        break;
+    default:
+        return NULL;
+    }
+
+    size_t bytes = sizeof(Dict) + engine->inlineBytes;
+    Dict *table = allocator && allocator->alloc ? allocator->alloc(bytes, allocator->ctx) : malloc(bytes);
+    if (!table)
+        return NULL;
+
+    memset(table, 0, bytes);
+    if (allocator)
+        table->allocator_dict = *allocator;
+    table->vtable = &chainingVTable_dict;
+    table->engine_dict = engine;
+    table->shrinkFloor_dict = DICT_SHRINK_DEFAULT_FLOOR;
+    table->size_field_dict = 0;
+    if (policy)
+        table->memory_dict = *policy;
+    if (!engine->create(table))
+    {
+        memFree_dict(table, table);
+        return NULL;
+    }
+
+    return table;
+}
+
+/**
+ * @brief Free every pair, any instrumentation state and the dictionary itself
+ * 
+ * A dictionary created in arena mode skips the pairs, which go with the arena.
+ * 
+ * @param self Pointer to the dictionary to destroy
+ */
+void destroyDict(Dict *self)
+{
+    if (!self)
+        return;
+
+#ifdef DICT_ENABLE_TRACE
+    stopTrace_dict(self);
+#endif
+#ifdef DICT_ENABLE_THREADS
+    // the table goes to the reclaim thread as it is, without an empty one made only to be freed
+    Dict *detached = self->lazyFree_dict ? detachTable_dict(self, false) : NULL;
+
+    if (!detached)
+#endif
+    if (!self->allocator_dict.alloc || self->allocator_dict.free)
+        clear_dict(self);
+    freeCache_dict(self, self->cache_dict);
+    freeBloom_dict(self, self->bloom_dict);
+    setOrderedIndex_dict(self, false);
+    memFree_dict(self, self->wheel_dict);
+    freeLoading_dict(self, self->loading_dict);
+#ifdef DICT_ENABLE_THREADS
+    // only now that nothing of the dictionary points into the pairs any more
+    if (detached)
+    {
+        if (!reclaimLater_dict(self, reclaimTable_dict, detached))
+            reclaimTable_dict(&self->allocator_dict, detached);
+    }
+    else
+#endif
+        self->engine_dict->destroy(self);
+#ifdef DICT_ENABLE_LATENCY
+    memFree_dict(self, self->latency_dict);
+#endif
+    memFree_dict(self, self);
 }
@@ -0,0 +1,256 @@
+#include "../include/DictEngine.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DICT_BUCKET_VECTOR_MIN_CAPACITY 4
+
+/**
+ * @struct BucketEntry
+ * @brief One pair of a bucket: enough to reject a different key without touching the pair.
+ */
+typedef struct BucketEntry
+{
+    uint32_t tag; /**< High half of engineHash_dict; the low half picked the bucket */
+    const char *key; /**< The pair's key, which never changes while the pair is linked */
+    KeyValue *pair;
+} BucketEntry;
+
+/**
+ * @struct BucketVector
+ * @brief The pairs of one bucket in insertion order, in a single array grown and shrunk with realloc.
+ */
+typedef struct BucketVector
+{
+    BucketEntry *entries; /**< NULL while the bucket is empty */
+    uint32_t count;
+    uint32_t capacity;
+} BucketVector;
+
+static inline uint64_t hash_vector(const char *key)
+{
+    return engineHash_dict(key);
+}
+
+static inline BucketVector *bucket_vector(const Dict *self, uint64_t hash)
+{
+    BucketVector *buckets = self->table_dict;
+
+    return &buckets[(uint32_t)hash % TABLE_SIZE];
+}
+
+static bool create_vector(Dict *self)
+{
+    self->table_dict = engineAlloc_dict(self, TABLE_SIZE * sizeof(BucketVector), _Alignof(BucketVector));
+    return self->table_dict != NULL;
+}
+
+static void destroy_vector(Dict *self)
+{
+    BucketVector *buckets = self->table_dict;
+
+    for (int i = 0; i < TABLE_SIZE; i++)
+        memFree_dict(self, buckets[i].entries);
+    engineFree_dict(self, buckets, TABLE_SIZE * sizeof(BucketVector));
+    self->table_dict = NULL;
+}
+
+/**
+ * @brief Index of the first entry for a key, scanning the tags in order
+ *
+ * @return uint32_t Entry index, or bucket->count if the key is absent
+ */
+static uint32_t locate_vector(const BucketVector *bucket, uint32_t tag, const char *key, size_t *probes)
+{
+    uint32_t i = 0;
+
+    while (i < bucket->count && (bucket->entries[i].tag != tag || strcmp(bucket->entries[i].key, key) != 0))
+        i++;
+    *probes = i;
+    return i;
+}
+
+/**
+ * @brief Drop entry i, keeping the rest in order, and give memory back once the bucket is a quarter full
+ */
+static void erase_vector(const Dict *self, BucketVector *bucket, uint32_t i)
+{
+    bucket->count--;
+    memmove(&bucket->entries[i], &bucket->entries[i + 1], (bucket->count - i) * sizeof(BucketEntry));
+
+    if (!bucket->count)
+    {
+        memFree_dict(self, bucket->entries);
+        bucket->entries = NULL;
+        bucket->capacity = 0;
+    }
+    else if (bucket->capacity > DICT_BUCKET_VECTOR_MIN_CAPACITY && bucket->count * 4 <= bucket->capacity)
+    {
+        BucketEntry *entries = memRealloc_dict(self, bucket->entries, bucket->capacity / 2 * sizeof(BucketEntry));
+
+        if (entries)
+        {
+            bucket->entries = entries;
+            bucket->capacity /= 2;
+        }
+    }
+}
+
+static KeyValue *find_vector(Dict *self, const char *key, size_t *probes)
+{
+    uint64_t hash = hash_vector(key);
+    const BucketVector *bucket = bucket_vector(self, hash);
+    uint32_t i = locate_vector(bucket, (uint32_t)(hash >> 32), key, probes);
+
+    return i < bucket->count ? bucket->entries[i].pair : NULL;
+}
+
+/**
+ * @brief Append a pair to its bucket, so earlier pairs with the same key keep precedence
+ */
+static bool link_vector(Dict *self, KeyValue *pair, size_t *probes)
+{
+    uint64_t hash = hash_vector(pair->key);
+    BucketVector *bucket = bucket_vector(self, hash);
+
+    if (bucket->count == bucket->capacity)
+    {
+        uint32_t capacity = bucket->capacity ? bucket->capacity * 2 : DICT_BUCKET_VECTOR_MIN_CAPACITY;
+        BucketEntry *entries = memRealloc_dict(self, bucket->entries, capacity * sizeof(BucketEntry));
+
+        if (!entries)
+            return false;
+        bucket->entries = entries;
+        bucket->capacity = capacity;
+    }
+
+    pair->next = NULL;
+    bucket->entries[bucket->count++] = (BucketEntry){(uint32_t)(hash >> 32), pair->key, pair};
+    *probes = bucket->count - 1;
+    return true;
+}
+
+static KeyValue *remove_vector(Dict *self, const char *key, size_t *probes)
+{
+    uint64_t hash = hash_vector(key);
+    BucketVector *bucket = bucket_vector(self, hash);
+    uint32_t i = locate_vector(bucket, (uint32_t)(hash >> 32), key, probes);
+    KeyValue *pair;
+
+    if (i == bucket->count)
+        return NULL;
+
+    pair = bucket->entries[i].pair;
+    erase_vector(self, bucket, i);
+    return pair;
+}
+
+static void unlink_vector(Dict *self, KeyValue *pair)
+{
+    BucketVector *bucket = bucket_vector(self, hash_vector(pair->key));
+    uint32_t i = 0;
+
+    while (bucket->entries[i].pair != pair)
+        i++;
+    erase_vector(self, bucket, i);
+}
+
+static size_t slotCount_vector(const Dict *self)
+{
+    (void)self;
+    return TABLE_SIZE;
+}
+
+static KeyValue *next_vector(const Dict *self, DictCursor *cursor)
+{
+    const BucketVector *buckets = self->table_dict;
+    size_t end = cursor->end < TABLE_SIZE ? cursor->end : TABLE_SIZE;
+
+    // cursor->slot is one past the bucket being walked once it has returned a pair
+    if (cursor->pair && cursor->offset < buckets[cursor->slot - 1].count)
+        return cursor->pair = buckets[cursor->slot - 1].entries[cursor->offset++].pair;
+
+    while (cursor->slot < end)
+    {
+        const BucketVector *bucket = &buckets[cursor->slot++];
+
+        if (bucket->count)
+        {
+            cursor->offset = 1;
+            return cursor->pair = bucket->entries[0].pair;
+        }
+    }
+    return cursor->pair = NULL;
+}
+
+static void clear_vector(Dict *self, void (*release)(Dict *dict, KeyValue *pair))
+{
+    BucketVector *buckets = self->table_dict;
+
+    for (int i = 0; i < TABLE_SIZE; i++)
+    {
+        for (uint32_t j = 0; j < buckets[i].count; j++)
+            release(self, buckets[i].entries[j].pair);
+        memFree_dict(self, buckets[i].entries);
+        buckets[i] = (BucketVector){NULL, 0, 0};
+    }
+}
+
+/**
+ * @brief Pass the pairs of one bucket; the buckets are fixed, so they are scanned in order
+ */
+static size_t scan_vector(const Dict *self, size_t cursor, DictEmit emit, void *ctx)
+{
+    const BucketVector *buckets = self->table_dict;
+
+    if (cursor >= TABLE_SIZE)
+        return 0;
+    for (uint32_t i = 0; i < buckets[cursor].count; i++)
+        emit(buckets[cursor].entries[i].pair, ctx);
+    return cursor + 1 < TABLE_SIZE ? cursor + 1 : 0;
+}
+
+static void stats_vector(const Dict *self, DictStats *out)
+{
+    const BucketVector *buckets = self->table_dict;
+    size_t probeSum = 0;
+    size_t entries = 0;
+
+    out->bucketCount = TABLE_SIZE;
+    out->bucketBytes = TABLE_SIZE * sizeof(BucketVector);
+
+    for (int i = 0; i < TABLE_SIZE; i++)
+    {
+        size_t chain = buckets[i].count;
+
+        // a hit on entry j compares the tags of every entry before it, plus its own
+        probeSum += chain * (chain + 1) / 2;
+        entries += chain;
+        out->bucketBytes += buckets[i].capacity * sizeof(BucketEntry);
+        out->chainHistogram[chain < DICT_STATS_CHAIN_BINS ? chain : DICT_STATS_CHAIN_BINS - 1]++;
+
+        if (chain)
+            out->usedBuckets++;
+        if (chain > out->longestChain)
+            out->longestChain = chain;
+    }
+
+    out->collisions = entries - out->usedBuckets;
+    out->avgProbesHit = entries ? (double)probeSum / entries : 0.0;
+    // A miss compares the tag of every entry in the bucket it hashes to
+    out->avgProbesMiss = (double)entries / out->bucketCount;
+}
+
+const DictEngine bucketVectorEngine_dict = {
+    .name = "bucket_vector",
+    .create = create_vector,
+    .destroy = destroy_vector,
+    .find = find_vector,
+    .link = link_vector,
+    .remove = remove_vector,
+    .unlink = unlink_vector,
+    .slotCount = slotCount_vector,
+    .next = next_vector,
+    .clear = clear_vector,
+    .scan = scan_vector,
+    .stats = stats_vector,
+};
@@ -0,0 +1,528 @@
+#include "../include/DictEngine.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DICT_CUCKOO_WAYS 4 /* slots per bucket: 4 x 16 bytes, one cache line */
+#define DICT_CUCKOO_MIN_BUCKETS 4
+#define DICT_CUCKOO_MAX_SEARCH 512 /* buckets one displacement search may visit before the table grows */
+#define DICT_CUCKOO_MAX_REBUILDS 8 /* attempts of one resize, each with a new seed, doubling every other one */
+
+/**
+ * @struct CuckooSlot
+ * @brief A key's first pair and its full hash, which serves both as fingerprint and to find the key's other bucket.
+ */
+typedef struct CuckooSlot
+{
+    uint64_t hash; /**< Seeded hash of the key, see hash_cuckoo */
+    KeyValue *pair; /**< First pair with this key, NULL if the slot is empty; later duplicates follow through KeyValue::next */
+} CuckooSlot;
+
+/**
+ * @struct CuckooBucket
+ * @brief One cache line of slots.
+ */
+typedef struct CuckooBucket
+{
+    CuckooSlot slots[DICT_CUCKOO_WAYS];
+} CuckooBucket;
+
+/**
+ * @struct CuckooTable
+ * @brief Every key lives in one of its two buckets, so a lookup reads at most two cache lines.
+ */
+typedef struct CuckooTable
+{
+    CuckooBucket *buckets; /**< Cache-line aligned */
+    size_t mask; /**< Number of buckets - 1; the number of buckets is a power of two */
+    size_t used; /**< Occupied slots, one per distinct key */
+    uint64_t seed; /**< Per-table hash seed, drawn again when the keys do not fit */
+} CuckooTable;
+
+/**
+ * @struct CuckooStep
+ * @brief Node of the breadth-first displacement search: a bucket reached by moving one key out of its parent.
+ */
+typedef struct CuckooStep
+{
+    size_t bucket;
+    int parent; /**< Index of the parent step, -1 for the key's own buckets */
+    int way; /**< Slot of the parent whose key would move into this bucket */
+} CuckooStep;
+
+/**
+ * @brief Hash of a key for one table
+ *
+ * Both buckets come from the one hash, so keys whose hashes are equal share both buckets and more
+ * than twice DICT_CUCKOO_WAYS of them cannot be placed at any size. A new seed separates them.
+ */
+static inline uint64_t hash_cuckoo(const CuckooTable *table, const char *key)
+{
+    return engineSeededHash_dict(key, table->seed);
+}
+
+static inline size_t primary_cuckoo(const CuckooTable *table, uint64_t hash)
+{
+    return (size_t)hash & table->mask;
+}
+
+static inline size_t alternate_cuckoo(const CuckooTable *table, uint64_t hash)
+{
+    return (size_t)(hash >> 32) & table->mask;
+}
+
+/**
+ * @brief The bucket a key in the given one of its buckets could move to
+ */
+static inline size_t other_cuckoo(const CuckooTable *table, size_t bucket, uint64_t hash)
+{
+    size_t first = primary_cuckoo(table, hash);
+
+    return bucket == first ? alternate_cuckoo(table, hash) : first;
+}
+
+static CuckooBucket *allocBuckets_cuckoo(const Dict *self, size_t count)
+{
+    return engineAlloc_dict(self, count * sizeof(CuckooBucket), sizeof(CuckooBucket));
+}
+
+static bool create_cuckoo(Dict *self)
+{
+    CuckooTable *table = memAlloc_dict(self, sizeof(CuckooTable));
+
+    if (!table)
+        return false;
+
+    table->buckets = allocBuckets_cuckoo(self, DICT_CUCKOO_MIN_BUCKETS);
+    if (!table->buckets)
+    {
+        memFree_dict(self, table);
+        return false;
+    }
+    table->mask = DICT_CUCKOO_MIN_BUCKETS - 1;
+    table->used = 0;
+    table->seed = (uint64_t)(uintptr_t)table ^ cycleCounter();
+    self->table_dict = table;
+    return true;
+}
+
+static void destroy_cuckoo(Dict *self)
+{
+    CuckooTable *table = self->table_dict;
+
+    engineFree_dict(self, table->buckets, (table->mask + 1) * sizeof(CuckooBucket));
+    memFree_dict(self, table);
+    self->table_dict = NULL;
+}
+
+static inline int freeWay_cuckoo(const CuckooBucket *bucket)
+{
+    for (int w = 0; w < DICT_CUCKOO_WAYS; w++)
+    {
+        if (!bucket->slots[w].pair)
+            return w;
+    }
+    return -1;
+}
+
+static bool queued_cuckoo(const CuckooStep *queue, int count, size_t bucket)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (queue[i].bucket == bucket)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Free a slot in one of a new key's two buckets by moving keys to their other buckets
+ *
+ * Searches breadth-first for the shortest chain of moves that ends in a bucket with a free slot,
+ * then performs the moves from the end of the chain back, so every key stays findable throughout.
+ * No bucket is visited twice, which keeps the moves on a chain from overlapping.
+ *
+ * @param bucket Receives the bucket of the freed slot
+ * @return int Freed slot, or -1 if no chain was found within DICT_CUCKOO_MAX_SEARCH buckets
+ */
+static int displace_cuckoo(CuckooTable *table, size_t first, size_t second, size_t *bucket)
+{
+    CuckooStep queue[DICT_CUCKOO_MAX_SEARCH];
+    int head = 0;
+    int tail = 0;
+
+    queue[tail++] = (CuckooStep){first, -1, -1};
+    if (second != first)
+        queue[tail++] = (CuckooStep){second, -1, -1};
+
+    while (head < tail)
+    {
+        int current = head++;
+        const CuckooBucket *from = &table->buckets[queue[current].bucket];
+
+        for (int w = 0; w < DICT_CUCKOO_WAYS; w++)
+        {
+            size_t target = other_cuckoo(table, queue[current].bucket, from->slots[w].hash);
+            int free = freeWay_cuckoo(&table->buckets[target]);
+
+            if (free < 0)
+            {
+                if (tail < DICT_CUCKOO_MAX_SEARCH && !queued_cuckoo(queue, tail, target))
+                    queue[tail++] = (CuckooStep){target, current, w};
+                continue;
+            }
+
+            // shift each key on the chain one step forward, last move first
+            CuckooSlot *dst = &table->buckets[target].slots[free];
+            int node = current;
+            int way = w;
+
+            for (;;)
+            {
+                CuckooSlot *src = &table->buckets[queue[node].bucket].slots[way];
+
+                *dst = *src;
+                dst = src;
+                if (queue[node].parent < 0)
+                    break;
+                way = queue[node].way;
+                node = queue[node].parent;
+            }
+            dst->pair = NULL;
+            *bucket = queue[node].bucket;
+            return way;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Store a key that is not in the table yet
+ *
+ * @return bool false if neither bucket has room and no displacement chain was found
+ */
+static bool place_cuckoo(CuckooTable *table, uint64_t hash, KeyValue *pair)
+{
+    size_t first = primary_cuckoo(table, hash);
+    size_t second = alternate_cuckoo(table, hash);
+    size_t bucket = first;
+    int way = freeWay_cuckoo(&table->buckets[first]);
+
+    if (way < 0)
+    {
+        bucket = second;
+        way = freeWay_cuckoo(&table->buckets[second]);
+    }
+    if (way < 0)
+        way = displace_cuckoo(table, first, second, &bucket);
+    if (way < 0)
+        return false;
+
+    table->buckets[bucket].slots[way] = (CuckooSlot){hash, pair};
+    table->used++;
+    return true;
+}
+
+/**
+ * @brief Move every key, and a pending new one, into a fresh table of at least count buckets
+ *
+ * When a key does not fit, the table is built again with a new seed, and every other time at twice
+ * the size, at most DICT_CUCKOO_MAX_REBUILDS times: keys that collide under one seed are unlikely
+ * to under the next, and with no limit a handful of keys sharing a hash would double the table
+ * until memory ran out.
+ *
+ * @param pending Key not in the table yet to place along with the others, NULL for none
+ * @return bool false if out of memory or no attempt placed every key, in which case the table is unchanged
+ */
+static bool resize_cuckoo(const Dict *self, CuckooTable *table, size_t count, KeyValue *pending)
+{
+    CuckooTable grown = *table;
+    size_t oldCount = table->mask + 1;
+
+    for (int attempt = 0;; attempt++)
+    {
+        bool placed = true;
+
+        if (attempt == DICT_CUCKOO_MAX_REBUILDS)
+            return false;
+        if (attempt)
+        {
+            grown.seed = grown.seed * 0x9E3779B97F4A7C15ull + cycleCounter();
+            if (attempt % 2 == 0)
+                count *= 2;
+        }
+
+        grown.buckets = allocBuckets_cuckoo(self, count);
+        grown.mask = count - 1;
+        grown.used = 0;
+        if (!grown.buckets)
+            return false;
+
+        for (size_t b = 0; b < oldCount && placed; b++)
+        {
+            for (int w = 0; w < DICT_CUCKOO_WAYS && placed; w++)
+            {
+                const CuckooSlot *slot = &table->buckets[b].slots[w];
+
+                if (slot->pair)
+                    placed = place_cuckoo(&grown, grown.seed == table->seed ? slot->hash : hash_cuckoo(&grown, slot->pair->key), slot->pair);
+            }
+        }
+        if (placed && pending)
+            placed = place_cuckoo(&grown, hash_cuckoo(&grown, pending->key), pending);
+        if (placed)
+            break;
+        engineFree_dict(self, grown.buckets, count * sizeof(CuckooBucket));
+    }
+
+    engineFree_dict(self, table->buckets, oldCount * sizeof(CuckooBucket));
+    *table = grown;
+    return true;
+}
+
+/**
+ * @brief Find the slot of a key, reading at most its two buckets
+ *
+ * Both buckets are prefetched up front so that, when the key is not in the first one, the two
+ * cache misses overlap instead of following each other.
+ */
+static CuckooSlot *locate_cuckoo(const CuckooTable *table, const char *key, size_t *probes)
+{
+    uint64_t hash = hash_cuckoo(table, key);
+    CuckooBucket *first = &table->buckets[primary_cuckoo(table, hash)];
+    CuckooBucket *second = &table->buckets[alternate_cuckoo(table, hash)];
+
+    __builtin_prefetch(second);
+    for (int w = 0; w < DICT_CUCKOO_WAYS; w++)
+    {
+        CuckooSlot *slot = &first->slots[w];
+
+        if (slot->pair && slot->hash == hash && strcmp(slot->pair->key, key) == 0)
+        {
+            *probes = 0;
+            return slot;
+        }
+    }
+
+    *probes = 1;
+    if (second == first)
+        return NULL;
+    for (int w = 0; w < DICT_CUCKOO_WAYS; w++)
+    {
+        CuckooSlot *slot = &second->slots[w];
+
+        if (slot->pair && slot->hash == hash && strcmp(slot->pair->key, key) == 0)
+            return slot;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Drop the first pair of a slot; its next duplicate takes the slot over if there is one
+ */
+static void detach_cuckoo(CuckooTable *table, CuckooSlot *slot)
+{
+    slot->pair = slot->pair->next;
+    if (!slot->pair)
+        table->used--;
+}
+
+static KeyValue *find_cuckoo(Dict *self, const char *key, size_t *probes)
+{
+    CuckooSlot *slot = locate_cuckoo(self->table_dict, key, probes);
+
+    return slot ? slot->pair : NULL;
+}
+
+static bool link_cuckoo(Dict *self, KeyValue *pair, size_t *probes)
+{
+    CuckooTable *table = self->table_dict;
+    CuckooSlot *slot = locate_cuckoo(table, pair->key, probes);
+
+    pair->next = NULL;
+    if (slot)
+    {
+        KeyValue *last = slot->pair;
+
+        while (last->next)
+            last = last->next;
+        last->next = pair;
+        return true;
+    }
+
+    // a full table is rebuilt with the key placed in it, at twice the size
+    return place_cuckoo(table, hash_cuckoo(table, pair->key), pair) ||
+           resize_cuckoo(self, table, (table->mask + 1) * 2, pair);
+}
+
+static KeyValue *remove_cuckoo(Dict *self, const char *key, size_t *probes)
+{
+    CuckooTable *table = self->table_dict;
+    CuckooSlot *slot = locate_cuckoo(table, key, probes);
+    KeyValue *pair;
+
+    if (!slot)
+        return NULL;
+
+    pair = slot->pair;
+    detach_cuckoo(table, slot);
+    return pair;
+}
+
+static void unlink_cuckoo(Dict *self, KeyValue *pair)
+{
+    CuckooTable *table = self->table_dict;
+    size_t probes;
+    CuckooSlot *slot = locate_cuckoo(table, pair->key, &probes);
+    KeyValue **link = &slot->pair;
+
+    if (*link == pair)
+    {
+        detach_cuckoo(table, slot);
+        return;
+    }
+
+    while (*link != pair)
+        link = &((*link)->next);
+    *link = pair->next;
+}
+
+static size_t slotCount_cuckoo(const Dict *self)
+{
+    const CuckooTable *table = self->table_dict;
+
+    return (table->mask + 1) * DICT_CUCKOO_WAYS;
+}
+
+static KeyValue *next_cuckoo(const Dict *self, DictCursor *cursor)
+{
+    const CuckooTable *table = self->table_dict;
+    size_t count = (table->mask + 1) * DICT_CUCKOO_WAYS;
+    size_t end = cursor->end < count ? cursor->end : count;
+
+    if (cursor->pair && cursor->pair->next)
+        return cursor->pair = cursor->pair->next;
+
+    while (cursor->slot < end)
+    {
+        size_t slot = cursor->slot++;
+        KeyValue *head = table->buckets[slot / DICT_CUCKOO_WAYS].slots[slot % DICT_CUCKOO_WAYS].pair;
+
+        if (head)
+            return cursor->pair = head;
+    }
+    return cursor->pair = NULL;
+}
+
+static void clear_cuckoo(Dict *self, void (*release)(Dict *dict, KeyValue *pair))
+{
+    CuckooTable *table = self->table_dict;
+
+    for (size_t b = 0; b <= table->mask; b++)
+    {
+        for (int w = 0; w < DICT_CUCKOO_WAYS; w++)
+        {
+            KeyValue *pair = table->buckets[b].slots[w].pair;
+
+            while (pair)
+            {
+                KeyValue *next = pair->next;
+
+                release(self, pair);
+                pair = next;
+            }
+        }
+    }
+    memset(table->buckets, 0, (table->mask + 1) * sizeof(CuckooBucket));
+    table->used = 0;
+}
+
+/**
+ * @brief Size the table so that at most half its slots are used, where displacement chains are short
+ * and rarely fail, leaving room to double the keys before it grows again
+ */
+static bool shrink_cuckoo(Dict *self, bool always)
+{
+    CuckooTable *table = self->table_dict;
+    size_t count = DICT_CUCKOO_MIN_BUCKETS;
+
+    while (table->used * 2 > count * DICT_CUCKOO_WAYS)
+        count *= 2;
+    if (count > table->mask + 1)
+        count = table->mask + 1; // more than half full: only ever shrink here
+    if (count == table->mask + 1 && !always)
+        return false;
+    return resize_cuckoo(self, table, count, NULL);
+}
+
+/**
+ * @brief Pass the keys of the cursor's bucket
+ *
+ * A key that stays in the same one of its two buckets keeps the guarantee of scanNext_dict, but
+ * inserts that displace keys, and resizes that place each key again, can move a key from a bucket
+ * not scanned yet to one already scanned, and such a key is missed.
+ */
+static size_t scan_cuckoo(const Dict *self, size_t cursor, DictEmit emit, void *ctx)
+{
+    const CuckooTable *table = self->table_dict;
+    const CuckooBucket *bucket = &table->buckets[cursor & table->mask];
+
+    for (int w = 0; w < DICT_CUCKOO_WAYS; w++)
+    {
+        for (KeyValue *pair = bucket->slots[w].pair; pair; pair = pair->next)
+            emit(pair, ctx);
+    }
+    return scanNext_dict(cursor, table->mask);
+}
+
+static void stats_cuckoo(const Dict *self, DictStats *out)
+{
+    const CuckooTable *table = self->table_dict;
+    size_t secondary = 0;
+
+    out->bucketCount = (table->mask + 1) * DICT_CUCKOO_WAYS;
+    out->bucketBytes = (table->mask + 1) * sizeof(CuckooBucket);
+    out->usedBuckets = table->used;
+
+    for (size_t b = 0; b <= table->mask; b++)
+    {
+        for (int w = 0; w < DICT_CUCKOO_WAYS; w++)
+        {
+            const CuckooSlot *slot = &table->buckets[b].slots[w];
+
+            if (!slot->pair)
+            {
+                out->chainHistogram[0]++;
+                continue;
+            }
+
+            // bin 1: found in the first bucket read, bin 2: needed the second
+            bool inSecond = b != primary_cuckoo(table, slot->hash);
+            out->chainHistogram[inSecond ? 2 : 1]++;
+            secondary += inSecond;
+            for (KeyValue *duplicate = slot->pair->next; duplicate; duplicate = duplicate->next)
+                out->collisions++; // shadowed by the first pair, never found by a lookup
+        }
+    }
+
+    out->collisions += secondary;
+    out->longestChain = secondary ? 2 : table->used ? 1 : 0;
+    // probes are counted in buckets read; a miss always reads both
+    out->avgProbesHit = table->used ? (double)(table->used + secondary) / table->used : 0.0;
+    out->avgProbesMiss = 2.0;
+}
+
+const DictEngine cuckooEngine_dict = {
+    .name = "cuckoo",
+    .create = create_cuckoo,
+    .destroy = destroy_cuckoo,
+    .find = find_cuckoo,
+    .link = link_cuckoo,
+    .remove = remove_cuckoo,
+    .unlink = unlink_cuckoo,
+    .slotCount = slotCount_cuckoo,
+    .next = next_cuckoo,
+    .clear = clear_cuckoo,
+    .shrink = shrink_cuckoo,
+    .scan = scan_cuckoo,
+    .stats = stats_cuckoo,
+};
@@ -0,0 +1,171 @@
+#define _GNU_SOURCE /* MAP_ANONYMOUS, MAP_HUGETLB, MADV_HUGEPAGE, syscall */
+#include "../include/DictEngine.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define DICT_HUGE_PAGE_BYTES ((size_t)2 << 20)
+
+/* Tables smaller than this come from malloc whatever the policy, so that many small dictionaries
+ * do not each round a few hundred bytes up to a whole huge page */
+#define DICT_MAPPED_MIN_BYTES (DICT_HUGE_PAGE_BYTES / 2)
+
+/* Memory policy modes of the mbind system call, from linux/mempolicy.h */
+#define DICT_MPOL_BIND 2
+#define DICT_MPOL_INTERLEAVE 3
+
+/**
+ * @brief Whether a table of the given size is mapped directly rather than taken from malloc
+ */
+static inline bool mapped_dict(const Dict *self, size_t bytes)
+{
+#ifdef __linux__
+    return !self->allocator_dict.alloc && bytes >= DICT_MAPPED_MIN_BYTES &&
+           (self->memory_dict.hugePages != DICT_HUGE_PAGES_OFF || self->memory_dict.numa != DICT_NUMA_DEFAULT);
+#else
+    (void)self;
+    (void)bytes;
+    return false;
+#endif
+}
+
+#ifdef __linux__
+/**
+ * @brief Length of the mapping for a table: whole huge pages when they are wanted, whole pages otherwise
+ */
+static size_t mapBytes_dict(const Dict *self, size_t bytes)
+{
+    size_t page = self->memory_dict.hugePages != DICT_HUGE_PAGES_OFF ? DICT_HUGE_PAGE_BYTES : (size_t)sysconf(_SC_PAGESIZE);
+
+    return (bytes + page - 1) / page * page;
+}
+
+/**
+ * @brief Anonymous mapping of length bytes starting on a huge-page boundary, so that the kernel can
+ * back all of it with transparent huge pages
+ */
+static void *mapAligned_dict(size_t length)
+{
+    char *base = mmap(NULL, length + DICT_HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    char *start;
+
+    if (base == MAP_FAILED)
+        return NULL;
+
+    start = (char *)(((uintptr_t)base + DICT_HUGE_PAGE_BYTES - 1) & ~(uintptr_t)(DICT_HUGE_PAGE_BYTES - 1));
+    if (start > base)
+        munmap(base, (size_t)(start - base));
+    munmap(start + length, (size_t)(base + DICT_HUGE_PAGE_BYTES - start));
+    return start;
+}
+
+/**
+ * @brief Apply the NUMA policy to a fresh mapping; failures leave the default policy in place
+ */
+static void bindNodes_dict(const Dict *self, void *table, size_t length)
+{
+    unsigned long nodes;
+    int mode;
+
+    switch (self->memory_dict.numa)
+    {
+    case DICT_NUMA_INTERLEAVE:
+        nodes = ~0UL; // the kernel keeps only the nodes that have memory and are allowed
+        mode = DICT_MPOL_INTERLEAVE;
+        break;
+    case DICT_NUMA_BIND:
+        if (self->memory_dict.node < 0 || self->memory_dict.node >= (int)(8 * sizeof(nodes)))
+            return;
+        nodes = 1UL << self->memory_dict.node;
+        mode = DICT_MPOL_BIND;
+        break;
+    default:
+        return;
+    }
+
+    syscall(SYS_mbind, table, length, mode, &nodes, 8 * sizeof(nodes) + 1, 0);
+}
+#endif
+
+/**
+ * @brief Allocate a zeroed table according to the dictionary's memory policy
+ *
+ * Without a policy this is calloc, or a cache-line aligned block for alignments calloc does not
+ * give; a dictionary with its own allocator takes the table from that instead, with whatever
+ * alignment it gives, and the memory policy does not apply. With a policy, a table of at least
+ * DICT_MAPPED_MIN_BYTES is mapped directly, and a smaller one is allocated as without a policy.
+ * DICT_HUGE_PAGES_EXPLICIT tries MAP_HUGETLB first and falls back to transparent huge pages when
+ * the reserved pool is empty, and the NUMA policy is set before the first touch so that every page
+ * lands where it asks.
+ *
+ * @param self Dictionary the table belongs to
+ * @param bytes Size of the table
+ * @param alignment Required alignment, at most 64 bytes
+ * @return void* Zeroed table, or NULL if out of memory
+ */
+void *engineAlloc_dict(const Dict *self, size_t bytes, size_t alignment)
+{
+#ifdef __linux__
+    if (mapped_dict(self, bytes))
+    {
+        size_t length = mapBytes_dict(self, bytes);
+        void *table = NULL;
+
+        if (self->memory_dict.hugePages == DICT_HUGE_PAGES_EXPLICIT)
+        {
+            table = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (table == MAP_FAILED)
+                table = NULL;
+        }
+        if (!table && self->memory_dict.hugePages != DICT_HUGE_PAGES_OFF)
+        {
+            table = mapAligned_dict(length);
+            if (table)
+                madvise(table, length, MADV_HUGEPAGE);
+        }
+        if (!table && self->memory_dict.hugePages == DICT_HUGE_PAGES_OFF)
+        {
+            table = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (table == MAP_FAILED)
+                table = NULL;
+        }
+        if (table)
+            bindNodes_dict(self, table, length);
+        return table;
+    }
+#endif
+
+    if (self->allocator_dict.alloc || alignment <= _Alignof(max_align_t))
+        return memCalloc_dict(self, bytes);
+
+    void *table = aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+
+    if (table)
+        memset(table, 0, bytes);
+    return table;
+}
+
+/**
+ * @brief Free a table from engineAlloc_dict
+ *
+ * @param bytes Size the table was allocated with
+ */
+void engineFree_dict(const Dict *self, void *table, size_t bytes)
+{
+    if (!table)
+        return;
+
+#ifdef __linux__
+    if (mapped_dict(self, bytes))
+    {
+        munmap(table, mapBytes_dict(self, bytes));
+        return;
+    }
+#endif
+    (void)bytes;
+    memFree_dict(self, table);
+}
@@ -0,0 +1,410 @@
+#include "../include/DictEngine.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Percentage of the slots in use beyond which the table doubles; Robin Hood probing keeps probe
+ * lengths short and even up to well above 90% */
+#ifndef DICT_ROBIN_HOOD_MAX_LOAD
+#define DICT_ROBIN_HOOD_MAX_LOAD 90
+#endif
+
+#define DICT_ROBIN_HOOD_MIN_SLOTS 16
+
+/**
+ * @struct RobinHoodSlot
+ * @brief One slot: the first pair of a key, its hash and its distance from its home slot.
+ */
+typedef struct RobinHoodSlot
+{
+    uint32_t hash; /**< Seeded hash of the key, see hash_robin; the home slot is hash & mask */
+    uint32_t distance; /**< 0 if the slot is empty, otherwise 1 + the number of slots between home and here */
+    KeyValue *pair; /**< First pair with this key; later duplicates follow through KeyValue::next */
+} RobinHoodSlot;
+
+/**
+ * @struct RobinHoodTable
+ * @brief Open-addressed table kept in Robin Hood order: along any run, distances never drop by more than one per slot.
+ */
+typedef struct RobinHoodTable
+{
+    RobinHoodSlot *slots;
+    size_t mask; /**< Number of slots - 1; the number of slots is a power of two */
+    size_t used; /**< Occupied slots, one per distinct key */
+    uint64_t seed; /**< Per-table hash seed */
+} RobinHoodTable;
+
+/**
+ * @brief Hash of a key for one table
+ *
+ * Without a per-table seed, copying one table into another visits the keys in home-slot order,
+ * which piles them into a few long runs of the new table while it is still small.
+ */
+static inline uint32_t hash_robin(const RobinHoodTable *table, const char *key)
+{
+    return (uint32_t)(((engineHash_dict(key) ^ table->seed) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static bool create_robin(Dict *self)
+{
+    RobinHoodTable *table = memAlloc_dict(self, sizeof(RobinHoodTable));
+
+    if (!table)
+        return false;
+
+    table->slots = engineAlloc_dict(self, DICT_ROBIN_HOOD_MIN_SLOTS * sizeof(RobinHoodSlot), _Alignof(RobinHoodSlot));
+    if (!table->slots)
+    {
+        memFree_dict(self, table);
+        return false;
+    }
+    table->mask = DICT_ROBIN_HOOD_MIN_SLOTS - 1;
+    table->used = 0;
+    table->seed = (uint64_t)(uintptr_t)table ^ cycleCounter();
+    self->table_dict = table;
+    return true;
+}
+
+static void destroy_robin(Dict *self)
+{
+    RobinHoodTable *table = self->table_dict;
+
+    engineFree_dict(self, table->slots, (table->mask + 1) * sizeof(RobinHoodSlot));
+    memFree_dict(self, table);
+    self->table_dict = NULL;
+}
+
+/**
+ * @brief Store an entry for a key not yet in the table, starting at slot i with the entry's distance
+ *
+ * Whenever the entry is further from home than the resident of a slot, they swap and the resident
+ * carries on looking for a slot instead. This is what keeps probe lengths even.
+ */
+static void place_robin(RobinHoodTable *table, RobinHoodSlot entry, size_t i)
+{
+    for (;; i = (i + 1) & table->mask, entry.distance++)
+    {
+        RobinHoodSlot *slot = &table->slots[i];
+
+        if (!slot->distance)
+        {
+            *slot = entry;
+            table->used++;
+            return;
+        }
+        if (slot->distance < entry.distance)
+        {
+            RobinHoodSlot resident = *slot;
+
+            *slot = entry;
+            entry = resident;
+        }
+    }
+}
+
+/**
+ * @brief Move every key into a fresh array of count slots, re-placed from its stored hash
+ *
+ * @return bool false if out of memory, in which case the table is unchanged
+ */
+static bool resize_robin(const Dict *self, RobinHoodTable *table, size_t count)
+{
+    RobinHoodSlot *old = table->slots;
+    size_t oldCount = table->mask + 1;
+    RobinHoodSlot *slots = engineAlloc_dict(self, count * sizeof(RobinHoodSlot), _Alignof(RobinHoodSlot));
+
+    if (!slots)
+        return false;
+
+    table->slots = slots;
+    table->mask = count - 1;
+    table->used = 0;
+    for (size_t i = 0; i < oldCount; i++)
+    {
+        if (old[i].distance)
+            place_robin(table, (RobinHoodSlot){old[i].hash, 1, old[i].pair}, old[i].hash & table->mask);
+    }
+    engineFree_dict(self, old, oldCount * sizeof(RobinHoodSlot));
+    return true;
+}
+
+static bool grow_robin(const Dict *self, RobinHoodTable *table)
+{
+    return resize_robin(self, table, (table->mask + 1) * 2);
+}
+
+/**
+ * @brief Find the slot of a key
+ *
+ * A key can only sit before the first slot whose resident is closer to its own home than the key
+ * would be there, so a miss stops at that slot rather than at an empty one.
+ *
+ * @return size_t Slot index, or SIZE_MAX if the key is absent
+ */
+static size_t locate_robin(const RobinHoodTable *table, const char *key, size_t *probes)
+{
+    uint32_t hash = hash_robin(table, key);
+    size_t i = hash & table->mask;
+
+    for (uint32_t distance = 1;; distance++, i = (i + 1) & table->mask)
+    {
+        const RobinHoodSlot *slot = &table->slots[i];
+
+        if (slot->distance < distance)
+        {
+            *probes = distance - 1;
+            return SIZE_MAX;
+        }
+        if (slot->hash == hash && strcmp(slot->pair->key, key) == 0)
+        {
+            *probes = distance - 1;
+            return i;
+        }
+    }
+}
+
+/**
+ * @brief Drop the first pair of slot i: its next duplicate takes over the slot, or the following
+ * displaced entries each move back one slot so that no tombstone is left behind
+ */
+static void detach_robin(RobinHoodTable *table, size_t i)
+{
+    KeyValue *pair = table->slots[i].pair;
+
+    if (pair->next)
+    {
+        table->slots[i].pair = pair->next;
+        return;
+    }
+
+    for (size_t next = (i + 1) & table->mask; table->slots[next].distance > 1; next = (next + 1) & table->mask)
+    {
+        table->slots[i] = table->slots[next];
+        table->slots[i].distance--;
+        i = next;
+    }
+    table->slots[i].distance = 0;
+    table->slots[i].pair = NULL;
+    table->used--;
+}
+
+static KeyValue *find_robin(Dict *self, const char *key, size_t *probes)
+{
+    RobinHoodTable *table = self->table_dict;
+    size_t i = locate_robin(table, key, probes);
+
+    return i == SIZE_MAX ? NULL : table->slots[i].pair;
+}
+
+static bool link_robin(Dict *self, KeyValue *pair, size_t *probes)
+{
+    RobinHoodTable *table = self->table_dict;
+    uint32_t hash = hash_robin(table, pair->key);
+    uint32_t distance = 1;
+    size_t i = hash & table->mask;
+
+    pair->next = NULL;
+
+    // a slot already holding the key comes before the first slot the new key could take
+    for (;; distance++, i = (i + 1) & table->mask)
+    {
+        RobinHoodSlot *slot = &table->slots[i];
+
+        if (slot->distance < distance)
+            break;
+        if (slot->hash == hash && strcmp(slot->pair->key, pair->key) == 0)
+        {
+            KeyValue *last = slot->pair;
+
+            while (last->next)
+                last = last->next;
+            last->next = pair;
+            *probes = distance - 1;
+            return true;
+        }
+    }
+    *probes = distance - 1;
+
+    // past the maximum load a table that cannot grow keeps filling up, until no slot is left
+    if ((table->used + 1) * 100 > (table->mask + 1) * DICT_ROBIN_HOOD_MAX_LOAD)
+    {
+        if (grow_robin(self, table))
+        {
+            i = hash & table->mask;
+            distance = 1;
+        }
+        else if (table->used == table->mask + 1)
+            return false;
+    }
+    place_robin(table, (RobinHoodSlot){hash, distance, pair}, i);
+    return true;
+}
+
+static KeyValue *remove_robin(Dict *self, const char *key, size_t *probes)
+{
+    RobinHoodTable *table = self->table_dict;
+    size_t i = locate_robin(table, key, probes);
+    KeyValue *pair;
+
+    if (i == SIZE_MAX)
+        return NULL;
+
+    pair = table->slots[i].pair;
+    detach_robin(table, i);
+    return pair;
+}
+
+static void unlink_robin(Dict *self, KeyValue *pair)
+{
+    RobinHoodTable *table = self->table_dict;
+    size_t probes;
+    size_t i = locate_robin(table, pair->key, &probes);
+    KeyValue **link = &table->slots[i].pair;
+
+    if (*link == pair)
+    {
+        detach_robin(table, i);
+        return;
+    }
+
+    while (*link != pair)
+        link = &((*link)->next);
+    *link = pair->next;
+}
+
+static size_t slotCount_robin(const Dict *self)
+{
+    const RobinHoodTable *table = self->table_dict;
+
+    return table->mask + 1;
+}
+
+static KeyValue *next_robin(const Dict *self, DictCursor *cursor)
+{
+    const RobinHoodTable *table = self->table_dict;
+    size_t end = cursor->end < table->mask + 1 ? cursor->end : table->mask + 1;
+
+    if (cursor->pair && cursor->pair->next)
+        return cursor->pair = cursor->pair->next;
+
+    while (cursor->slot < end)
+    {
+        KeyValue *head = table->slots[cursor->slot++].pair;
+
+        if (head)
+            return cursor->pair = head;
+    }
+    return cursor->pair = NULL;
+}
+
+static void clear_robin(Dict *self, void (*release)(Dict *dict, KeyValue *pair))
+{
+    RobinHoodTable *table = self->table_dict;
+
+    for (size_t i = 0; i <= table->mask; i++)
+    {
+        KeyValue *pair = table->slots[i].pair;
+
+        while (pair)
+        {
+            KeyValue *next = pair->next;
+
+            release(self, pair);
+            pair = next;
+        }
+    }
+    memset(table->slots, 0, (table->mask + 1) * sizeof(RobinHoodSlot));
+    table->used = 0;
+}
+
+/**
+ * @brief Size the table so that it is at most half full at the maximum load, which leaves room to
+ * double the keys before it grows again
+ */
+static bool shrink_robin(Dict *self, bool always)
+{
+    RobinHoodTable *table = self->table_dict;
+    size_t count = DICT_ROBIN_HOOD_MIN_SLOTS;
+
+    while (table->used * 200 > count * DICT_ROBIN_HOOD_MAX_LOAD)
+        count *= 2;
+    if (count > table->mask + 1)
+        count = table->mask + 1; // more than half full: only ever shrink here
+    if (count == table->mask + 1 && !always)
+        return false;
+    return resize_robin(self, table, count);
+}
+
+/**
+ * @brief Pass the keys whose home is the cursor's slot, wherever probing put them
+ *
+ * Scanning by home rather than by position keeps the guarantee of scanNext_dict: inserts and
+ * deletes shift keys along their run, but a key's home only changes when the table is resized.
+ * The keys of one home sit together in the run starting there, each at distance i - home + 1.
+ */
+static size_t scan_robin(const Dict *self, size_t cursor, DictEmit emit, void *ctx)
+{
+    const RobinHoodTable *table = self->table_dict;
+    size_t i = cursor & table->mask;
+
+    for (uint32_t distance = 1; table->slots[i].distance >= distance; distance++, i = (i + 1) & table->mask)
+    {
+        if (table->slots[i].distance != distance)
+            continue; // displaced from an earlier home
+
+        for (KeyValue *pair = table->slots[i].pair; pair; pair = pair->next)
+            emit(pair, ctx);
+    }
+    return scanNext_dict(cursor, table->mask);
+}
+
+static void stats_robin(const Dict *self, DictStats *out)
+{
+    const RobinHoodTable *table = self->table_dict;
+    size_t count = table->mask + 1;
+    size_t hitSum = 0;
+    size_t missSum = 0;
+
+    out->bucketCount = count;
+    out->bucketBytes = count * sizeof(RobinHoodSlot);
+    out->usedBuckets = table->used;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const RobinHoodSlot *slot = &table->slots[i];
+        size_t distance = slot->distance;
+
+        out->chainHistogram[distance < DICT_STATS_CHAIN_BINS ? distance : DICT_STATS_CHAIN_BINS - 1]++;
+        if (distance > out->longestChain)
+            out->longestChain = distance;
+        if (distance > 1)
+            out->collisions++;
+        hitSum += distance;
+        for (KeyValue *duplicate = slot->pair ? slot->pair->next : NULL; duplicate; duplicate = duplicate->next)
+            out->collisions++; // shadowed by the first pair, never found by a lookup
+
+        // a miss whose key's home is slot i compares every slot until one is closer to its home
+        uint32_t probe = 1;
+        for (size_t j = i; table->slots[j].distance >= probe; j = (j + 1) & table->mask)
+            probe++;
+        missSum += probe - 1;
+    }
+
+    out->avgProbesHit = table->used ? (double)hitSum / table->used : 0.0;
+    out->avgProbesMiss = (double)missSum / count;
+}
+
+const DictEngine robinHoodEngine_dict = {
+    .name = "robin_hood",
+    .create = create_robin,
+    .destroy = destroy_robin,
+    .find = find_robin,
+    .link = link_robin,
+    .remove = remove_robin,
+    .unlink = unlink_robin,
+    .slotCount = slotCount_robin,
+    .next = next_robin,
+    .clear = clear_robin,
+    .shrink = shrink_robin,
+    .scan = scan_robin,
+    .stats = stats_robin,
+};
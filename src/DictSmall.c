@@ -0,0 +1,285 @@
+#include "../include/DictEngine.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define DICT_SMALL_CAPACITY 16 /* distinct keys held inline; one 16-byte tag vector */
+
+/**
+ * @struct SmallTable
+ * @brief Keys held inline in the Dict allocation, in no particular order, with a one-byte hash tag each.
+ */
+typedef struct SmallTable
+{
+    uint8_t tags[DICT_SMALL_CAPACITY]; /**< Top byte of engineHash_dict of each key; only the first count are meaningful */
+    KeyValue *pairs[DICT_SMALL_CAPACITY]; /**< First pair of each key; later duplicates follow through KeyValue::next */
+    uint32_t count;
+} SmallTable;
+
+static inline uint8_t tag_small(const char *key)
+{
+    return (uint8_t)(engineHash_dict(key) >> 56);
+}
+
+/**
+ * @brief Bit i set for every occupied slot i whose tag equals tag, all slots compared at once where SSE2 is available
+ */
+static inline unsigned int matches_small(const SmallTable *table, uint8_t tag)
+{
+#if defined(__SSE2__)
+    __m128i tags = _mm_loadu_si128((const __m128i *)table->tags);
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8((char)tag)));
+#else
+    unsigned int mask = 0;
+
+    for (int i = 0; i < DICT_SMALL_CAPACITY; i++)
+        mask |= (unsigned int)(table->tags[i] == tag) << i;
+#endif
+    return mask & ((1u << table->count) - 1);
+}
+
+/**
+ * @brief Slot of a key
+ *
+ * @param probes Receives the number of keys whose tag matched but whose key did not
+ * @return int Slot index, or -1 if the key is absent
+ */
+static int locate_small(const SmallTable *table, const char *key, size_t *probes)
+{
+    unsigned int mask = matches_small(table, tag_small(key));
+
+    *probes = 0;
+    while (mask)
+    {
+        int i = __builtin_ctz(mask);
+
+        if (strcmp(table->pairs[i]->key, key) == 0)
+            return i;
+        (*probes)++;
+        mask &= mask - 1;
+    }
+    return -1;
+}
+
+static bool create_small(Dict *self)
+{
+    SmallTable *table = (SmallTable *)self->inline_dict;
+
+    table->count = 0;
+    self->table_dict = table;
+    return true;
+}
+
+static void destroy_small(Dict *self)
+{
+    self->table_dict = NULL; // part of the Dict allocation
+}
+
+/**
+ * @brief Move every pair into a Robin Hood table and hand the dictionary over to that engine
+ *
+ * Duplicates are relinked in insertion order so that the earlier pair keeps precedence. A Robin
+ * Hood table always has room for the pairs of a full small table, even if it cannot grow.
+ *
+ * @return bool false if out of memory, in which case the dictionary keeps its small table
+ */
+static bool upgrade_small(Dict *self)
+{
+    SmallTable *table = self->table_dict;
+    size_t probes;
+
+    if (!robinHoodEngine_dict.create(self))
+        return false;
+
+    for (uint32_t i = 0; i < table->count; i++)
+    {
+        KeyValue *pair = table->pairs[i];
+
+        while (pair)
+        {
+            KeyValue *next = pair->next;
+
+            robinHoodEngine_dict.link(self, pair, &probes);
+            pair = next;
+        }
+    }
+    table->count = 0;
+    self->engine_dict = &robinHoodEngine_dict;
+    return true;
+}
+
+static KeyValue *find_small(Dict *self, const char *key, size_t *probes)
+{
+    SmallTable *table = self->table_dict;
+    int i = locate_small(table, key, probes);
+
+    return i < 0 ? NULL : table->pairs[i];
+}
+
+static bool link_small(Dict *self, KeyValue *pair, size_t *probes)
+{
+    SmallTable *table = self->table_dict;
+    int i = locate_small(table, pair->key, probes);
+
+    pair->next = NULL;
+    if (i >= 0)
+    {
+        KeyValue *last = table->pairs[i];
+
+        while (last->next)
+            last = last->next;
+        last->next = pair;
+        return true;
+    }
+
+    if (table->count == DICT_SMALL_CAPACITY)
+        return upgrade_small(self) && robinHoodEngine_dict.link(self, pair, probes);
+
+    table->tags[table->count] = tag_small(pair->key);
+    table->pairs[table->count++] = pair;
+    return true;
+}
+
+/**
+ * @brief Drop the first pair of slot i: its next duplicate takes over the slot, or the last slot moves into it
+ */
+static void detach_small(SmallTable *table, int i)
+{
+    KeyValue *pair = table->pairs[i];
+
+    if (pair->next)
+    {
+        table->pairs[i] = pair->next;
+        return;
+    }
+
+    table->count--;
+    table->tags[i] = table->tags[table->count];
+    table->pairs[i] = table->pairs[table->count];
+}
+
+static KeyValue *remove_small(Dict *self, const char *key, size_t *probes)
+{
+    SmallTable *table = self->table_dict;
+    int i = locate_small(table, key, probes);
+    KeyValue *pair;
+
+    if (i < 0)
+        return NULL;
+
+    pair = table->pairs[i];
+    detach_small(table, i);
+    return pair;
+}
+
+static void unlink_small(Dict *self, KeyValue *pair)
+{
+    SmallTable *table = self->table_dict;
+    size_t probes;
+    int i = locate_small(table, pair->key, &probes);
+    KeyValue **link = &table->pairs[i];
+
+    if (*link == pair)
+    {
+        detach_small(table, i);
+        return;
+    }
+
+    while (*link != pair)
+        link = &((*link)->next);
+    *link = pair->next;
+}
+
+static size_t slotCount_small(const Dict *self)
+{
+    (void)self;
+    return DICT_SMALL_CAPACITY;
+}
+
+static KeyValue *next_small(const Dict *self, DictCursor *cursor)
+{
+    const SmallTable *table = self->table_dict;
+    size_t end = cursor->end < table->count ? cursor->end : table->count;
+
+    if (cursor->pair && cursor->pair->next)
+        return cursor->pair = cursor->pair->next;
+
+    if (cursor->slot < end)
+        return cursor->pair = table->pairs[cursor->slot++];
+    return cursor->pair = NULL;
+}
+
+static void clear_small(Dict *self, void (*release)(Dict *dict, KeyValue *pair))
+{
+    SmallTable *table = self->table_dict;
+
+    for (uint32_t i = 0; i < table->count; i++)
+    {
+        KeyValue *pair = table->pairs[i];
+
+        while (pair)
+        {
+            KeyValue *next = pair->next;
+
+            release(self, pair);
+            pair = next;
+        }
+    }
+    table->count = 0;
+}
+
+/**
+ * @brief Pass every pair in one step: removals move the last key into the hole, so a scan spread
+ * over several steps could miss it
+ */
+static size_t scan_small(const Dict *self, size_t cursor, DictEmit emit, void *ctx)
+{
+    const SmallTable *table = self->table_dict;
+
+    (void)cursor;
+    for (uint32_t i = 0; i < table->count; i++)
+    {
+        for (KeyValue *pair = table->pairs[i]; pair; pair = pair->next)
+            emit(pair, ctx);
+    }
+    return 0;
+}
+
+static void stats_small(const Dict *self, DictStats *out)
+{
+    const SmallTable *table = self->table_dict;
+
+    out->bucketCount = DICT_SMALL_CAPACITY;
+    out->bucketBytes = sizeof(SmallTable);
+    out->usedBuckets = table->count;
+
+    // every key is one tag comparison away, so a lookup is a single probe of the tag vector
+    out->chainHistogram[0] = DICT_SMALL_CAPACITY - table->count;
+    out->chainHistogram[1] = table->count;
+    out->longestChain = table->count ? 1 : 0;
+    for (uint32_t i = 0; i < table->count; i++)
+    {
+        for (KeyValue *duplicate = table->pairs[i]->next; duplicate; duplicate = duplicate->next)
+            out->collisions++; // shadowed by the first pair, never found by a lookup
+    }
+    out->avgProbesHit = table->count ? 1.0 : 0.0;
+    out->avgProbesMiss = 1.0;
+}
+
+const DictEngine smallEngine_dict = {
+    .name = "small",
+    .inlineBytes = sizeof(SmallTable),
+    .create = create_small,
+    .destroy = destroy_small,
+    .find = find_small,
+    .link = link_small,
+    .remove = remove_small,
+    .unlink = unlink_small,
+    .slotCount = slotCount_small,
+    .next = next_small,
+    .clear = clear_small,
+    .scan = scan_small,
+    .stats = stats_small,
+};
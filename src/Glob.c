@@ -0,0 +1,283 @@
+#include "../include/Glob.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief End of the character class opening at pattern, or NULL if it is never closed
+ */
+static const char *classEnd_glob(const char *pattern)
+{
+    const char *p = pattern + 1;
+
+    if (*p == '^' || *p == '!')
+        p++;
+    if (*p == ']')
+        p++; // a leading ']' is a member, not the end
+
+    while (*p && *p != ']')
+    {
+        if (*p == '\\' && p[1])
+            p++;
+        p++;
+    }
+    return *p ? p : NULL;
+}
+
+/**
+ * @brief Match one pattern atom (a character, `?`, a class or an escape) against one character
+ *
+ * @param atom Pattern syntax at the atom
+ * @param c Character to test
+ * @param ok Receives whether the atom matches c
+ * @return const char* Pattern position after the atom
+ */
+static const char *matchAtom_glob(const char *atom, unsigned char c, bool *ok)
+{
+    if (*atom == '?')
+    {
+        *ok = true;
+        return atom + 1;
+    }
+
+    if (*atom == '\\' && atom[1])
+    {
+        *ok = (unsigned char)atom[1] == c;
+        return atom + 2;
+    }
+
+    const char *end = *atom == '[' ? classEnd_glob(atom) : NULL;
+    if (!end)
+    {
+        // ordinary character, or a '[' that never closes and is taken literally
+        *ok = (unsigned char)*atom == c;
+        return atom + 1;
+    }
+
+    const char *p = atom + 1;
+    bool negate = *p == '^' || *p == '!';
+    bool found = false;
+
+    if (negate)
+        p++;
+
+    while (p < end)
+    {
+        unsigned char lo = (unsigned char)*p;
+
+        if (lo == '\\' && p + 1 < end)
+            lo = (unsigned char)*++p;
+        p++;
+
+        unsigned char hi = lo;
+        if (*p == '-' && p + 1 < end)
+        {
+            p++;
+            if (*p == '\\' && p + 1 < end)
+                p++;
+            hi = (unsigned char)*p++;
+        }
+
+        if (lo <= c && c <= hi)
+            found = true;
+    }
+
+    *ok = found != negate;
+    return end + 1;
+}
+
+/**
+ * @brief Test a non-literal segment against the characters at text, which holds at least width of them
+ */
+static bool segmentMatchesAt_glob(const GlobSegment *segment, const char *text)
+{
+    const char *atom = segment->text;
+
+    for (size_t i = 0; *atom; i++)
+    {
+        bool ok;
+
+        atom = matchAtom_glob(atom, (unsigned char)text[i], &ok);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+static bool segmentAt_glob(const GlobSegment *segment, const char *text)
+{
+    return segment->literal ? memcmp(text, segment->text, segment->width) == 0 : segmentMatchesAt_glob(segment, text);
+}
+
+/**
+ * @brief Leftmost position in [from, end) where the segment matches entirely before end
+ *
+ * @return const char* Start of the match, or NULL
+ */
+static const char *findSegment_glob(const GlobSegment *segment, const char *from, const char *end)
+{
+    if (segment->literal)
+    {
+        const char *found = strstr(from, segment->text);
+        return found && found + segment->width <= end ? found : NULL;
+    }
+
+    for (const char *p = from; p + segment->width <= end; p++)
+    {
+        if (segmentMatchesAt_glob(segment, p))
+            return p;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Compile a pattern
+ *
+ * @param matcher Receives the compiled pattern; release it with globFree
+ * @param pattern Glob to compile; it is copied, so it need not outlive the matcher
+ * @return bool false if out of memory
+ */
+bool globCompile(GlobMatcher *matcher, const char *pattern)
+{
+    size_t length = strlen(pattern);
+    size_t maxSegments = 1;
+
+    memset(matcher, 0, sizeof(*matcher));
+    for (const char *p = pattern; *p; p++)
+    {
+        if (*p == '*')
+            maxSegments++;
+    }
+
+    // every segment and the prefix are at most as long as the pattern, plus their terminators
+    matcher->storage = malloc(2 * length + maxSegments + 1);
+    matcher->segments = malloc(maxSegments * sizeof(GlobSegment));
+    if (!matcher->storage || !matcher->segments)
+    {
+        globFree(matcher);
+        return false;
+    }
+
+    char *out = matcher->storage;
+    const char *p = pattern;
+
+    // literal prefix: unescaped characters up to the first wildcard
+    matcher->literalPrefix = out;
+    while (*p && *p != '*' && *p != '?' && !(*p == '[' && classEnd_glob(p)))
+    {
+        if (*p == '\\' && p[1])
+            p++;
+        *out++ = *p++;
+    }
+    matcher->prefixLength = (size_t)(out - matcher->literalPrefix);
+    *out++ = '\0';
+
+    matcher->anchoredStart = *pattern != '*';
+    matcher->anchoredEnd = true;
+    p = pattern;
+    while (*p)
+    {
+        if (*p == '*')
+        {
+            matcher->hasStar = true;
+            matcher->anchoredEnd = false;
+            p++;
+            continue;
+        }
+
+        // one segment: up to the next star outside a class
+        const char *start = p;
+        bool literal = true;
+        size_t width = 0;
+
+        while (*p && *p != '*')
+        {
+            const char *end = *p == '[' ? classEnd_glob(p) : NULL;
+
+            if (*p == '?' || end)
+                literal = false;
+            if (end)
+                p = end + 1;
+            else if (*p == '\\' && p[1])
+                p += 2;
+            else
+                p++;
+            width++;
+        }
+
+        GlobSegment *segment = &matcher->segments[matcher->segmentCount++];
+        segment->text = out;
+        segment->width = width;
+        segment->literal = literal;
+        matcher->anchoredEnd = true;
+
+        for (const char *q = start; q < p; q++)
+        {
+            if (literal && *q == '\\' && q + 1 < p)
+                q++;
+            *out++ = *q;
+        }
+        *out++ = '\0';
+    }
+
+    return true;
+}
+
+/**
+ * @brief Release a compiled pattern
+ */
+void globFree(GlobMatcher *matcher)
+{
+    free(matcher->storage);
+    free(matcher->segments);
+    matcher->storage = NULL;
+    matcher->segments = NULL;
+    matcher->segmentCount = 0;
+}
+
+/**
+ * @brief Test a string against a compiled pattern
+ *
+ * @return bool true if the whole string matches
+ */
+bool globMatch(const GlobMatcher *matcher, const char *text)
+{
+    size_t length = strlen(text);
+    const char *pos = text;
+    const char *end = text + length;
+    size_t first = 0;
+    size_t last = matcher->segmentCount;
+
+    if (!matcher->hasStar)
+    {
+        return matcher->segmentCount == 0 ? length == 0 :
+               matcher->segments[0].width == length && segmentAt_glob(&matcher->segments[0], text);
+    }
+
+    if (matcher->anchoredStart)
+    {
+        const GlobSegment *head = &matcher->segments[first++];
+
+        if (head->width > length || !segmentAt_glob(head, text))
+            return false;
+        pos += head->width;
+    }
+
+    if (matcher->anchoredEnd && last > first)
+    {
+        const GlobSegment *tail = &matcher->segments[--last];
+
+        if ((size_t)(end - pos) < tail->width || !segmentAt_glob(tail, end - tail->width))
+            return false;
+        end -= tail->width;
+    }
+
+    for (size_t i = first; i < last; i++)
+    {
+        const char *found = findSegment_glob(&matcher->segments[i], pos, end);
+
+        if (!found)
+            return false;
+        pos = found + matcher->segments[i].width;
+    }
+    return true;
+}
@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime, nanosleep */
+
+#include "../include/Histogram.h"
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Highest value that falls into a bucket, reported for percentiles the way HDR histograms do
+ */
+static uint64_t histogramBucketUpper(unsigned int index)
+{
+    if (index < HISTOGRAM_SUB_BUCKETS)
+        return index;
+
+    unsigned int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(HISTOGRAM_SUB_BUCKETS + index % HISTOGRAM_SUB_BUCKETS) << shift;
+
+    return lower + ((1ull << shift) - 1);
+}
+
+/**
+ * @brief Clear every bucket and summary field
+ *
+ * @param hist Pointer to the histogram to reset
+ */
+void histogramReset(Histogram *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT64_MAX;
+}
+
+/**
+ * @brief Add all samples of one histogram into another
+ *
+ * @param dest Histogram receiving the samples
+ * @param src Histogram whose samples are added
+ */
+void histogramMerge(Histogram *dest, const Histogram *src)
+{
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+        dest->counts[i] += src->counts[i];
+
+    dest->total += src->total;
+    dest->sum += src->sum;
+
+    if (src->min < dest->min)
+        dest->min = src->min;
+    if (src->max > dest->max)
+        dest->max = src->max;
+}
+
+/**
+ * @brief Value at or below which the given percentage of samples fall
+ *
+ * @param hist Pointer to the histogram to query
+ * @param percentile Percentile in the range [0, 100]
+ * @return uint64_t Upper bound of the matching bucket, clamped to the recorded maximum; 0 when empty
+ */
+uint64_t histogramPercentile(const Histogram *hist, double percentile)
+{
+    if (hist->total == 0)
+        return 0;
+    if (percentile >= 100.0)
+        return hist->max;
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)hist->total + 0.5);
+    uint64_t seen = 0;
+
+    if (rank == 0)
+        rank = 1;
+
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        seen += hist->counts[i];
+        if (seen >= rank)
+        {
+            uint64_t upper = histogramBucketUpper(i);
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+/**
+ * @brief Arithmetic mean of the recorded samples
+ *
+ * @param hist Pointer to the histogram to query
+ * @return double Mean sample value, or 0 when empty
+ */
+double histogramMean(const Histogram *hist)
+{
+    return hist->total ? (double)hist->sum / (double)hist->total : 0.0;
+}
+
+/**
+ * @brief Estimate how many cycleCounter ticks elapse per second
+ *
+ * Calibrates once against the monotonic clock (about 20 ms) and caches the result.
+ *
+ * @return double Ticks per second
+ */
+double cycleCounterFrequency(void)
+{
+    static double frequency = 0.0;
+
+    if (frequency == 0.0)
+    {
+        struct timespec start, end, pause = {0, 20000000};
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t ticksStart = cycleCounter();
+        nanosleep(&pause, NULL);
+        uint64_t ticksEnd = cycleCounter();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        frequency = (double)(ticksEnd - ticksStart) / seconds;
+    }
+    return frequency;
+}
@@ -0,0 +1,387 @@
+#include "../include/KeySort.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef DICT_ENABLE_THREADS
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#define KEY_SORT_INSERTION_MAX 32 /* runs this short are finished by insertion sort */
+#define KEY_SORT_CACHE_BYTES 8 /* key bytes held next to each item */
+#define KEY_SORT_PARALLEL_MIN 65536 /* smaller inputs are sorted on the calling thread */
+#define KEY_SORT_TASKS_PER_THREAD 8
+#define KEY_SORT_MAX_THREADS 64
+
+/**
+ * @struct KeySortRun
+ * @brief A run of items whose keys agree on their first depth bytes, with its share of the scratch space.
+ */
+typedef struct KeySortRun
+{
+    KeySortItem *items;
+    KeySortItem *buffer; /**< Scratch space for the items */
+    uint64_t *cache; /**< KEY_SORT_CACHE_BYTES bytes of each item's key from base on, first byte highest, zero past the key's end */
+    uint64_t *cacheBuffer; /**< Scratch space for the cache */
+    size_t count;
+    size_t depth; /**< Bytes every key of the run has in common */
+    size_t base; /**< Offset into the keys of the cached bytes, the same for the whole run */
+} KeySortRun;
+
+/**
+ * @struct KeySortMemory
+ * @brief Where the scratch space comes from; alloc is NULL for malloc.
+ */
+typedef struct KeySortMemory
+{
+    KeySortAllocFn alloc;
+    KeySortFreeFn free; /**< With alloc set, NULL to never free (arena mode) */
+    void *ctx;
+} KeySortMemory;
+
+static void *alloc_keysort(const KeySortMemory *memory, size_t size)
+{
+    return memory->alloc ? memory->alloc(size, memory->ctx) : malloc(size);
+}
+
+static void release_keysort(const KeySortMemory *memory, void *block)
+{
+    if (!memory->alloc)
+        free(block);
+    else if (memory->free && block)
+        memory->free(block, memory->ctx);
+}
+
+/**
+ * @brief The part of a run starting at item begin, whose keys agree on their first depth bytes
+ */
+static inline KeySortRun part_keysort(const KeySortRun *run, size_t begin, size_t count, size_t depth)
+{
+    return (KeySortRun){run->items + begin, run->buffer + begin, run->cache + begin, run->cacheBuffer + begin,
+                        count, depth, run->base};
+}
+
+/**
+ * @brief Up to KEY_SORT_CACHE_BYTES bytes of a key, first byte highest, so that cached words compare like the bytes
+ */
+static inline uint64_t load_keysort(const char *key)
+{
+    uint64_t word = 0;
+
+    for (int b = 0; b < KEY_SORT_CACHE_BYTES && key[b]; b++)
+        word |= (uint64_t)(unsigned char)key[b] << (56 - 8 * b);
+    return word;
+}
+
+/**
+ * @brief strcmp of two keys of a run, settled by their cached bytes where it can be
+ *
+ * The keys of a run agree on their bytes before depth, so their cached words compare like the
+ * rest of the cached bytes; only keys that agree on all of those and go on past them are compared
+ * in memory.
+ */
+static inline int compare_keysort(const KeySortRun *run, const char *a, uint64_t cachedA, const char *b, uint64_t cachedB)
+{
+    size_t from = run->base + KEY_SORT_CACHE_BYTES;
+
+    if (cachedA != cachedB)
+        return cachedA < cachedB ? -1 : 1;
+    if (!(cachedA & 0xff))
+        return 0; // both keys end inside the cached bytes
+    return strcmp(a + (run->depth > from ? run->depth : from), b + (run->depth > from ? run->depth : from));
+}
+
+/**
+ * @brief Stable insertion sort of a short run
+ */
+static void insertion_keysort(const KeySortRun *run)
+{
+    for (size_t i = 1; i < run->count; i++)
+    {
+        KeySortItem item = run->items[i];
+        uint64_t cached = run->cache[i];
+        size_t j = i;
+
+        while (j > 0 && compare_keysort(run, run->items[j - 1].key, run->cache[j - 1], item.key, cached) > 0)
+        {
+            run->items[j] = run->items[j - 1];
+            run->cache[j] = run->cache[j - 1];
+            j--;
+        }
+        run->items[j] = item;
+        run->cache[j] = cached;
+    }
+}
+
+/**
+ * @brief Distribute a run by the first byte its keys differ on
+ *
+ * The bytes come from the cache, which is refilled from the keys only once the run has gone
+ * KEY_SORT_CACHE_BYTES bytes past it: the keys are scattered through memory, and this way most
+ * passes read nothing but the items and the cache, in order. A prefix that every key shares is
+ * skipped, advancing run->depth. On return the items are grouped by the byte at run->depth, in
+ * byte order and otherwise in their previous order, and counts holds the size of each group.
+ *
+ * @return bool false if every key ends at the same byte, so that they are all equal
+ */
+static bool partition_keysort(KeySortRun *run, size_t counts[256])
+{
+    size_t next[256];
+    size_t offset = 0;
+    unsigned int shift;
+
+    for (;; run->depth++)
+    {
+        if (run->depth >= run->base + KEY_SORT_CACHE_BYTES)
+        {
+            for (size_t i = 0; i < run->count; i++)
+                run->cache[i] = load_keysort(run->items[i].key + run->depth);
+            run->base = run->depth;
+        }
+
+        shift = 56 - 8 * (unsigned int)(run->depth - run->base);
+        memset(counts, 0, 256 * sizeof(size_t));
+        for (size_t i = 0; i < run->count; i++)
+            counts[(run->cache[i] >> shift) & 0xff]++;
+
+        unsigned int first = (unsigned int)(run->cache[0] >> shift) & 0xff;
+
+        if (counts[first] != run->count)
+            break;
+        if (!first)
+            return false;
+    }
+
+    for (int c = 0; c < 256; c++)
+    {
+        next[c] = offset;
+        offset += counts[c];
+    }
+    for (size_t i = 0; i < run->count; i++)
+    {
+        size_t to = next[(run->cache[i] >> shift) & 0xff]++;
+
+        run->buffer[to] = run->items[i];
+        run->cacheBuffer[to] = run->cache[i];
+    }
+    memcpy(run->items, run->buffer, run->count * sizeof(KeySortItem));
+    memcpy(run->cache, run->cacheBuffer, run->count * sizeof(uint64_t));
+    return true;
+}
+
+/**
+ * @brief Sort a run
+ *
+ * Every group but the largest is sorted by a recursive call and the largest by the loop itself,
+ * so the recursion is at most log2(count) deep whatever the keys look like.
+ */
+static void msd_keysort(KeySortRun run)
+{
+    size_t counts[256];
+
+    while (run.count > KEY_SORT_INSERTION_MAX)
+    {
+        if (!partition_keysort(&run, counts))
+            return;
+
+        // group 0 holds the keys that end here: equal, and already in order
+        size_t begin = counts[0];
+        size_t largest = 1;
+        size_t largestBegin = 0;
+
+        for (int c = 2; c < 256; c++)
+        {
+            if (counts[c] > counts[largest])
+                largest = (size_t)c;
+        }
+        for (int c = 1; c < 256; c++)
+        {
+            if ((size_t)c == largest)
+                largestBegin = begin;
+            else if (counts[c] > 1)
+                msd_keysort(part_keysort(&run, begin, counts[c], run.depth + 1));
+            begin += counts[c];
+        }
+        run = part_keysort(&run, largestBegin, counts[largest], run.depth + 1);
+    }
+    insertion_keysort(&run);
+}
+
+#ifdef DICT_ENABLE_THREADS
+/**
+ * @struct KeySortTeam
+ * @brief Runs shared by the sorting threads, claimed largest first.
+ */
+typedef struct KeySortTeam
+{
+    const KeySortRun *tasks;
+    size_t taskCount;
+    atomic_size_t nextTask;
+} KeySortTeam;
+
+static int largerTask_keysort(const void *a, const void *b)
+{
+    size_t left = ((const KeySortRun *)a)->count;
+    size_t right = ((const KeySortRun *)b)->count;
+
+    return left < right ? 1 : left > right ? -1 : 0;
+}
+
+static void *worker_keysort(void *arg)
+{
+    KeySortTeam *team = arg;
+    size_t i;
+
+    while ((i = atomic_fetch_add_explicit(&team->nextTask, 1, memory_order_relaxed)) < team->taskCount)
+        msd_keysort(team->tasks[i]);
+    return NULL;
+}
+
+/**
+ * @brief Split the input into runs of at most count / (threads * 8) keys, then sort the runs on threads threads
+ *
+ * The splitting passes are the same distribution passes the serial sort makes at the top levels.
+ * Handing the runs out largest first keeps one late, large run from finishing on its own.
+ *
+ * @return bool false if the task list could not be allocated; the items are then left untouched
+ */
+static bool parallel_keysort(KeySortRun whole, int threads, const KeySortMemory *memory)
+{
+    size_t limit = whole.count / ((size_t)threads * KEY_SORT_TASKS_PER_THREAD);
+    size_t capacity = 256;
+    size_t taskCount = 1;
+    KeySortRun *tasks = alloc_keysort(memory, capacity * sizeof(KeySortRun));
+    size_t counts[256];
+
+    if (!tasks)
+        return false;
+    tasks[0] = whole;
+
+    for (size_t t = 0; t < taskCount; t++)
+    {
+        KeySortRun run = tasks[t];
+
+        if (run.count <= limit)
+            continue;
+
+        tasks[t].count = 0; // replaced by its groups
+        if (!partition_keysort(&run, counts))
+            continue;
+
+        if (taskCount + 256 > capacity)
+        {
+            KeySortRun *grown = alloc_keysort(memory, capacity * 2 * sizeof(KeySortRun));
+
+            if (!grown)
+            {
+                // out of memory partway: this run is finished here instead
+                msd_keysort(run);
+                continue;
+            }
+            memcpy(grown, tasks, taskCount * sizeof(KeySortRun));
+            release_keysort(memory, tasks);
+            tasks = grown;
+            capacity *= 2;
+        }
+
+        size_t begin = counts[0];
+
+        for (int c = 1; c < 256; c++)
+        {
+            if (counts[c] > 1)
+                tasks[taskCount++] = part_keysort(&run, begin, counts[c], run.depth + 1);
+            begin += counts[c];
+        }
+    }
+
+    qsort(tasks, taskCount, sizeof(KeySortRun), largerTask_keysort);
+    while (taskCount && !tasks[taskCount - 1].count)
+        taskCount--;
+
+    KeySortTeam team = {tasks, taskCount, 0};
+    pthread_t workers[KEY_SORT_MAX_THREADS];
+    bool started[KEY_SORT_MAX_THREADS] = {false};
+
+    // a worker that cannot be started just claims no runs; the others cover them
+    for (int t = 1; t < threads; t++)
+        started[t] = pthread_create(&workers[t], NULL, worker_keysort, &team) == 0;
+    worker_keysort(&team);
+    for (int t = 1; t < threads; t++)
+    {
+        if (started[t])
+            pthread_join(workers[t], NULL);
+    }
+
+    release_keysort(memory, tasks);
+    return true;
+}
+#endif
+
+/**
+ * @brief Sort items by key into strcmp order, keeping items with equal keys in their original order
+ *
+ * Only the items move; the keys are read but never copied. Takes 32 bytes of scratch space per item,
+ * from malloc: a second array of items and two 8-byte key caches.
+ *
+ * @param items Items to sort in place
+ * @param count Number of items
+ * @param threads Threads to sort with, including the caller, at most 64; inputs under 64K items, and
+ *                builds without DICT_ENABLE_THREADS, use the calling thread only
+ * @return bool false if out of memory, leaving the items untouched
+ */
+bool keySort(KeySortItem *items, size_t count, int threads)
+{
+    return keySortWithAllocator(items, count, threads, NULL, NULL, NULL);
+}
+
+/**
+ * @brief keySort taking its scratch space from the caller's allocator
+ *
+ * @param allocFn Returns size bytes, or NULL if out of memory; NULL for malloc
+ * @param freeFn Releases a block, or NULL to never free, for arenas released as a whole
+ * @param ctx User pointer passed to both
+ */
+bool keySortWithAllocator(KeySortItem *items, size_t count, int threads, KeySortAllocFn allocFn, KeySortFreeFn freeFn, void *ctx)
+{
+    KeySortMemory memory = {allocFn, freeFn, ctx};
+    KeySortRun whole = {items, NULL, NULL, NULL, count, 0, 0};
+
+    if (count <= KEY_SORT_INSERTION_MAX)
+    {
+        uint64_t cache[KEY_SORT_INSERTION_MAX];
+
+        for (size_t i = 0; i < count; i++)
+            cache[i] = load_keysort(items[i].key);
+        whole.cache = cache;
+        insertion_keysort(&whole);
+        return true;
+    }
+
+    whole.buffer = alloc_keysort(&memory, count * sizeof(KeySortItem));
+    whole.cache = alloc_keysort(&memory, count * sizeof(uint64_t));
+    whole.cacheBuffer = alloc_keysort(&memory, count * sizeof(uint64_t));
+    if (!whole.buffer || !whole.cache || !whole.cacheBuffer)
+    {
+        release_keysort(&memory, whole.buffer);
+        release_keysort(&memory, whole.cache);
+        release_keysort(&memory, whole.cacheBuffer);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+        whole.cache[i] = load_keysort(items[i].key);
+
+#ifdef DICT_ENABLE_THREADS
+    if (threads > KEY_SORT_MAX_THREADS)
+        threads = KEY_SORT_MAX_THREADS;
+    if (threads <= 1 || count < KEY_SORT_PARALLEL_MIN || !parallel_keysort(whole, threads, &memory))
+        msd_keysort(whole);
+#else
+    (void)threads;
+    msd_keysort(whole);
+#endif
+
+    release_keysort(&memory, whole.buffer);
+    release_keysort(&memory, whole.cache);
+    release_keysort(&memory, whole.cacheBuffer);
+    return true;
+}
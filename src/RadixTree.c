@@ -0,0 +1,989 @@
+#include "../include/RadixTree.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Compressed path bytes stored in a node; longer paths are checked against a leaf below it */
+#define RADIX_MAX_PREFIX 10
+
+enum
+{
+    RADIX_NODE4 = 1,
+    RADIX_NODE16,
+    RADIX_NODE48,
+    RADIX_NODE256
+};
+
+typedef struct RadixNode
+{
+    uint32_t prefixLength; /**< Length of the compressed path, possibly more than RADIX_MAX_PREFIX */
+    uint16_t count; /**< Number of children */
+    uint8_t type;
+    unsigned char prefix[RADIX_MAX_PREFIX]; /**< First bytes of the compressed path */
+} RadixNode;
+
+typedef struct RadixNode4
+{
+    RadixNode header;
+    unsigned char keys[4]; /**< Sorted */
+    void *children[4];
+} RadixNode4;
+
+typedef struct RadixNode16
+{
+    RadixNode header;
+    unsigned char keys[16]; /**< Sorted */
+    void *children[16];
+} RadixNode16;
+
+typedef struct RadixNode48
+{
+    RadixNode header;
+    unsigned char index[256]; /**< 1 + slot in children, 0 if the byte has no child */
+    void *children[48];
+} RadixNode48;
+
+typedef struct RadixNode256
+{
+    RadixNode header;
+    void *children[256];
+} RadixNode256;
+
+typedef struct RadixLeaf
+{
+    const unsigned char *key; /**< Caller's key, not copied */
+    size_t length; /**< Key length including the terminating NUL, which keeps keys prefix-free */
+    void *value;
+} RadixLeaf;
+
+/* Children are either inner nodes or leaves tagged in the low pointer bit */
+#define RADIX_IS_LEAF(p) ((uintptr_t)(p) & 1)
+#define RADIX_LEAF(p) ((RadixLeaf *)((uintptr_t)(p) & ~(uintptr_t)1))
+#define RADIX_TAG_LEAF(l) ((void *)((uintptr_t)(l) | 1))
+
+static size_t nodeSize_radix(uint8_t type)
+{
+    switch (type)
+    {
+    case RADIX_NODE4:
+        return sizeof(RadixNode4);
+    case RADIX_NODE16:
+        return sizeof(RadixNode16);
+    case RADIX_NODE48:
+        return sizeof(RadixNode48);
+    default:
+        return sizeof(RadixNode256);
+    }
+}
+
+const char radixTreeNoMemory;
+
+static void *alloc_radix(RadixTree *tree, size_t size)
+{
+    return tree->alloc ? tree->alloc(size, tree->allocCtx) : malloc(size);
+}
+
+static void release_radix(const RadixTree *tree, void *block)
+{
+    if (!tree->alloc)
+        free(block);
+    else if (tree->free)
+        tree->free(block, tree->allocCtx);
+}
+
+/**
+ * @brief A zeroed node of the given type, or NULL if out of memory
+ */
+static RadixNode *allocNode_radix(RadixTree *tree, uint8_t type)
+{
+    RadixNode *node = alloc_radix(tree, nodeSize_radix(type));
+
+    if (!node)
+        return NULL;
+    memset(node, 0, nodeSize_radix(type));
+    node->type = type;
+    tree->bytes += nodeSize_radix(type);
+    return node;
+}
+
+static void freeNode_radix(RadixTree *tree, RadixNode *node)
+{
+    tree->bytes -= nodeSize_radix(node->type);
+    release_radix(tree, node);
+}
+
+static void copyHeader_radix(RadixNode *dest, const RadixNode *src)
+{
+    dest->prefixLength = src->prefixLength;
+    dest->count = src->count;
+    memcpy(dest->prefix, src->prefix, sizeof(src->prefix));
+}
+
+static inline uint32_t min_radix(uint32_t a, uint32_t b)
+{
+    return a < b ? a : b;
+}
+
+/**
+ * @brief Slot holding the child for a byte, or NULL
+ */
+static void **findChild_radix(RadixNode *node, unsigned char byte)
+{
+    switch (node->type)
+    {
+    case RADIX_NODE4:
+    {
+        RadixNode4 *n = (RadixNode4 *)node;
+        for (int i = 0; i < node->count; i++)
+        {
+            if (n->keys[i] == byte)
+                return &n->children[i];
+        }
+        return NULL;
+    }
+    case RADIX_NODE16:
+    {
+        RadixNode16 *n = (RadixNode16 *)node;
+        for (int i = 0; i < node->count && n->keys[i] <= byte; i++)
+        {
+            if (n->keys[i] == byte)
+                return &n->children[i];
+        }
+        return NULL;
+    }
+    case RADIX_NODE48:
+    {
+        RadixNode48 *n = (RadixNode48 *)node;
+        return n->index[byte] ? &n->children[n->index[byte] - 1] : NULL;
+    }
+    default:
+    {
+        RadixNode256 *n = (RadixNode256 *)node;
+        return n->children[byte] ? &n->children[byte] : NULL;
+    }
+    }
+}
+
+/**
+ * @brief Next child in byte order
+ *
+ * @param cursor Iteration state, 0 before the first call
+ * @param byte Receives the byte leading to the returned child
+ * @return void* Child, or NULL once every child was returned
+ */
+static void *nextChild_radix(const RadixNode *node, int *cursor, unsigned char *byte)
+{
+    switch (node->type)
+    {
+    case RADIX_NODE4:
+    case RADIX_NODE16:
+    {
+        const unsigned char *keys = node->type == RADIX_NODE4 ? ((const RadixNode4 *)node)->keys : ((const RadixNode16 *)node)->keys;
+        void *const *children = node->type == RADIX_NODE4 ? ((const RadixNode4 *)node)->children : ((const RadixNode16 *)node)->children;
+
+        if (*cursor >= node->count)
+            return NULL;
+        *byte = keys[*cursor];
+        return children[(*cursor)++];
+    }
+    case RADIX_NODE48:
+    {
+        const RadixNode48 *n = (const RadixNode48 *)node;
+        for (; *cursor < 256; (*cursor)++)
+        {
+            if (n->index[*cursor])
+            {
+                *byte = (unsigned char)*cursor;
+                return n->children[n->index[(*cursor)++] - 1];
+            }
+        }
+        return NULL;
+    }
+    default:
+    {
+        const RadixNode256 *n = (const RadixNode256 *)node;
+        for (; *cursor < 256; (*cursor)++)
+        {
+            if (n->children[*cursor])
+            {
+                *byte = (unsigned char)*cursor;
+                return n->children[(*cursor)++];
+            }
+        }
+        return NULL;
+    }
+    }
+}
+
+/**
+ * @brief Smallest leaf below a child pointer; every leaf below a node shares its compressed path
+ */
+static RadixLeaf *minimumLeaf_radix(const void *child)
+{
+    while (!RADIX_IS_LEAF(child))
+    {
+        int cursor = 0;
+        unsigned char byte;
+
+        child = nextChild_radix((const RadixNode *)child, &cursor, &byte);
+    }
+    return RADIX_LEAF(child);
+}
+
+/**
+ * @brief The full compressed path of a node entered at depth
+ */
+static const unsigned char *prefixBytes_radix(const RadixNode *node, size_t depth)
+{
+    return node->prefixLength <= RADIX_MAX_PREFIX ? node->prefix : minimumLeaf_radix(node)->key + depth;
+}
+
+static bool leafMatches_radix(const RadixLeaf *leaf, const unsigned char *key, size_t length)
+{
+    return leaf->length == length && memcmp(leaf->key, key, length) == 0;
+}
+
+/**
+ * @brief Number of leading bytes of the node's stored prefix that match the key (optimistic check)
+ */
+static uint32_t checkPrefix_radix(const RadixNode *node, const unsigned char *key, size_t length, size_t depth)
+{
+    uint32_t limit = min_radix(min_radix(node->prefixLength, RADIX_MAX_PREFIX), (uint32_t)(length - depth));
+    uint32_t i = 0;
+
+    while (i < limit && node->prefix[i] == key[depth + i])
+        i++;
+    return i;
+}
+
+/**
+ * @brief Index of the first byte where the node's full compressed path differs from the key
+ */
+static uint32_t prefixMismatch_radix(const RadixNode *node, const unsigned char *key, size_t length, size_t depth)
+{
+    uint32_t i = checkPrefix_radix(node, key, length, depth);
+
+    if (i == RADIX_MAX_PREFIX && node->prefixLength > RADIX_MAX_PREFIX)
+    {
+        const RadixLeaf *leaf = minimumLeaf_radix(node);
+        uint32_t limit = (uint32_t)((leaf->length < length ? leaf->length : length) - depth);
+
+        while (i < limit && leaf->key[depth + i] == key[depth + i])
+            i++;
+    }
+    return i;
+}
+
+static bool addChild_radix(RadixTree *tree, RadixNode *node, void **ref, unsigned char byte, void *child);
+
+static bool addChild4_radix(RadixTree *tree, RadixNode4 *n, void **ref, unsigned char byte, void *child)
+{
+    if (n->header.count < 4)
+    {
+        int i = 0;
+
+        while (i < n->header.count && n->keys[i] < byte)
+            i++;
+        memmove(n->keys + i + 1, n->keys + i, n->header.count - i);
+        memmove(n->children + i + 1, n->children + i, (n->header.count - i) * sizeof(void *));
+        n->keys[i] = byte;
+        n->children[i] = child;
+        n->header.count++;
+        return true;
+    }
+
+    RadixNode16 *grown = (RadixNode16 *)allocNode_radix(tree, RADIX_NODE16);
+    if (!grown)
+        return false;
+    copyHeader_radix(&grown->header, &n->header);
+    memcpy(grown->keys, n->keys, 4);
+    memcpy(grown->children, n->children, 4 * sizeof(void *));
+    *ref = grown;
+    freeNode_radix(tree, &n->header);
+    return addChild_radix(tree, &grown->header, ref, byte, child);
+}
+
+static bool addChild16_radix(RadixTree *tree, RadixNode16 *n, void **ref, unsigned char byte, void *child)
+{
+    if (n->header.count < 16)
+    {
+        int i = 0;
+
+        while (i < n->header.count && n->keys[i] < byte)
+            i++;
+        memmove(n->keys + i + 1, n->keys + i, n->header.count - i);
+        memmove(n->children + i + 1, n->children + i, (n->header.count - i) * sizeof(void *));
+        n->keys[i] = byte;
+        n->children[i] = child;
+        n->header.count++;
+        return true;
+    }
+
+    RadixNode48 *grown = (RadixNode48 *)allocNode_radix(tree, RADIX_NODE48);
+    if (!grown)
+        return false;
+    copyHeader_radix(&grown->header, &n->header);
+    for (int i = 0; i < 16; i++)
+    {
+        grown->children[i] = n->children[i];
+        grown->index[n->keys[i]] = (unsigned char)(i + 1);
+    }
+    *ref = grown;
+    freeNode_radix(tree, &n->header);
+    return addChild_radix(tree, &grown->header, ref, byte, child);
+}
+
+static bool addChild48_radix(RadixTree *tree, RadixNode48 *n, void **ref, unsigned char byte, void *child)
+{
+    if (n->header.count < 48)
+    {
+        int slot = 0;
+
+        while (n->children[slot])
+            slot++;
+        n->children[slot] = child;
+        n->index[byte] = (unsigned char)(slot + 1);
+        n->header.count++;
+        return true;
+    }
+
+    RadixNode256 *grown = (RadixNode256 *)allocNode_radix(tree, RADIX_NODE256);
+    if (!grown)
+        return false;
+    copyHeader_radix(&grown->header, &n->header);
+    for (int b = 0; b < 256; b++)
+    {
+        if (n->index[b])
+            grown->children[b] = n->children[n->index[b] - 1];
+    }
+    *ref = grown;
+    freeNode_radix(tree, &n->header);
+    return addChild_radix(tree, &grown->header, ref, byte, child);
+}
+
+/**
+ * @brief Add a child for a byte the node has no child for, growing the node into *ref if it is full
+ *
+ * @return bool false if the node was full and the larger one could not be allocated; nothing changed then
+ */
+static bool addChild_radix(RadixTree *tree, RadixNode *node, void **ref, unsigned char byte, void *child)
+{
+    switch (node->type)
+    {
+    case RADIX_NODE4:
+        return addChild4_radix(tree, (RadixNode4 *)node, ref, byte, child);
+    case RADIX_NODE16:
+        return addChild16_radix(tree, (RadixNode16 *)node, ref, byte, child);
+    case RADIX_NODE48:
+        return addChild48_radix(tree, (RadixNode48 *)node, ref, byte, child);
+    default:
+        ((RadixNode256 *)node)->children[byte] = child;
+        node->count++;
+        return true;
+    }
+}
+
+/**
+ * @brief Replace a node left with a single child by that child, merging the node's path into it
+ */
+static void collapse_radix(RadixTree *tree, RadixNode *node, void **ref)
+{
+    int cursor = 0;
+    unsigned char byte;
+    void *child = nextChild_radix(node, &cursor, &byte);
+
+    if (!RADIX_IS_LEAF(child))
+    {
+        RadixNode *below = child;
+        uint32_t length = node->prefixLength;
+
+        if (length < RADIX_MAX_PREFIX)
+            node->prefix[length++] = byte;
+        if (length < RADIX_MAX_PREFIX)
+        {
+            uint32_t copied = min_radix(below->prefixLength, RADIX_MAX_PREFIX - length);
+            memcpy(node->prefix + length, below->prefix, copied);
+            length += copied;
+        }
+        memcpy(below->prefix, node->prefix, min_radix(length, RADIX_MAX_PREFIX));
+        below->prefixLength += node->prefixLength + 1;
+    }
+    *ref = child;
+    freeNode_radix(tree, node);
+}
+
+/**
+ * @brief Move a sparse node's children into a smaller node of the given type
+ *
+ * Out of memory, the node just stays larger than it needs to be; the next removal tries again.
+ */
+static void shrink_radix(RadixTree *tree, RadixNode *node, void **ref, uint8_t type)
+{
+    RadixNode *shrunk = allocNode_radix(tree, type);
+    int cursor = 0;
+    unsigned char byte;
+    void *child;
+
+    if (!shrunk)
+        return;
+
+    copyHeader_radix(shrunk, node);
+    shrunk->count = 0;
+    while ((child = nextChild_radix(node, &cursor, &byte)))
+        addChild_radix(tree, shrunk, ref, byte, child); // fits: never grows
+    *ref = shrunk;
+    freeNode_radix(tree, node);
+}
+
+/**
+ * @brief Remove the child in slot from the node, shrinking or collapsing the node into *ref when it gets sparse
+ */
+static void removeChild_radix(RadixTree *tree, RadixNode *node, void **ref, unsigned char byte, void **slot)
+{
+    switch (node->type)
+    {
+    case RADIX_NODE4:
+    {
+        RadixNode4 *n = (RadixNode4 *)node;
+        int i = (int)(slot - n->children);
+
+        memmove(n->keys + i, n->keys + i + 1, node->count - i - 1);
+        memmove(n->children + i, n->children + i + 1, (node->count - i - 1) * sizeof(void *));
+        break;
+    }
+    case RADIX_NODE16:
+    {
+        RadixNode16 *n = (RadixNode16 *)node;
+        int i = (int)(slot - n->children);
+
+        memmove(n->keys + i, n->keys + i + 1, node->count - i - 1);
+        memmove(n->children + i, n->children + i + 1, (node->count - i - 1) * sizeof(void *));
+        break;
+    }
+    case RADIX_NODE48:
+    {
+        RadixNode48 *n = (RadixNode48 *)node;
+
+        n->children[n->index[byte] - 1] = NULL;
+        n->index[byte] = 0;
+        break;
+    }
+    default:
+        ((RadixNode256 *)node)->children[byte] = NULL;
+        break;
+    }
+    node->count--;
+
+    // a single child left, whatever the node type (a shrink may have failed for lack of memory)
+    if (node->count == 1)
+        collapse_radix(tree, node, ref);
+    else if (node->type == RADIX_NODE16 && node->count <= 3)
+        shrink_radix(tree, node, ref, RADIX_NODE4);
+    else if (node->type == RADIX_NODE48 && node->count <= 12)
+        shrink_radix(tree, node, ref, RADIX_NODE16);
+    else if (node->type == RADIX_NODE256 && node->count <= 37)
+        shrink_radix(tree, node, ref, RADIX_NODE48);
+}
+
+/**
+ * @brief A tagged leaf, not yet linked into the tree, or NULL if out of memory
+ */
+static void *makeLeaf_radix(RadixTree *tree, const unsigned char *key, size_t length, void *value)
+{
+    RadixLeaf *leaf = alloc_radix(tree, sizeof(RadixLeaf));
+
+    if (!leaf)
+        return NULL;
+    leaf->key = key;
+    leaf->length = length;
+    leaf->value = value;
+    tree->bytes += sizeof(RadixLeaf);
+    tree->size++;
+    return RADIX_TAG_LEAF(leaf);
+}
+
+static void freeLeaf_radix(RadixTree *tree, RadixLeaf *leaf)
+{
+    tree->bytes -= sizeof(RadixLeaf);
+    tree->size--;
+    release_radix(tree, leaf);
+}
+
+static void freeSubtree_radix(const RadixTree *tree, void *child)
+{
+    if (!child)
+        return;
+
+    if (!RADIX_IS_LEAF(child))
+    {
+        int cursor = 0;
+        unsigned char byte;
+        void *below;
+
+        while ((below = nextChild_radix(child, &cursor, &byte)))
+            freeSubtree_radix(tree, below);
+    }
+    release_radix(tree, RADIX_IS_LEAF(child) ? (void *)RADIX_LEAF(child) : child);
+}
+
+void radixTreeInit(RadixTree *tree)
+{
+    memset(tree, 0, sizeof(*tree));
+}
+
+/**
+ * @brief Initialise an empty tree that takes its nodes and leaves from the caller's allocator
+ *
+ * @param allocFn Returns size bytes, or NULL if out of memory
+ * @param freeFn Releases a block, or NULL to never free one by one, for arenas released as a whole
+ * @param ctx User pointer passed to both
+ */
+void radixTreeInitWithAllocator(RadixTree *tree, RadixAllocFn allocFn, RadixFreeFn freeFn, void *ctx)
+{
+    radixTreeInit(tree);
+    tree->alloc = allocFn;
+    tree->free = allocFn ? freeFn : NULL;
+    tree->allocCtx = ctx;
+}
+
+/**
+ * @brief Free every node and leaf, leaving an empty tree with the same allocator; keys and values belong to the caller and are left alone
+ */
+void radixTreeFree(RadixTree *tree)
+{
+    if (!tree->alloc || tree->free)
+        freeSubtree_radix(tree, tree->root);
+    tree->root = NULL;
+    tree->size = 0;
+    tree->bytes = 0;
+}
+
+/**
+ * @brief Add a key unless it is already present
+ *
+ * Every block the insert needs is allocated before the tree is touched, so running out of memory
+ * leaves the tree as it was.
+ *
+ * @param tree Tree to insert into
+ * @param key Key to add; the pointer is kept and must stay valid until the key is removed
+ * @param value Value stored with the key
+ * @return void* NULL if the key was added, RADIX_TREE_NO_MEMORY if it could not be, otherwise the
+ *               value already stored (left unchanged)
+ */
+void *radixTreeInsert(RadixTree *tree, const char *key, void *value)
+{
+    const unsigned char *bytes = (const unsigned char *)key;
+    size_t length = strlen(key) + 1;
+    void **ref = &tree->root;
+    size_t depth = 0;
+    void *leaf = NULL;
+
+    while (*ref)
+    {
+        if (RADIX_IS_LEAF(*ref))
+        {
+            RadixLeaf *existing = RADIX_LEAF(*ref);
+
+            if (leafMatches_radix(existing, bytes, length))
+                return existing->value;
+
+            // two leaves: split at their longest common prefix
+            RadixNode *split = allocNode_radix(tree, RADIX_NODE4);
+            void *oldLeaf = *ref;
+            uint32_t common = 0;
+
+            if (!split)
+                return RADIX_TREE_NO_MEMORY;
+            if (!(leaf = makeLeaf_radix(tree, bytes, length, value)))
+            {
+                freeNode_radix(tree, split);
+                return RADIX_TREE_NO_MEMORY;
+            }
+
+            while (existing->key[depth + common] == bytes[depth + common])
+                common++;
+
+            split->prefixLength = common;
+            memcpy(split->prefix, bytes + depth, min_radix(common, RADIX_MAX_PREFIX));
+            *ref = split;
+            addChild_radix(tree, split, ref, existing->key[depth + common], oldLeaf);
+            addChild_radix(tree, split, ref, bytes[depth + common], leaf);
+            return NULL;
+        }
+
+        RadixNode *node = *ref;
+
+        if (node->prefixLength)
+        {
+            uint32_t mismatch = prefixMismatch_radix(node, bytes, length, depth);
+
+            if (mismatch < node->prefixLength)
+            {
+                // the key leaves the compressed path: split it with a new node at the mismatch
+                RadixNode *split = allocNode_radix(tree, RADIX_NODE4);
+                unsigned char nodeByte;
+
+                if (!split)
+                    return RADIX_TREE_NO_MEMORY;
+                if (!(leaf = makeLeaf_radix(tree, bytes, length, value)))
+                {
+                    freeNode_radix(tree, split);
+                    return RADIX_TREE_NO_MEMORY;
+                }
+
+                split->prefixLength = mismatch;
+                memcpy(split->prefix, node->prefix, min_radix(mismatch, RADIX_MAX_PREFIX));
+
+                if (node->prefixLength <= RADIX_MAX_PREFIX)
+                {
+                    nodeByte = node->prefix[mismatch];
+                    node->prefixLength -= mismatch + 1;
+                    memmove(node->prefix, node->prefix + mismatch + 1, min_radix(node->prefixLength, RADIX_MAX_PREFIX));
+                }
+                else
+                {
+                    const RadixLeaf *first = minimumLeaf_radix(node);
+
+                    nodeByte = first->key[depth + mismatch];
+                    node->prefixLength -= mismatch + 1;
+                    memcpy(node->prefix, first->key + depth + mismatch + 1, min_radix(node->prefixLength, RADIX_MAX_PREFIX));
+                }
+
+                *ref = split;
+                addChild_radix(tree, split, ref, nodeByte, node);
+                addChild_radix(tree, split, ref, bytes[depth + mismatch], leaf);
+                return NULL;
+            }
+            depth += node->prefixLength;
+        }
+
+        void **child = findChild_radix(node, bytes[depth]);
+        if (!child)
+        {
+            if (!(leaf = makeLeaf_radix(tree, bytes, length, value)))
+                return RADIX_TREE_NO_MEMORY;
+            if (!addChild_radix(tree, node, ref, bytes[depth], leaf))
+            {
+                freeLeaf_radix(tree, RADIX_LEAF(leaf));
+                return RADIX_TREE_NO_MEMORY;
+            }
+            return NULL;
+        }
+        ref = child;
+        depth++;
+    }
+
+    if (!(*ref = makeLeaf_radix(tree, bytes, length, value)))
+        return RADIX_TREE_NO_MEMORY;
+    return NULL;
+}
+
+static RadixLeaf *findLeaf_radix(const RadixTree *tree, const char *key)
+{
+    const unsigned char *bytes = (const unsigned char *)key;
+    size_t length = strlen(key) + 1;
+    void *child = tree->root;
+    size_t depth = 0;
+
+    while (child)
+    {
+        if (RADIX_IS_LEAF(child))
+            return leafMatches_radix(RADIX_LEAF(child), bytes, length) ? RADIX_LEAF(child) : NULL;
+
+        RadixNode *node = child;
+        if (node->prefixLength)
+        {
+            // optimistic: bytes past RADIX_MAX_PREFIX are verified by the leaf comparison
+            if (checkPrefix_radix(node, bytes, length, depth) != min_radix(node->prefixLength, RADIX_MAX_PREFIX))
+                return NULL;
+            depth += node->prefixLength;
+        }
+        if (depth >= length)
+            return NULL;
+
+        void **slot = findChild_radix(node, bytes[depth]);
+        child = slot ? *slot : NULL;
+        depth++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Look up a key
+ *
+ * @return void* Value stored with the key, or NULL if absent
+ */
+void *radixTreeSearch(const RadixTree *tree, const char *key)
+{
+    RadixLeaf *leaf = findLeaf_radix(tree, key);
+
+    return leaf ? leaf->value : NULL;
+}
+
+/**
+ * @brief Store a new value and key pointer for a key already present, without allocating
+ *
+ * @param key Key to look up; its pointer replaces the stored one and must stay valid until the key is removed
+ * @return void* Value that was stored with the key, or NULL if absent (nothing is added then)
+ */
+void *radixTreeReplace(RadixTree *tree, const char *key, void *value)
+{
+    RadixLeaf *leaf = findLeaf_radix(tree, key);
+    void *previous;
+
+    if (!leaf)
+        return NULL;
+    previous = leaf->value;
+    leaf->key = (const unsigned char *)key;
+    leaf->value = value;
+    return previous;
+}
+
+/**
+ * @brief Remove a key
+ *
+ * @return void* Value that was stored with the key, or NULL if it was absent
+ */
+void *radixTreeRemove(RadixTree *tree, const char *key)
+{
+    const unsigned char *bytes = (const unsigned char *)key;
+    size_t length = strlen(key) + 1;
+    void **ref = &tree->root;
+    size_t depth = 0;
+
+    if (!*ref)
+        return NULL;
+
+    if (RADIX_IS_LEAF(*ref))
+    {
+        RadixLeaf *leaf = RADIX_LEAF(*ref);
+        void *value = leaf->value;
+
+        if (!leafMatches_radix(leaf, bytes, length))
+            return NULL;
+        *ref = NULL;
+        freeLeaf_radix(tree, leaf);
+        return value;
+    }
+
+    for (;;)
+    {
+        RadixNode *node = *ref;
+
+        if (node->prefixLength)
+        {
+            if (checkPrefix_radix(node, bytes, length, depth) != min_radix(node->prefixLength, RADIX_MAX_PREFIX))
+                return NULL;
+            depth += node->prefixLength;
+        }
+        if (depth >= length)
+            return NULL;
+
+        void **child = findChild_radix(node, bytes[depth]);
+        if (!child)
+            return NULL;
+
+        if (RADIX_IS_LEAF(*child))
+        {
+            RadixLeaf *leaf = RADIX_LEAF(*child);
+            void *value = leaf->value;
+
+            if (!leafMatches_radix(leaf, bytes, length))
+                return NULL;
+            removeChild_radix(tree, node, ref, bytes[depth], child);
+            freeLeaf_radix(tree, leaf);
+            return value;
+        }
+
+        ref = child;
+        depth++;
+    }
+}
+
+typedef struct RadixWalk
+{
+    RadixVisitor visitor;
+    void *ctx;
+    size_t visited;
+    const unsigned char *lo; /**< Inclusive lower bound, or NULL */
+    const unsigned char *hi; /**< Exclusive upper bound, or NULL */
+} RadixWalk;
+
+static bool visitLeaf_radix(RadixWalk *walk, const RadixLeaf *leaf)
+{
+    walk->visited++;
+    return walk->visitor((const char *)leaf->key, leaf->value, walk->ctx);
+}
+
+/**
+ * @brief Visit every leaf below a child pointer in order
+ *
+ * @return bool false if the visitor stopped the iteration
+ */
+static bool walkAll_radix(RadixWalk *walk, const void *child)
+{
+    if (RADIX_IS_LEAF(child))
+        return visitLeaf_radix(walk, RADIX_LEAF(child));
+
+    int cursor = 0;
+    unsigned char byte;
+    const void *below;
+
+    while ((below = nextChild_radix(child, &cursor, &byte)))
+    {
+        if (!walkAll_radix(walk, below))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Visit the leaves below a child pointer that fall inside [lo, hi)
+ *
+ * loTight and hiTight say whether the path so far equals the bound's first depth bytes; once it
+ * diverges from a bound, that bound no longer constrains the subtree and is not compared again.
+ *
+ * @return bool false once the iteration is over, because the visitor stopped it or hi was reached
+ */
+static bool walkRange_radix(RadixWalk *walk, const void *child, size_t depth, bool loTight, bool hiTight)
+{
+    if (!loTight && !hiTight)
+        return walkAll_radix(walk, child);
+
+    if (RADIX_IS_LEAF(child))
+    {
+        const RadixLeaf *leaf = RADIX_LEAF(child);
+
+        if (walk->lo && strcmp((const char *)leaf->key, (const char *)walk->lo) < 0)
+            return true;
+        if (walk->hi && strcmp((const char *)leaf->key, (const char *)walk->hi) >= 0)
+            return false;
+        return visitLeaf_radix(walk, leaf);
+    }
+
+    const RadixNode *node = child;
+    const unsigned char *path = prefixBytes_radix(node, depth);
+
+    for (uint32_t i = 0; i < node->prefixLength && (loTight || hiTight); i++)
+    {
+        if (loTight)
+        {
+            if (path[i] < walk->lo[depth + i])
+                return true; // the whole subtree sorts before lo
+            loTight = path[i] == walk->lo[depth + i];
+        }
+        if (hiTight)
+        {
+            if (path[i] > walk->hi[depth + i])
+                return false; // the whole subtree, and everything after it, sorts after hi
+            hiTight = path[i] == walk->hi[depth + i];
+        }
+    }
+    depth += node->prefixLength;
+
+    int cursor = 0;
+    unsigned char byte;
+    const void *below;
+
+    while ((below = nextChild_radix(node, &cursor, &byte)))
+    {
+        bool childLo = loTight;
+        bool childHi = hiTight;
+
+        if (loTight)
+        {
+            if (byte < walk->lo[depth])
+                continue;
+            childLo = byte == walk->lo[depth];
+        }
+        if (hiTight)
+        {
+            if (byte > walk->hi[depth])
+                return false;
+            childHi = byte == walk->hi[depth];
+        }
+        if (!walkRange_radix(walk, below, depth + 1, childLo, childHi))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Visit the keys in [lo, hi) in strcmp order
+ *
+ * Subtrees outside the bounds are skipped on their path bytes alone, so the cost is the depth of
+ * the bounds plus the number of keys visited.
+ *
+ * @param tree Tree to iterate
+ * @param lo Smallest key to visit, or NULL to start at the first key
+ * @param hi Key to stop before, or NULL to run to the last key
+ * @param visitor Called for every key in range until it returns false
+ * @param ctx User pointer passed to visitor
+ * @return size_t Number of keys passed to visitor
+ */
+size_t radixTreeRange(const RadixTree *tree, const char *lo, const char *hi, RadixVisitor visitor, void *ctx)
+{
+    RadixWalk walk = {visitor, ctx, 0, (const unsigned char *)lo, (const unsigned char *)hi};
+
+    if (tree->root)
+        walkRange_radix(&walk, tree->root, 0, lo != NULL, hi != NULL);
+    return walk.visited;
+}
+
+/**
+ * @brief Visit the keys starting with prefix in strcmp order
+ *
+ * Descends along the prefix and then walks the subtree below it, so the cost is the prefix length
+ * plus the number of matching keys.
+ *
+ * @param tree Tree to iterate
+ * @param prefix Leading bytes every visited key starts with; "" visits every key
+ * @param visitor Called for every matching key until it returns false
+ * @param ctx User pointer passed to visitor
+ * @return size_t Number of keys passed to visitor
+ */
+size_t radixTreePrefix(const RadixTree *tree, const char *prefix, RadixVisitor visitor, void *ctx)
+{
+    RadixWalk walk = {visitor, ctx, 0, NULL, NULL};
+    const unsigned char *bytes = (const unsigned char *)prefix;
+    size_t length = strlen(prefix);
+    const void *child = tree->root;
+    size_t depth = 0;
+
+    while (child)
+    {
+        if (RADIX_IS_LEAF(child))
+        {
+            const RadixLeaf *leaf = RADIX_LEAF(child);
+
+            if (leaf->length > length && memcmp(leaf->key, bytes, length) == 0)
+                visitLeaf_radix(&walk, leaf);
+            break;
+        }
+
+        const RadixNode *node = child;
+        if (depth >= length)
+        {
+            walkAll_radix(&walk, node);
+            break;
+        }
+
+        const unsigned char *path = prefixBytes_radix(node, depth);
+        uint32_t i = 0;
+
+        while (i < node->prefixLength && depth + i < length && path[i] == bytes[depth + i])
+            i++;
+        if (depth + i >= length)
+        {
+            walkAll_radix(&walk, node); // the prefix ends inside this node's path
+            break;
+        }
+        if (i < node->prefixLength)
+            break; // the path diverges from the prefix
+
+        depth += node->prefixLength;
+        void **slot = findChild_radix((RadixNode *)node, bytes[depth]);
+        child = slot ? *slot : NULL;
+        depth++;
+    }
+    return walk.visited;
+}
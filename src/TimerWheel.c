@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "../include/TimerWheel.h"
+#include <string.h>
+#include <time.h>
+
+#define LEVEL_SHIFT(level) ((level) * TIMER_WHEEL_SLOT_BITS)
+#define LEVEL_MASK(level) ((1ull << LEVEL_SHIFT(level)) - 1)
+
+static void pushSlot_wheel(WheelTimer **head, WheelTimer *timer)
+{
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head)
+        (*head)->prev = timer;
+    *head = timer;
+}
+
+/**
+ * @brief Place a timer in the level whose span covers its distance from the current tick
+ */
+static void place_wheel(TimerWheel *wheel, WheelTimer *timer)
+{
+    uint64_t expireAt = timer->expireAt < wheel->current ? wheel->current : timer->expireAt;
+    uint64_t delta = expireAt - wheel->current;
+    unsigned int level = 0;
+
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ull << LEVEL_SHIFT(level + 1)))
+        level++;
+
+    // beyond the top level's span: park in its last slot and re-place when that slot cascades
+    if (delta >= (1ull << LEVEL_SHIFT(TIMER_WHEEL_LEVELS)))
+        expireAt = wheel->current + (1ull << LEVEL_SHIFT(TIMER_WHEEL_LEVELS)) - 1;
+
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)((expireAt >> LEVEL_SHIFT(level)) & (TIMER_WHEEL_SLOTS - 1));
+    pushSlot_wheel(&wheel->slots[level][timer->slot], timer);
+    wheel->levelCount[level]++;
+}
+
+/**
+ * @brief Re-place every timer of one slot relative to the current tick
+ */
+static void cascade_wheel(TimerWheel *wheel, unsigned int level, unsigned int slot)
+{
+    WheelTimer *timer = wheel->slots[level][slot];
+
+    wheel->slots[level][slot] = NULL;
+    while (timer)
+    {
+        WheelTimer *next = timer->next;
+
+        wheel->levelCount[level]--;
+        place_wheel(wheel, timer);
+        timer = next;
+    }
+}
+
+/**
+ * @brief Reset the wheel so that its first tick is nowMs
+ *
+ * @param wheel Wheel to initialise
+ * @param nowMs Current time in milliseconds, usually timerWheelNowMs()
+ */
+void timerWheelInit(TimerWheel *wheel, uint64_t nowMs)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->current = nowMs;
+}
+
+/**
+ * @brief Schedule a timer, or reschedule it if it is already in the wheel
+ *
+ * @param wheel Wheel to schedule on
+ * @param timer Caller-owned timer
+ * @param expireAt Absolute expiry time in milliseconds; times in the past fire on the next advance
+ */
+void timerWheelSchedule(TimerWheel *wheel, WheelTimer *timer, uint64_t expireAt)
+{
+    timer->expireAt = expireAt;
+    place_wheel(wheel, timer);
+}
+
+/**
+ * @brief Remove a scheduled or fired timer from the wheel
+ *
+ * @param wheel Wheel the timer belongs to
+ * @param timer Timer to remove; the caller may free it afterwards
+ */
+void timerWheelCancel(TimerWheel *wheel, WheelTimer *timer)
+{
+    WheelTimer **head;
+
+    if (timer->level == TIMER_WHEEL_DUE)
+    {
+        head = &wheel->due;
+        wheel->dueCount--;
+    }
+    else
+    {
+        head = &wheel->slots[timer->level][timer->slot];
+        wheel->levelCount[timer->level]--;
+    }
+
+    if (timer->prev)
+        timer->prev->next = timer->next;
+    else
+        *head = timer->next;
+    if (timer->next)
+        timer->next->prev = timer->prev;
+
+    timer->prev = timer->next = NULL;
+}
+
+/**
+ * @brief Process ticks up to nowMs, moving fired timers to the due list
+ *
+ * Stops early once maxDue timers are waiting, so a caller with a work budget never pays for more
+ * expirations than it will consume; the remaining ticks are processed by the next call.
+ *
+ * @param wheel Wheel to advance
+ * @param nowMs Current time in milliseconds
+ * @param maxDue Stop when the due list holds this many timers
+ */
+void timerWheelAdvance(TimerWheel *wheel, uint64_t nowMs, size_t maxDue)
+{
+    while (wheel->current <= nowMs && wheel->dueCount < maxDue)
+    {
+        uint64_t tick = wheel->current;
+
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+        {
+            if ((tick & LEVEL_MASK(level)) == 0 && wheel->levelCount[level])
+                cascade_wheel(wheel, (unsigned int)level, (unsigned int)((tick >> LEVEL_SHIFT(level)) & (TIMER_WHEEL_SLOTS - 1)));
+        }
+
+        WheelTimer **slot = &wheel->slots[0][tick & (TIMER_WHEEL_SLOTS - 1)];
+        while (*slot)
+        {
+            WheelTimer *timer = *slot;
+
+            *slot = timer->next;
+            if (*slot)
+                (*slot)->prev = NULL;
+            wheel->levelCount[0]--;
+            timer->level = TIMER_WHEEL_DUE;
+            pushSlot_wheel(&wheel->due, timer);
+            wheel->dueCount++;
+        }
+
+        // jump over ticks whose levels are empty, stopping at the next boundary that has something to cascade
+        uint64_t next = tick + 1;
+        if (wheel->levelCount[0] == 0)
+        {
+            int level = 1;
+
+            while (level < TIMER_WHEEL_LEVELS && wheel->levelCount[level] == 0)
+                level++;
+            next = level < TIMER_WHEEL_LEVELS ? (tick | LEVEL_MASK(level)) + 1 : nowMs + 1;
+        }
+        wheel->current = next < nowMs + 1 ? next : nowMs + 1;
+    }
+}
+
+/**
+ * @brief Take one fired timer from the due list
+ *
+ * @return WheelTimer* A fired timer no longer linked into the wheel, or NULL if none is due
+ */
+WheelTimer *timerWheelPopDue(TimerWheel *wheel)
+{
+    WheelTimer *timer = wheel->due;
+
+    if (timer)
+        timerWheelCancel(wheel, timer);
+    return timer;
+}
+
+/**
+ * @brief Monotonic clock in milliseconds
+ */
+uint64_t timerWheelNowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
@@ -0,0 +1,221 @@
+#include "../include/Trace.h"
+#include <string.h>
+
+static size_t putVarint_trace(unsigned char *out, uint64_t value)
+{
+    size_t n = 0;
+
+    while (value >= 0x80)
+    {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+static bool getVarint_trace(FILE *file, uint64_t *value)
+{
+    uint64_t result = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = fgetc(file);
+
+        if (byte == EOF)
+            return false;
+
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Create a trace file and write its header
+ *
+ * @param path File to create or truncate
+ * @return TraceWriter* New writer, or NULL if the file cannot be opened
+ */
+TraceWriter *traceWriterOpen(const char *path)
+{
+    TraceWriter *writer = malloc(sizeof(TraceWriter));
+    double ticksPerSecond = cycleCounterFrequency();
+
+    if (!writer)
+        return NULL;
+
+    writer->file = fopen(path, "wb");
+    if (!writer->file)
+    {
+        free(writer);
+        return NULL;
+    }
+
+    memcpy(writer->buffer, TRACE_MAGIC, 8);
+    memcpy(writer->buffer + 8, &ticksPerSecond, sizeof(double));
+    writer->used = 8 + sizeof(double);
+    writer->records = 0;
+    writer->lastTicks = cycleCounter();
+
+    return writer;
+}
+
+/**
+ * @brief Append one operation to the trace
+ *
+ * Only copies into the in-memory buffer; the file is written when the buffer fills up.
+ *
+ * @param writer Trace to append to
+ * @param op Operation kind
+ * @param key Key the operation was called with, or NULL for whole-table operations
+ * @param value Value passed to insert/update, or NULL; only its length is recorded
+ */
+void traceWriterRecord(TraceWriter *writer, DictOp op, const char *key, const char *value)
+{
+    uint64_t now = cycleCounter();
+    size_t keyLength = key ? strlen(key) : 0;
+    size_t valueLength = value ? strlen(value) : 0;
+
+    // op byte plus three varints of at most 10 bytes each
+    if (writer->used + keyLength + 31 > TRACE_BUFFER_SIZE)
+        traceWriterFlush(writer);
+
+    unsigned char *out = writer->buffer + writer->used;
+    size_t n = 0;
+
+    out[n++] = (unsigned char)op;
+    n += putVarint_trace(out + n, now - writer->lastTicks);
+    n += putVarint_trace(out + n, keyLength);
+
+    if (writer->used + n + keyLength + 10 > TRACE_BUFFER_SIZE)
+    {
+        // key larger than the whole buffer: write the header and the key straight through
+        fwrite(writer->buffer, 1, writer->used + n, writer->file);
+        fwrite(key, 1, keyLength, writer->file);
+        writer->used = 0;
+        n = 0;
+        out = writer->buffer;
+    }
+    else if (keyLength)
+    {
+        memcpy(out + n, key, keyLength);
+        n += keyLength;
+    }
+
+    n += putVarint_trace(out + n, valueLength);
+    writer->used += n;
+    writer->lastTicks = now;
+    writer->records++;
+}
+
+/**
+ * @brief Write buffered records to the file
+ *
+ * @return bool false on a write error
+ */
+bool traceWriterFlush(TraceWriter *writer)
+{
+    bool ok = fwrite(writer->buffer, 1, writer->used, writer->file) == writer->used;
+
+    writer->used = 0;
+    return ok && fflush(writer->file) == 0;
+}
+
+/**
+ * @brief Flush and close the trace, releasing the writer
+ *
+ * @return bool false if any buffered data could not be written
+ */
+bool traceWriterClose(TraceWriter *writer)
+{
+    if (!writer)
+        return true;
+
+    bool ok = traceWriterFlush(writer);
+    ok = fclose(writer->file) == 0 && ok;
+    free(writer);
+    return ok;
+}
+
+/**
+ * @brief Open a trace for reading and validate its header
+ *
+ * @param path Trace file written by TraceWriter
+ * @return TraceReader* New reader, or NULL if the file is missing or not a trace
+ */
+TraceReader *traceReaderOpen(const char *path)
+{
+    TraceReader *reader = calloc(1, sizeof(TraceReader));
+    char magic[8];
+
+    if (!reader)
+        return NULL;
+
+    reader->file = fopen(path, "rb");
+    if (!reader->file || fread(magic, 1, 8, reader->file) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0 ||
+        fread(&reader->ticksPerSecond, sizeof(double), 1, reader->file) != 1)
+    {
+        traceReaderClose(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+/**
+ * @brief Decode the next record
+ *
+ * @param reader Trace to read from
+ * @param record Receives the record; its key stays valid until the next call
+ * @return bool false at the end of the trace or on a truncated record
+ */
+bool traceReaderNext(TraceReader *reader, TraceRecord *record)
+{
+    int op = fgetc(reader->file);
+    uint64_t delta, keyLength, valueLength;
+
+    if (op == EOF || op >= DICT_OP_COUNT || !getVarint_trace(reader->file, &delta) ||
+        !getVarint_trace(reader->file, &keyLength))
+        return false;
+
+    if (keyLength + 1 > reader->keyCapacity)
+    {
+        char *grown = realloc(reader->key, keyLength + 1);
+
+        if (!grown)
+            return false;
+        reader->key = grown;
+        reader->keyCapacity = keyLength + 1;
+    }
+
+    if (fread(reader->key, 1, keyLength, reader->file) != keyLength || !getVarint_trace(reader->file, &valueLength))
+        return false;
+
+    reader->key[keyLength] = '\0';
+    reader->ticks += delta;
+
+    record->op = (DictOp)op;
+    record->ticks = reader->ticks;
+    record->key = reader->key;
+    record->keyLength = keyLength;
+    record->valueLength = valueLength;
+    return true;
+}
+
+/**
+ * @brief Close the trace and release the reader
+ */
+void traceReaderClose(TraceReader *reader)
+{
+    if (!reader)
+        return;
+
+    if (reader->file)
+        fclose(reader->file);
+    free(reader->key);
+    free(reader);
+}
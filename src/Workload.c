@@ -0,0 +1,420 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "../include/Workload.h"
+#include <math.h>
+#include <time.h>
+
+static uint64_t fnv64_workload(uint64_t value)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (int i = 0; i < 8; i++)
+    {
+        hash ^= value & 0xFF;
+        hash *= 0x100000001B3ull;
+        value >>= 8;
+    }
+    return hash;
+}
+
+static inline uint64_t rotl_workload(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief Seed a xoshiro256** generator, expanding the seed with splitmix64 as its authors recommend
+ *
+ * @param rng Generator to seed
+ * @param seed Any 64-bit value, including zero
+ */
+void xoshiroSeed(Xoshiro256 *rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        rng->s[i] = z ^ (z >> 31);
+    }
+}
+
+/**
+ * @brief Next 64 random bits from xoshiro256**
+ */
+uint64_t xoshiroNext(Xoshiro256 *rng)
+{
+    uint64_t *s = rng->s;
+    uint64_t result = rotl_workload(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl_workload(s[3], 45);
+
+    return result;
+}
+
+/**
+ * @brief Uniform double in [0, 1)
+ */
+double xoshiroNextDouble(Xoshiro256 *rng)
+{
+    return (double)(xoshiroNext(rng) >> 11) * 0x1.0p-53;
+}
+
+static double zeta_workload(uint64_t from, uint64_t to, double theta, double initial)
+{
+    double sum = initial;
+
+    for (uint64_t i = from; i < to; i++)
+        sum += 1.0 / pow((double)(i + 1), theta);
+    return sum;
+}
+
+/**
+ * @brief Prepare a Zipfian generator; costs O(itemCount) once to compute the zeta constant
+ *
+ * @param zipfian Generator to initialise
+ * @param itemCount Number of items, ranks are drawn from [0, itemCount)
+ * @param theta Skew in (0, 1); YCSB uses 0.99
+ */
+void zipfianInit(Zipfian *zipfian, uint64_t itemCount, double theta)
+{
+    zipfian->theta = theta;
+    zipfian->alpha = 1.0 / (1.0 - theta);
+    zipfian->zeta2 = zeta_workload(0, 2, theta, 0.0);
+    zipfian->zetaN = zeta_workload(0, itemCount, theta, 0.0);
+    zipfian->itemCount = itemCount;
+    zipfian->eta = (1.0 - pow(2.0 / (double)itemCount, 1.0 - theta)) / (1.0 - zipfian->zeta2 / zipfian->zetaN);
+}
+
+/**
+ * @brief Draw a rank, 0 being the most popular
+ *
+ * When itemCount grows (records were inserted) the zeta constant is extended incrementally,
+ * so the cost is proportional to the number of new items, not the total.
+ *
+ * @param zipfian Generator
+ * @param rng Random source
+ * @param itemCount Current number of items
+ * @return uint64_t Rank in [0, itemCount)
+ */
+uint64_t zipfianNext(Zipfian *zipfian, Xoshiro256 *rng, uint64_t itemCount)
+{
+    if (itemCount > zipfian->itemCount)
+    {
+        zipfian->zetaN = zeta_workload(zipfian->itemCount, itemCount, zipfian->theta, zipfian->zetaN);
+        zipfian->itemCount = itemCount;
+        zipfian->eta = (1.0 - pow(2.0 / (double)itemCount, 1.0 - zipfian->theta)) / (1.0 - zipfian->zeta2 / zipfian->zetaN);
+    }
+
+    double u = xoshiroNextDouble(rng);
+    double uz = u * zipfian->zetaN;
+
+    if (uz < 1.0)
+        return 0;
+    if (uz < 1.0 + pow(0.5, zipfian->theta))
+        return 1 < itemCount ? 1 : 0;
+
+    uint64_t rank = (uint64_t)((double)itemCount * pow(zipfian->eta * u - zipfian->eta + 1.0, zipfian->alpha));
+    return rank < itemCount ? rank : itemCount - 1;
+}
+
+/**
+ * @brief Fill in the operation mix and distribution of a YCSB core workload
+ *
+ * A: 50% read, 50% update, Zipfian. B: 95% read, 5% update, Zipfian. C: 100% read, Zipfian.
+ * D: 95% read, 5% insert, latest. E: 95% scan, 5% insert, Zipfian. F: 50% read, 50% read-modify-write, Zipfian.
+ * Record count, operation count, key/value lengths and seed are left untouched.
+ *
+ * @param config Configuration to update
+ * @param name Workload letter, 'A' to 'F' (case-insensitive)
+ * @return bool false if the letter is not a known workload
+ */
+bool workloadPreset(WorkloadConfig *config, char name)
+{
+    config->readProportion = 0.0;
+    config->updateProportion = 0.0;
+    config->insertProportion = 0.0;
+    config->scanProportion = 0.0;
+    config->readModifyWriteProportion = 0.0;
+    config->distribution = WORKLOAD_ZIPFIAN;
+
+    switch (name)
+    {
+    case 'A': case 'a':
+        config->readProportion = 0.5;
+        config->updateProportion = 0.5;
+        return true;
+    case 'B': case 'b':
+        config->readProportion = 0.95;
+        config->updateProportion = 0.05;
+        return true;
+    case 'C': case 'c':
+        config->readProportion = 1.0;
+        return true;
+    case 'D': case 'd':
+        config->readProportion = 0.95;
+        config->insertProportion = 0.05;
+        config->distribution = WORKLOAD_LATEST;
+        return true;
+    case 'E': case 'e':
+        config->scanProportion = 0.95;
+        config->insertProportion = 0.05;
+        return true;
+    case 'F': case 'f':
+        config->readProportion = 0.5;
+        config->readModifyWriteProportion = 0.5;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Lower-case name of an operation kind, for reports
+ */
+const char *workloadOpName(WorkloadOp op)
+{
+    static const char *names[WORKLOAD_OP_COUNT] = {"read", "update", "insert", "scan", "read_modify_write"};
+    return op < WORKLOAD_OP_COUNT ? names[op] : "unknown";
+}
+
+/**
+ * @brief Create a generator for the given configuration
+ *
+ * Allocates the key and value buffers once; nothing is allocated while generating.
+ *
+ * @param config Workload parameters; copied
+ * @return Workload* New generator, or NULL on allocation failure
+ */
+Workload *createWorkload(const WorkloadConfig *config)
+{
+    Workload *workload = calloc(1, sizeof(Workload));
+
+    if (!workload)
+        return NULL;
+
+    workload->config = *config;
+    if (workload->config.keyLength < WORKLOAD_MIN_KEY_LENGTH)
+        workload->config.keyLength = WORKLOAD_MIN_KEY_LENGTH;
+    if (workload->config.valueLength < 1)
+        workload->config.valueLength = 1;
+    if (workload->config.maxScanLength < 1)
+        workload->config.maxScanLength = 1;
+
+    xoshiroSeed(&workload->rng, config->seed);
+    zipfianInit(&workload->zipfian, config->recordCount ? config->recordCount : 1, config->zipfianTheta);
+
+    workload->keyBuffer = malloc((size_t)workload->config.keyLength + 1);
+    workload->valueBuffer = malloc((size_t)workload->config.valueLength + 1);
+    if (!workload->keyBuffer || !workload->valueBuffer)
+    {
+        destroyWorkload(workload);
+        return NULL;
+    }
+
+    memset(workload->keyBuffer, 'x', (size_t)workload->config.keyLength);
+    memcpy(workload->keyBuffer, "user", 4);
+    workload->keyBuffer[workload->config.keyLength] = '\0';
+    workload->valueBuffer[workload->config.valueLength] = '\0';
+
+    return workload;
+}
+
+/**
+ * @brief Release a generator created by createWorkload
+ */
+void destroyWorkload(Workload *workload)
+{
+    if (!workload)
+        return;
+
+    free(workload->keyBuffer);
+    free(workload->valueBuffer);
+    free(workload);
+}
+
+/**
+ * @brief Pick the kind of the next operation according to the configured proportions
+ */
+WorkloadOp workloadNextOp(Workload *workload)
+{
+    const WorkloadConfig *c = &workload->config;
+    double u = xoshiroNextDouble(&workload->rng) *
+               (c->readProportion + c->updateProportion + c->insertProportion + c->scanProportion + c->readModifyWriteProportion);
+
+    if ((u -= c->readProportion) < 0)
+        return WORKLOAD_READ;
+    if ((u -= c->updateProportion) < 0)
+        return WORKLOAD_UPDATE;
+    if ((u -= c->insertProportion) < 0)
+        return WORKLOAD_INSERT;
+    if ((u -= c->scanProportion) < 0)
+        return WORKLOAD_SCAN;
+    return WORKLOAD_READ_MODIFY_WRITE;
+}
+
+/**
+ * @brief Pick an existing record id according to the configured distribution
+ */
+uint64_t workloadNextRecord(Workload *workload)
+{
+    uint64_t count = workload->insertedCount ? workload->insertedCount : 1;
+
+    switch (workload->config.distribution)
+    {
+    case WORKLOAD_ZIPFIAN:
+        // Scramble ranks so the popular records are spread over the key space, as YCSB does
+        return fnv64_workload(zipfianNext(&workload->zipfian, &workload->rng, count)) % count;
+    case WORKLOAD_LATEST:
+        return count - 1 - zipfianNext(&workload->zipfian, &workload->rng, count);
+    case WORKLOAD_HOTSPOT:
+    {
+        uint64_t hot = (uint64_t)((double)count * workload->config.hotsetFraction);
+
+        if (hot == 0)
+            hot = 1;
+        if (hot >= count || xoshiroNextDouble(&workload->rng) < workload->config.hotOperationFraction)
+            return xoshiroNext(&workload->rng) % hot;
+        return hot + xoshiroNext(&workload->rng) % (count - hot);
+    }
+    case WORKLOAD_UNIFORM:
+    default:
+        return xoshiroNext(&workload->rng) % count;
+    }
+}
+
+/**
+ * @brief Write the key of a record into the generator's key buffer
+ *
+ * Keys are "user" followed by the 20-digit FNV hash of the record id, padded to keyLength,
+ * so consecutive ids do not produce clustered keys.
+ *
+ * @param workload Generator
+ * @param record Record id
+ * @return const char* The key buffer, valid until the next call
+ */
+const char *workloadFormatKey(Workload *workload, uint64_t record)
+{
+    uint64_t hash = fnv64_workload(record);
+    char *digits = workload->keyBuffer + 4;
+
+    for (int i = 19; i >= 0; i--)
+    {
+        digits[i] = (char)('0' + hash % 10);
+        hash /= 10;
+    }
+    return workload->keyBuffer;
+}
+
+/**
+ * @brief Refill the value buffer with fresh random printable bytes
+ *
+ * @return const char* The value buffer, valid until the next call
+ */
+const char *workloadNextValue(Workload *workload)
+{
+    char *value = workload->valueBuffer;
+    int length = workload->config.valueLength;
+
+    for (int i = 0; i < length; i += 8)
+    {
+        uint64_t bits = xoshiroNext(&workload->rng);
+
+        for (int j = i; j < i + 8 && j < length; j++, bits >>= 8)
+            value[j] = (char)('!' + (bits & 0xFF) % 94);
+    }
+    return value;
+}
+
+/**
+ * @brief Insert the initial recordCount records
+ *
+ * @param workload Generator
+ * @param dict Dictionary to populate, through its vtable so any variant can be driven
+ */
+void workloadLoad(Workload *workload, Dict *dict)
+{
+    for (uint64_t record = workload->insertedCount; record < workload->config.recordCount; record++)
+    {
+        const char *value = workloadNextValue(workload);
+        dict->vtable->insert_dict(dict, workloadFormatKey(workload, record), value);
+    }
+    if (workload->insertedCount < workload->config.recordCount)
+        workload->insertedCount = workload->config.recordCount;
+}
+
+/**
+ * @brief Execute operationCount operations against a loaded dictionary
+ *
+ * Scans read consecutive record ids with point lookups, since Dict has no ordered iteration.
+ *
+ * @param workload Generator, normally after workloadLoad
+ * @param dict Dictionary to drive, through its vtable
+ * @param result Receives throughput and per-operation latency
+ */
+void workloadRun(Workload *workload, Dict *dict, WorkloadResult *result)
+{
+    const DictVTable *vt = dict->vtable;
+    struct timespec begin, end;
+
+    memset(result, 0, sizeof(*result));
+    for (int op = 0; op < WORKLOAD_OP_COUNT; op++)
+        histogramReset(&result->latency[op]);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (uint64_t i = 0; i < workload->config.operationCount; i++)
+    {
+        WorkloadOp op = workloadNextOp(workload);
+        const char *value = op == WORKLOAD_READ || op == WORKLOAD_SCAN ? NULL : workloadNextValue(workload);
+        uint64_t record = op == WORKLOAD_INSERT ? workload->insertedCount : workloadNextRecord(workload);
+        const char *key = workloadFormatKey(workload, record);
+        uint64_t start = cycleCounter();
+
+        switch (op)
+        {
+        case WORKLOAD_READ:
+            if (!vt->get_dict(dict, key))
+                result->readMisses++;
+            break;
+        case WORKLOAD_UPDATE:
+            vt->update_dict(dict, key, value);
+            break;
+        case WORKLOAD_INSERT:
+            vt->insert_dict(dict, key, value);
+            workload->insertedCount++;
+            break;
+        case WORKLOAD_SCAN:
+        {
+            uint64_t length = 1 + xoshiroNext(&workload->rng) % (uint64_t)workload->config.maxScanLength;
+            uint64_t count = workload->insertedCount ? workload->insertedCount : 1;
+
+            for (uint64_t n = 0; n < length; n++)
+            {
+                key = workloadFormatKey(workload, (record + n) % count);
+                if (!vt->get_dict(dict, key))
+                    result->readMisses++;
+            }
+            break;
+        }
+        case WORKLOAD_READ_MODIFY_WRITE:
+            if (!vt->get_dict(dict, key))
+                result->readMisses++;
+            vt->update_dict(dict, key, value);
+            break;
+        default:
+            break;
+        }
+
+        histogramRecord(&result->latency[op], cycleCounter() - start);
+        result->operations[op]++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    result->seconds = (double)(end.tv_sec - begin.tv_sec) + (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file Check.h
+ * @brief Minimal assertions for the tests: a failed CHECK reports its line and fails the test at exit.
+ */
+
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+static int checkFailures;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { checkFailures++; fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); } } while (0)
+
+#define CHECK_DONE() (checkFailures ? (fprintf(stderr, "%d check(s) failed\n", checkFailures), 1) : 0)
+
+#endif
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Build and run every tests/test_*.c against the library sources under ASan and UBSan, and the
+# threaded ones (those that define DICT_TEST_THREADS on their first line) under TSan as well.
+# Usage: tests/run.sh [test_name ...]   e.g. tests/run.sh test_compact_dict
+set -u
+cd "$(dirname "$0")/.." || exit 1
+
+CC=${CC:-gcc}
+SOURCES="src/String.c src/Histogram.c src/Dict.c src/DictRobinHood.c src/DictCuckoo.c src/DictBucketVector.c
+         src/DictSmall.c src/DictMemory.c src/TimerWheel.c src/BloomFilter.c src/RadixTree.c src/Glob.c
+         src/KeySort.c src/CompactDict.c"
+FLAGS="-std=c11 -O1 -g -D_DEFAULT_SOURCE -DDICT_ENABLE_THREADS -DDICT_ENABLE_COUNTERS -DDICT_ENABLE_LATENCY -pthread"
+OUT=${TMPDIR:-/tmp}/dict_tests
+mkdir -p "$OUT"
+
+if [ $# -gt 0 ]; then TESTS="$*"; else TESTS=$(ls tests/test_*.c | xargs -n1 basename | sed 's/\.c$//'); fi
+
+failed=0
+for name in $TESTS; do
+    sanitizers="address,undefined"
+    head -n1 "tests/$name.c" | grep -q DICT_TEST_THREADS && sanitizers="$sanitizers thread"
+    for sanitizer in $sanitizers; do
+        binary="$OUT/$name.$(echo "$sanitizer" | cut -d, -f1)"
+        if ! $CC $FLAGS -fsanitize="$sanitizer" -o "$binary" "tests/$name.c" $SOURCES -lm 2>"$binary.log"; then
+            echo "FAIL $name ($sanitizer): build, see $binary.log"
+            failed=1
+        elif ! ASAN_OPTIONS=detect_leaks=1 TSAN_OPTIONS=halt_on_error=1 "$binary" >"$binary.log" 2>&1; then
+            echo "FAIL $name ($sanitizer), see $binary.log"
+            failed=1
+        else
+            echo "ok   $name ($sanitizer)"
+        fi
+    done
+done
+exit $failed
@@ -0,0 +1,359 @@
+#include "../include/Dict.h"
+#include "Check.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct Arena
+ * @brief Bump allocator: blocks are never freed one by one.
+ */
+typedef struct Arena
+{
+    char *base;
+    size_t used;
+    size_t capacity;
+} Arena;
+
+static void *arenaAlloc(size_t size, void *ctx)
+{
+    Arena *arena = ctx;
+
+    size = (size + 15) & ~(size_t)15;
+    if (arena->used + size > arena->capacity)
+        return NULL;
+    arena->used += size;
+    return arena->base + arena->used - size;
+}
+
+static void *arenaRealloc(void *block, size_t size, void *ctx)
+{
+    void *grown = arenaAlloc(size, ctx);
+
+    if (block && grown)
+        memmove(grown, block, size); // blocks only ever grow here, and the arena is contiguous
+    return grown;
+}
+
+/**
+ * @struct Budget
+ * @brief malloc that fails every call after the first remaining ones, counting what is still allocated.
+ */
+typedef struct Budget
+{
+    long remaining; /**< Calls that may still succeed, negative for no limit */
+    long live; /**< Blocks allocated and not freed yet */
+} Budget;
+
+static void *budgetAlloc(size_t size, void *ctx)
+{
+    Budget *budget = ctx;
+    void *block;
+
+    if (budget->remaining == 0)
+        return NULL;
+    if (budget->remaining > 0)
+        budget->remaining--;
+    if ((block = malloc(size)))
+        budget->live++;
+    return block;
+}
+
+static void *budgetRealloc(void *block, size_t size, void *ctx)
+{
+    Budget *budget = ctx;
+    void *grown;
+
+    if (!block)
+        return budgetAlloc(size, ctx);
+    if (budget->remaining == 0)
+        return NULL;
+    if (budget->remaining > 0)
+        budget->remaining--;
+    grown = realloc(block, size);
+    return grown;
+}
+
+static void budgetFree(void *block, void *ctx)
+{
+    Budget *budget = ctx;
+
+    if (block)
+        budget->live--;
+    free(block);
+}
+
+static bool countVisit(const char *key, const char *value, void *ctx)
+{
+    (void)key;
+    (void)value;
+    ++*(size_t *)ctx;
+    return true;
+}
+
+/**
+ * @brief Fill a 2 MB arena far past its capacity: inserts start failing, and everything inserted before stays readable,
+ * whichever backend
+ */
+static void testArenaFills(DictBackend backend)
+{
+    Arena arena = {malloc(2 << 20), 0, 2 << 20};
+    Dict *dict = createDictWithAllocator(backend, arenaAlloc, arenaRealloc, NULL, &arena);
+    bool *inserted = calloc(100000, sizeof(bool));
+    char key[32];
+    char value[32];
+    int stored = 0;
+
+    CHECK(dict != NULL);
+    for (int i = 0; i < 100000; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        snprintf(value, sizeof(value), "value:%d", i);
+        inserted[i] = insert_dict(dict, key, value);
+        stored += inserted[i];
+    }
+    CHECK(stored > 0 && stored < 100000);
+    CHECK(size_dict(dict) == stored);
+
+    for (int i = 0; i < 100000; i++)
+    {
+        const char *found;
+
+        snprintf(key, sizeof(key), "key:%d", i);
+        snprintf(value, sizeof(value), "value:%d", i);
+        found = get_dict(dict, key);
+        CHECK(inserted[i] ? found && strcmp(found, value) == 0 : found == NULL);
+    }
+
+    arena.used = arena.capacity; // a table that failed to grow may have left room for small blocks
+    CHECK(!update_dict(dict, "key:0", "a value that needs a new block"));
+    CHECK(strcmp(get_dict(dict, "key:0"), "value:0") == 0);
+    CHECK(!insertTTL_dict(dict, "late", "x", 1000));
+    CHECK(!exists_dict(dict, "late"));
+    CHECK(keys_dict(dict) == NULL);
+    CHECK(items_dict(dict) == NULL);
+    CHECK(popItem_dict(dict, "key:1") == NULL);
+    CHECK(exists_dict(dict, "key:1"));
+    CHECK(!setOrderedIndex_dict(dict, true));
+    CHECK(range_dict(dict, "", NULL, countVisit, &(size_t){0}) == 0);
+
+    destroyDict(dict);
+    free(arena.base);
+    free(inserted);
+}
+
+/**
+ * @brief A small-backend dictionary in an arena costs one block, not a chaining bucket array
+ */
+static void testArenaSmallBackend(void)
+{
+    Arena arena = {malloc(64 << 10), 0, 64 << 10};
+    Dict *dict = createDictWithAllocator(DICT_BACKEND_SMALL, arenaAlloc, arenaRealloc, NULL, &arena);
+
+    CHECK(dict != NULL);
+    CHECK(arena.used < 4096);
+    CHECK(insert_dict(dict, "a", "1"));
+    CHECK(strcmp(get_dict(dict, "a"), "1") == 0);
+    destroyDict(dict);
+    free(arena.base);
+    CHECK(createDictWithAllocator((DictBackend)99, arenaAlloc, arenaRealloc, NULL, &arena) == NULL);
+}
+
+/**
+ * @brief Run a mix of operations with every optional structure enabled
+ *
+ * @return int Number of keys the dictionary should hold at the end
+ */
+static int exercise(Dict *dict, bool expected[64])
+{
+    DictCacheConfig cache = {0};
+    char key[32];
+    size_t visited = 0;
+    int count = 0;
+
+    cache.policy = DICT_EVICT_SAMPLED_LRU;
+    cache.maxEntries = 1000;
+    setCacheMode_dict(dict, &cache);
+    setBloomFilter_dict(dict, 10);
+    setOrderedIndex_dict(dict, true);
+
+    for (int i = 0; i < 64; i++)
+    {
+        snprintf(key, sizeof(key), "key:%02d", i);
+        expected[i] = i % 3 ? insert_dict(dict, key, key) : insertTTL_dict(dict, key, key, 60000);
+    }
+    for (int i = 0; i < 64; i += 4)
+    {
+        snprintf(key, sizeof(key), "key:%02d", i);
+        if (update_dict(dict, key, "updated"))
+            expected[i] = true;
+    }
+    for (int i = 1; i < 64; i += 8)
+    {
+        DictItem *item;
+
+        snprintf(key, sizeof(key), "key:%02d", i);
+        if (expected[i] && (item = popItem_dict(dict, key)))
+        {
+            CHECK(strcmp(item->key, key) == 0);
+            dict->allocator_dict.free(item->key, dict->allocator_dict.ctx);
+            dict->allocator_dict.free(item->value, dict->allocator_dict.ctx);
+            dict->allocator_dict.free(item, dict->allocator_dict.ctx);
+            expected[i] = false;
+        }
+    }
+
+    char **keys = keys_dict(dict);
+    if (keys)
+    {
+        for (int i = 0; keys[i]; i++)
+            dict->allocator_dict.free(keys[i], dict->allocator_dict.ctx);
+        dict->allocator_dict.free(keys, dict->allocator_dict.ctx);
+    }
+    sortedItems_dict(dict, countVisit, &visited);
+    CHECK(visited == 0 || visited == (size_t)size_dict(dict));
+    if (dict->index_dict)
+    {
+        visited = 0;
+        CHECK(range_dict(dict, "", NULL, countVisit, &visited) == (size_t)size_dict(dict));
+    }
+
+    for (int i = 0; i < 64; i++)
+        count += expected[i];
+    return count;
+}
+
+/**
+ * @brief Fail the allocator at every possible point of a run: each failure must leave a consistent
+ * dictionary and, once destroyed, nothing allocated
+ */
+static void testEveryFailurePoint(DictBackend backend)
+{
+    Budget unlimited = {-1, 0};
+    Dict *dict = createDictWithAllocator(backend, budgetAlloc, budgetRealloc, budgetFree, &unlimited);
+    bool expected[64];
+    bool exhausted = true;
+
+    CHECK(exercise(dict, expected) == size_dict(dict));
+    destroyDict(dict);
+    CHECK(unlimited.live == 0);
+
+    // until a budget lasts the whole run, so that every allocation has failed once
+    for (long calls = 0; exhausted; calls++)
+    {
+        Budget budget = {calls, 0};
+        char key[32];
+
+        dict = createDictWithAllocator(backend, budgetAlloc, budgetRealloc, budgetFree, &budget);
+        if (!dict)
+        {
+            CHECK(budget.live == 0);
+            continue;
+        }
+        int count = exercise(dict, expected);
+
+        exhausted = budget.remaining == 0;
+        CHECK(count == size_dict(dict));
+        for (int i = 0; i < 64; i++)
+        {
+            snprintf(key, sizeof(key), "key:%02d", i);
+            CHECK(exists_dict(dict, key) == expected[i]);
+        }
+        destroyDict(dict);
+        CHECK(budget.live == 0);
+    }
+}
+
+/**
+ * @brief The Bloom filter, ordered index and sort scratch space come from the allocator too
+ */
+static void testOptionalStructuresUseAllocator(void)
+{
+    Budget budget = {-1, 0};
+    Dict *dict = createDictWithAllocator(DICT_BACKEND_ROBIN_HOOD, budgetAlloc, budgetRealloc, budgetFree, &budget);
+    char key[32];
+    long before;
+    size_t visited = 0;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(insert_dict(dict, key, key));
+    }
+
+    before = budget.live;
+    CHECK(setBloomFilter_dict(dict, 10));
+    CHECK(budget.live > before);
+
+    before = budget.live;
+    CHECK(setOrderedIndex_dict(dict, true));
+    CHECK(budget.live > before + 1000); // at least a leaf per key
+
+    CHECK(setOrderedIndex_dict(dict, false));
+    budget.remaining = 0; // the sort must allocate its scratch space from the hook, and fail
+    CHECK(sortedItems_dict(dict, countVisit, &visited) == 0);
+    budget.remaining = -1;
+    CHECK(sortedItems_dict(dict, countVisit, &visited) == 1000);
+
+    destroyDict(dict);
+    CHECK(budget.live == 0);
+}
+
+/**
+ * @brief compact_dict either repacks every pair or, when an allocation fails, leaves the dictionary as it was
+ */
+static void testCompactFailureLeavesDict(void)
+{
+    bool compacted = false;
+
+    for (long calls = 0; !compacted; calls++)
+    {
+        Budget budget = {-1, 0};
+        Dict *dict = createDictWithAllocator(DICT_BACKEND_ROBIN_HOOD, budgetAlloc, budgetRealloc, budgetFree, &budget);
+        DictCacheConfig cache = {0};
+        char key[32];
+        size_t visited = 0;
+
+        cache.policy = DICT_EVICT_LRU;
+        cache.maxEntries = 1000;
+        CHECK(setCacheMode_dict(dict, &cache));
+        CHECK(setOrderedIndex_dict(dict, true));
+        for (int i = 0; i < 200; i++)
+        {
+            snprintf(key, sizeof(key), "key:%03d", i);
+            CHECK(i % 2 ? insert_dict(dict, key, key) : insertTTL_dict(dict, key, key, 60000));
+        }
+
+        budget.remaining = calls;
+        compacted = compact_dict(dict);
+        budget.remaining = -1;
+
+        CHECK(size_dict(dict) == 200);
+        for (int i = 0; i < 200; i++)
+        {
+            const char *found;
+
+            snprintf(key, sizeof(key), "key:%03d", i);
+            found = get_dict(dict, key);
+            CHECK(found && strcmp(found, key) == 0);
+            CHECK((ttl_dict(dict, key) > 0) == (i % 2 == 0));
+        }
+        CHECK(range_dict(dict, "", NULL, countVisit, &visited) == 200);
+        destroyDict(dict);
+        CHECK(budget.live == 0);
+    }
+}
+
+int main(void)
+{
+    testArenaFills(DICT_BACKEND_CHAINING);
+    testArenaFills(DICT_BACKEND_ROBIN_HOOD);
+    testArenaFills(DICT_BACKEND_CUCKOO);
+    testArenaFills(DICT_BACKEND_BUCKET_VECTOR);
+    testArenaFills(DICT_BACKEND_SMALL);
+    testArenaSmallBackend();
+    for (int backend = DICT_BACKEND_CHAINING; backend <= DICT_BACKEND_SMALL; backend++)
+        testEveryFailurePoint((DictBackend)backend);
+    testOptionalStructuresUseAllocator();
+    testCompactFailureLeavesDict();
+    return CHECK_DONE();
+}
@@ -0,0 +1,161 @@
+#include "../include/Dict.h"
+#include "Check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_COUNT 10000
+
+/**
+ * @brief malloc that refuses large blocks while failLarge is set, which only the Bloom filter and
+ * the engine tables ask for
+ */
+static bool failLarge;
+
+static void *largeFailingAlloc(size_t size, void *ctx)
+{
+    (void)ctx;
+    return failLarge && size >= 1024 ? NULL : malloc(size);
+}
+
+static void *largeFailingRealloc(void *block, size_t size, void *ctx)
+{
+    (void)ctx;
+    return failLarge && size >= 1024 ? NULL : realloc(block, size);
+}
+
+static void plainFree(void *block, void *ctx)
+{
+    (void)ctx;
+    free(block);
+}
+
+static double falsePositiveRate(Dict *dict)
+{
+    DictStats stats;
+
+    stats_dict(dict, &stats);
+    return stats.bloomFalsePositiveRate;
+}
+
+/**
+ * @brief Random inserts, duplicates and removes, with the filter growing and rebuilding along the
+ * way: every key present is found, so the filter never hides one, and every key removed is gone
+ */
+static void testNeverHidesAKey(DictBackend backend)
+{
+    Dict *dict = createDictWithBackend(backend);
+    static unsigned char copies[KEY_COUNT];
+    unsigned int seed = 777;
+    char key[32];
+
+    memset(copies, 0, sizeof(copies));
+    CHECK(setBloomFilter_dict(dict, 10));
+    for (int step = 0; step < 60000; step++)
+    {
+        int i;
+
+        seed = seed * 1103515245u + 12345u;
+        i = (int)((seed >> 8) % KEY_COUNT);
+        snprintf(key, sizeof(key), "key:%d", i);
+
+        if ((seed >> 4) % 3 && copies[i] < 2)
+        {
+            CHECK(insert_dict(dict, key, "value"));
+            copies[i]++;
+        }
+        else
+        {
+            removeKey_dict(dict, key);
+            copies[i] -= copies[i] > 0;
+        }
+        CHECK((get_dict(dict, key) != NULL) == (copies[i] > 0));
+    }
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(exists_dict(dict, key) == (copies[i] > 0));
+    }
+    destroyDict(dict);
+}
+
+/**
+ * @brief Removed keys stay set in the filter only until they outnumber half its capacity: once
+ * most keys are gone, lookups for them are answered by the filter again
+ */
+static void testRemovalsRebuild(void)
+{
+    Dict *dict = createDict();
+    char key[32];
+
+    CHECK(setBloomFilter_dict(dict, 10));
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(insert_dict(dict, key, "value"));
+    }
+    for (int i = 0; i < KEY_COUNT - 100; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        removeKey_dict(dict, key);
+    }
+    CHECK(dict->bloom_dict->removed <= dict->bloom_dict->filter->capacity / 2);
+
+    for (int i = 0; i < KEY_COUNT - 100; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(get_dict(dict, key) == NULL);
+    }
+    CHECK(falsePositiveRate(dict) < 0.5);
+    for (int i = KEY_COUNT - 100; i < KEY_COUNT; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(get_dict(dict, key) != NULL);
+    }
+
+    // a clear empties the filter too
+    clear_dict(dict);
+    CHECK(dict->bloom_dict->removed == 0);
+    CHECK(setBloomFilter_dict(dict, 10)); // restarts the false-positive count
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(!exists_dict(dict, key));
+    }
+    CHECK(falsePositiveRate(dict) < 0.05);
+    destroyDict(dict);
+}
+
+/**
+ * @brief A filter that cannot be rebuilt while the dictionary grows past its capacity still
+ * admits every key added in the meantime
+ */
+static void testGrowthWithoutMemory(void)
+{
+    Dict *dict = createDictWithAllocator(DICT_BACKEND_CHAINING, largeFailingAlloc, largeFailingRealloc, plainFree, NULL);
+    char key[32];
+
+    CHECK(setBloomFilter_dict(dict, 10));
+    failLarge = true;
+    for (int i = 0; i < 3000; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(insert_dict(dict, key, "value"));
+    }
+    for (int i = 0; i < 3000; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(get_dict(dict, key) != NULL);
+    }
+    failLarge = false;
+    destroyDict(dict);
+}
+
+int main(void)
+{
+    testNeverHidesAKey(DICT_BACKEND_CHAINING);
+    testNeverHidesAKey(DICT_BACKEND_ROBIN_HOOD);
+    testNeverHidesAKey(DICT_BACKEND_SMALL);
+    testRemovalsRebuild();
+    testGrowthWithoutMemory();
+    return CHECK_DONE();
+}
@@ -0,0 +1,54 @@
+#include "../include/Dict.h"
+#include "Check.h"
+#include <string.h>
+
+/**
+ * @brief With every policy and small limits, each insert leaves the dictionary within maxEntries,
+ * even when every eviction sample would land on the pair just inserted
+ */
+static void testEntryLimitHolds(DictEvictionPolicy policy)
+{
+    char key[32];
+
+    // two keys into a one-pair cache, many times over: the sampled policies draw the new pair often
+    for (int run = 0; run < 4000; run++)
+    {
+        Dict *dict = createDict();
+        DictCacheConfig cache = {0};
+
+        cache.policy = policy;
+        cache.maxEntries = 1;
+        CHECK(setCacheMode_dict(dict, &cache));
+        CHECK(insert_dict(dict, "first", "1"));
+        CHECK(insert_dict(dict, "second", "2"));
+        CHECK(size_dict(dict) == 1 && exists_dict(dict, "second"));
+        destroyDict(dict);
+    }
+
+    for (size_t limit = 1; limit <= 8; limit++)
+    {
+        Dict *dict = createDict();
+        DictCacheConfig cache = {0};
+
+        cache.policy = policy;
+        cache.maxEntries = limit;
+        cache.sampleSize = 1;
+        CHECK(setCacheMode_dict(dict, &cache));
+        for (int i = 0; i < 500; i++)
+        {
+            snprintf(key, sizeof(key), "k%d", i);
+            CHECK(i % 3 ? insert_dict(dict, key, "value") : update_dict(dict, key, "value"));
+            CHECK((size_t)size_dict(dict) <= limit);
+            CHECK(exists_dict(dict, key));
+        }
+        destroyDict(dict);
+    }
+}
+
+int main(void)
+{
+    testEntryLimitHolds(DICT_EVICT_LRU);
+    testEntryLimitHolds(DICT_EVICT_SAMPLED_LRU);
+    testEntryLimitHolds(DICT_EVICT_LFU);
+    return CHECK_DONE();
+}
@@ -0,0 +1,104 @@
+#include "../include/CompactDict.h"
+#include "Check.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Store a key of the given length as the first record of a fresh pool, where the record
+ * starts one granule in, and read it back
+ */
+static void firstRecord(size_t keyLength)
+{
+    CompactDict *dict = createCompactDict(0);
+    char *key = malloc(keyLength + 1);
+
+    memset(key, 'k', keyLength);
+    key[keyLength] = '\0';
+    CHECK(compactDictPut(dict, key, ""));
+    CHECK(compactDictGet(dict, key) && strcmp(compactDictGet(dict, key), "") == 0);
+    free(key);
+    destroyCompactDict(dict);
+}
+
+/**
+ * @brief Records sized around every power of two a segment starts at, as the first record
+ */
+static void testFirstRecordBoundaries(void)
+{
+    for (size_t segment = 4096; segment <= ((size_t)1 << 16); segment *= 2)
+    {
+        for (size_t bytes = segment - 8; bytes <= segment + 8; bytes++)
+            firstRecord(bytes - 2); // a record holds the key, its NUL and the empty value's NUL
+    }
+}
+
+/**
+ * @brief Fill the pool with garbage until it is rewritten, then store a record that needs a new
+ * segment right after the rewrite
+ */
+static void testBoundaryAfterReclaim(void)
+{
+    CompactDict *dict = createCompactDict(0);
+    char key[32];
+    char *big = malloc(8193);
+
+    memset(big, 'v', 8192);
+    big[8192] = '\0';
+    for (int round = 0; round < 4; round++)
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            snprintf(key, sizeof(key), "k%d", i);
+            CHECK(compactDictPut(dict, key, big));
+        }
+        for (int i = 0; i < 200; i++)
+        {
+            snprintf(key, sizeof(key), "k%d", i);
+            CHECK(compactDictRemove(dict, key));
+        }
+    }
+    big[8190] = '\0';
+    CHECK(compactDictPut(dict, big, ""));
+    CHECK(compactDictGet(dict, big) != NULL);
+    CHECK(compactDictSize(dict) == 1);
+    free(big);
+    destroyCompactDict(dict);
+}
+
+static void testRoundTrip(void)
+{
+    CompactDict *dict = createCompactDict(0);
+    char key[32];
+    char value[32];
+
+    for (int i = 0; i < 100000; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        snprintf(value, sizeof(value), "%d", i * 7);
+        CHECK(compactDictPut(dict, key, value));
+    }
+    for (int i = 0; i < 100000; i += 2)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        CHECK(compactDictRemove(dict, key));
+    }
+    for (int i = 0; i < 100000; i++)
+    {
+        const char *found;
+
+        snprintf(key, sizeof(key), "key:%d", i);
+        snprintf(value, sizeof(value), "%d", i * 7);
+        found = compactDictGet(dict, key);
+        CHECK(i % 2 ? found && strcmp(found, value) == 0 : found == NULL);
+    }
+    CHECK(compactDictSize(dict) == 50000);
+    destroyCompactDict(dict);
+}
+
+int main(void)
+{
+    testFirstRecordBoundaries();
+    testBoundaryAfterReclaim();
+    testRoundTrip();
+    return CHECK_DONE();
+}
@@ -0,0 +1,240 @@
+#include "../include/DictEngine.h"
+#include "Check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define KEY_COUNT 3000
+#define SMALL_KEY_COUNT 12 /* distinct keys a small table holds without upgrading */
+
+static const char *backendName(int backend)
+{
+    static const char *names[] = {"chaining", "robin_hood", "cuckoo", "bucket_vector", "small"};
+    return names[backend];
+}
+
+static bool countVisit(const char *key, const char *value, void *ctx)
+{
+    unsigned char *seen = ctx;
+
+    (void)value;
+    seen[atoi(key + 1)]++;
+    return true;
+}
+
+/**
+ * @brief Scan the whole dictionary with a few pairs per step, counting the visits of each key
+ */
+static void scanAll(Dict *dict, unsigned char *seen, size_t count)
+{
+    size_t cursor = 0;
+
+    memset(seen, 0, count);
+    do
+        cursor = scan_dict(dict, cursor, 7, countVisit, seen);
+    while (cursor);
+}
+
+/**
+ * @brief A key inserted twice is stored twice: lookups return the earlier pair, and removing it
+ * uncovers the later one
+ */
+static void testDuplicates(int backend)
+{
+    Dict *dict = createDictWithBackend((DictBackend)backend);
+    char key[32];
+
+    for (int i = 0; i < 40; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        CHECK(insert_dict(dict, key, "filler"));
+        if (i == 5 && backend == DICT_BACKEND_SMALL)
+            break; // stay small for this part
+    }
+    CHECK(insert_dict(dict, "dup", "first"));
+    CHECK(insert_dict(dict, "dup", "second"));
+    CHECK(insert_dict(dict, "dup", "third"));
+    CHECK(strcmp(get_dict(dict, "dup"), "first") == 0);
+
+    removeKey_dict(dict, "dup");
+    CHECK(strcmp(get_dict(dict, "dup"), "second") == 0);
+    removeKey_dict(dict, "dup");
+    CHECK(strcmp(get_dict(dict, "dup"), "third") == 0);
+    removeKey_dict(dict, "dup");
+    CHECK(get_dict(dict, "dup") == NULL);
+    CHECK(get_dict(dict, "k3") != NULL);
+    destroyDict(dict);
+}
+
+/**
+ * @brief Unlinking a pair by identity, as expiry does, takes out the right one of several
+ * duplicates whether it comes first or last
+ */
+static void testUnlinkDuplicates(int backend)
+{
+    Dict *dict = createDictWithBackend((DictBackend)backend);
+    struct timespec pause = {0, 5000000};
+
+    CHECK(insertTTL_dict(dict, "head", "expiring", 1));
+    CHECK(insert_dict(dict, "head", "kept"));
+    CHECK(insert_dict(dict, "tail", "kept"));
+    CHECK(insertTTL_dict(dict, "tail", "expiring", 1));
+    CHECK(insert_dict(dict, "other", "kept"));
+    nanosleep(&pause, NULL);
+
+    CHECK(expireTick_dict(dict, 10) == 2);
+    CHECK(size_dict(dict) == 3);
+    CHECK(strcmp(get_dict(dict, "head"), "kept") == 0);
+    CHECK(strcmp(get_dict(dict, "tail"), "kept") == 0);
+    removeKey_dict(dict, "head");
+    removeKey_dict(dict, "tail");
+    CHECK(!exists_dict(dict, "head") && !exists_dict(dict, "tail"));
+    CHECK(strcmp(get_dict(dict, "other"), "kept") == 0);
+    destroyDict(dict);
+}
+
+/**
+ * @brief Random inserts, duplicates included, and removes against a count per key, so that
+ * Robin Hood's backward shifts and cuckoo's displacements run in every arrangement; every lookup,
+ * the size and a full scan agree with the counts throughout
+ */
+static void testAgainstReference(int backend)
+{
+    Dict *dict = createDictWithBackend((DictBackend)backend);
+    int keyCount = backend == DICT_BACKEND_SMALL ? SMALL_KEY_COUNT : KEY_COUNT;
+    static unsigned char copies[KEY_COUNT];
+    static unsigned char seen[KEY_COUNT];
+    unsigned int seed = 12345;
+    int size = 0;
+    char key[32];
+
+    memset(copies, 0, sizeof(copies));
+    for (int step = 0; step < 40000; step++)
+    {
+        int i;
+
+        seed = seed * 1103515245u + 12345u;
+        i = (int)((seed >> 8) % (unsigned int)keyCount);
+        snprintf(key, sizeof(key), "k%d", i);
+
+        // mostly inserts of absent keys early on, balanced inserts and removes later
+        if ((seed >> 4) % 5 < (step < 10000 ? 4u : 2u) && copies[i] < 3)
+        {
+            CHECK(insert_dict(dict, key, "value"));
+            copies[i]++;
+            size++;
+        }
+        else
+        {
+            removeKey_dict(dict, key);
+            if (copies[i])
+            {
+                copies[i]--;
+                size--;
+            }
+        }
+        CHECK(size_dict(dict) == size);
+        CHECK((get_dict(dict, key) != NULL) == (copies[i] > 0));
+
+        if (step % 10000 == 9999)
+        {
+            for (int j = 0; j < keyCount; j++)
+            {
+                snprintf(key, sizeof(key), "k%d", j);
+                CHECK((get_dict(dict, key) != NULL) == (copies[j] > 0));
+            }
+            scanAll(dict, seen, (size_t)keyCount);
+            for (int j = 0; j < keyCount; j++)
+                CHECK(seen[j] >= copies[j] && (seen[j] > 0) == (copies[j] > 0));
+        }
+    }
+
+    if (backend == DICT_BACKEND_SMALL)
+        CHECK(dict->engine_dict == &smallEngine_dict);
+    destroyDict(dict);
+}
+
+/**
+ * @brief Filling far past the initial table grows the resizable ones within their load limit and
+ * keeps every key reachable, and a full scan visits each key exactly once when nothing moves
+ */
+static void testGrowthAndScan(int backend)
+{
+    Dict *dict = createDictWithBackend((DictBackend)backend);
+    size_t initialSlots = dict->engine_dict->slotCount(dict);
+    static unsigned char seen[20000];
+    char key[32];
+
+    for (int i = 0; i < 20000; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        CHECK(insert_dict(dict, key, "value"));
+    }
+    CHECK(size_dict(dict) == 20000);
+
+    if (dict->engine_dict == &robinHoodEngine_dict)
+        CHECK(dict->engine_dict->slotCount(dict) * 90 >= 20000 * 100); // under the 90% maximum load
+    if (backend == DICT_BACKEND_ROBIN_HOOD || backend == DICT_BACKEND_CUCKOO)
+        CHECK(dict->engine_dict->slotCount(dict) > initialSlots);
+
+    for (int i = 0; i < 20000; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        CHECK(get_dict(dict, key) != NULL);
+    }
+    scanAll(dict, seen, sizeof(seen));
+    for (int i = 0; i < 20000; i++)
+        CHECK(seen[i] == 1);
+    destroyDict(dict);
+}
+
+/**
+ * @brief A small table holds 16 distinct keys inline, duplicates not counting, and moves to Robin
+ * Hood on the 17th with every pair and the precedence of duplicates intact
+ */
+static void testSmallUpgrade(void)
+{
+    Dict *dict = createDictWithBackend(DICT_BACKEND_SMALL);
+    char key[32];
+    char value[32];
+
+    for (int i = 0; i < 16; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        snprintf(value, sizeof(value), "%d", i);
+        CHECK(insert_dict(dict, key, value));
+    }
+    CHECK(insert_dict(dict, "k3", "later"));
+    CHECK(dict->engine_dict == &smallEngine_dict);
+    CHECK(size_dict(dict) == 17);
+
+    CHECK(insert_dict(dict, "k16", "16"));
+    CHECK(dict->engine_dict == &robinHoodEngine_dict);
+    CHECK(size_dict(dict) == 18);
+    for (int i = 0; i <= 16; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        snprintf(value, sizeof(value), "%d", i);
+        CHECK(get_dict(dict, key) && strcmp(get_dict(dict, key), value) == 0);
+    }
+    removeKey_dict(dict, "k3");
+    CHECK(strcmp(get_dict(dict, "k3"), "later") == 0);
+    destroyDict(dict);
+}
+
+int main(void)
+{
+    for (int backend = DICT_BACKEND_CHAINING; backend <= DICT_BACKEND_SMALL; backend++)
+    {
+        int failures = checkFailures;
+
+        testDuplicates(backend);
+        testUnlinkDuplicates(backend);
+        testAgainstReference(backend);
+        testGrowthAndScan(backend);
+        if (checkFailures > failures)
+            fprintf(stderr, "backend %s failed\n", backendName(backend));
+    }
+    testSmallUpgrade();
+    return CHECK_DONE();
+}
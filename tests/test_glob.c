@@ -0,0 +1,239 @@
+#define DICT_TEST_THREADS /* scanMatchParallel_dict visits from several threads */
+#include "../include/Dict.h"
+#include "../include/Glob.h"
+#include "Check.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_COUNT 3000
+#define MAX_ATOMS 8
+
+static const char alphabet[] = "abc*?[";
+
+static unsigned int seed = 4242;
+
+static unsigned int nextRandom(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+/**
+ * @struct Atom
+ * @brief One element of a generated pattern, kept apart from its syntax for the reference matcher.
+ */
+typedef struct Atom
+{
+    bool star; /**< Any run of characters */
+    bool members[256]; /**< Characters the atom matches, otherwise */
+} Atom;
+
+/**
+ * @brief Backtracking matcher over the atoms, the obvious definition of a glob match
+ */
+static bool referenceMatch(const Atom *atoms, int count, const char *text)
+{
+    if (count == 0)
+        return *text == '\0';
+    if (atoms->star)
+    {
+        for (const char *p = text;; p++)
+        {
+            if (referenceMatch(atoms + 1, count - 1, p))
+                return true;
+            if (!*p)
+                return false;
+        }
+    }
+    return *text && atoms->members[(unsigned char)*text] && referenceMatch(atoms + 1, count - 1, text + 1);
+}
+
+/**
+ * @brief Generate a random pattern over the alphabet: literals, escapes of the special characters,
+ * `?`, stars and classes with ranges and negation
+ *
+ * @return int Number of atoms, rendered as glob syntax into pattern
+ */
+static int randomPattern(Atom *atoms, char *pattern)
+{
+    int count = (int)(nextRandom() % MAX_ATOMS);
+    char *out = pattern;
+
+    for (int i = 0; i < count; i++)
+    {
+        Atom *atom = &atoms[i];
+        char c = alphabet[nextRandom() % (sizeof(alphabet) - 1)];
+
+        memset(atom, 0, sizeof(*atom));
+        switch (nextRandom() % 6)
+        {
+        case 0:
+            atom->star = true;
+            *out++ = '*';
+            break;
+        case 1:
+            memset(atom->members + 1, true, 255);
+            *out++ = '?';
+            break;
+        case 2:
+            atom->members['a'] = atom->members['b'] = true;
+            out += sprintf(out, nextRandom() % 2 ? "[ab]" : "[a-b]");
+            break;
+        case 3:
+            memset(atom->members + 1, true, 255);
+            atom->members['c'] = atom->members['*'] = false;
+            out += sprintf(out, nextRandom() % 2 ? "[^c\\*]" : "[!*c]");
+            break;
+        default:
+            atom->members[(unsigned char)c] = true;
+            if (c == '*' || c == '?' || c == '[' || nextRandom() % 4 == 0)
+                *out++ = '\\';
+            *out++ = c;
+            break;
+        }
+    }
+    *out = '\0';
+    return count;
+}
+
+static void randomText(char *text)
+{
+    size_t length = nextRandom() % 10;
+
+    for (size_t i = 0; i < length; i++)
+        text[i] = alphabet[nextRandom() % (sizeof(alphabet) - 1)];
+    text[length] = '\0';
+}
+
+/**
+ * @brief globMatch agrees with the reference on random patterns and strings, and on a few
+ * patterns with unusual classes
+ */
+static void testAgainstReference(void)
+{
+    Atom atoms[MAX_ATOMS];
+    char pattern[8 * MAX_ATOMS];
+    char text[16];
+    GlobMatcher matcher;
+
+    for (int round = 0; round < 3000; round++)
+    {
+        int count = randomPattern(atoms, pattern);
+
+        CHECK(globCompile(&matcher, pattern));
+        for (int i = 0; i < 50; i++)
+        {
+            randomText(text);
+            if (globMatch(&matcher, text) != referenceMatch(atoms, count, text))
+            {
+                fprintf(stderr, "pattern \"%s\" text \"%s\"\n", pattern, text);
+                CHECK(false);
+            }
+        }
+        globFree(&matcher);
+    }
+
+    static const struct
+    {
+        const char *pattern;
+        const char *text;
+        bool match;
+    } cases[] = {
+        {"[]a]", "]", true},     {"[]a]", "a", true},   {"[!]]", "]", false}, {"[a", "[a", true},
+        {"a[", "a[", true},      {"[a-]", "-", true},   {"*x*x*", "axbx", true}, {"*x*x*", "ax", false},
+        {"\\", "\\", true},      {"", "", true},        {"*", "", true},     {"a*a", "a", false},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        CHECK(globCompile(&matcher, cases[i].pattern));
+        CHECK(globMatch(&matcher, cases[i].text) == cases[i].match);
+        globFree(&matcher);
+    }
+}
+
+static bool countMatch(const char *key, const char *value, void *ctx)
+{
+    atomic_int *seen = ctx;
+
+    (void)key;
+    atomic_fetch_add(&seen[atoi(value)], 1);
+    return true;
+}
+
+/**
+ * @brief scanMatch_dict visits exactly the keys the pattern matches, once each, with and without
+ * the ordered index pruning by literal prefix, and on several threads
+ */
+static void testScanMatch(void)
+{
+    static char keys[KEY_COUNT][24];
+    static atomic_int seen[KEY_COUNT];
+    static const char *patterns[] = {"user:*",     "user:1*",  "user:?",    "user:[0-4]*:name", "*:name",
+                                     "session/*5", "user:\\*", "nothing*", "*",                "user:1:name"};
+    char value[16];
+
+    for (int backend = DICT_BACKEND_CHAINING; backend <= DICT_BACKEND_BUCKET_VECTOR; backend++)
+    {
+        Dict *dict = createDictWithBackend((DictBackend)backend);
+
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            if (i % 3 == 0)
+                snprintf(keys[i], sizeof(keys[i]), "user:%d", i);
+            else if (i % 3 == 1)
+                snprintf(keys[i], sizeof(keys[i]), "user:%d:name", i);
+            else
+                snprintf(keys[i], sizeof(keys[i]), "session/%d", i);
+            snprintf(value, sizeof(value), "%d", i);
+            CHECK(insert_dict(dict, keys[i], value));
+        }
+        CHECK(insert_dict(dict, "user:*", "0")); // a literal star, counted against key 0's slot
+        strcpy(keys[0], "user:*");
+
+        for (int indexed = 0; indexed <= 1; indexed++)
+        {
+            CHECK(setOrderedIndex_dict(dict, indexed));
+            for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++)
+            {
+                GlobMatcher matcher;
+                size_t expected = 0;
+
+                CHECK(globCompile(&matcher, patterns[p]));
+                for (int threads = 0; threads <= 3; threads += 3)
+                {
+                    size_t visited;
+
+                    for (int i = 0; i < KEY_COUNT; i++)
+                        atomic_store(&seen[i], 0);
+#ifdef DICT_ENABLE_THREADS
+                    visited = threads ? scanMatchParallel_dict(dict, patterns[p], countMatch, seen, threads)
+                                      : scanMatch_dict(dict, patterns[p], countMatch, seen);
+#else
+                    visited = scanMatch_dict(dict, patterns[p], countMatch, seen);
+#endif
+                    expected = 0;
+                    for (int i = 0; i < KEY_COUNT; i++)
+                    {
+                        // key 0 is stored twice: as user:0 and as the literal user:*
+                        int matches = globMatch(&matcher, keys[i]) + (i == 0 && globMatch(&matcher, "user:0"));
+
+                        CHECK(atomic_load(&seen[i]) == matches);
+                        expected += (size_t)matches;
+                    }
+                    CHECK(visited == expected);
+                }
+                globFree(&matcher);
+            }
+        }
+        destroyDict(dict);
+    }
+}
+
+int main(void)
+{
+    testAgainstReference();
+    testScanMatch();
+    return CHECK_DONE();
+}
@@ -0,0 +1,141 @@
+#define DICT_TEST_THREADS /* the large inputs sort on several threads */
+#include "../include/KeySort.h"
+#include "Check.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ITEM_COUNT 100000 /* past the 64K items from which keySort uses its threads */
+
+static unsigned int seed = 12345;
+
+static unsigned int nextRandom(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+/**
+ * @brief strcmp order, ties broken by original position: what a stable sort must produce
+ */
+static int compareStable(const void *a, const void *b)
+{
+    const KeySortItem *x = a;
+    const KeySortItem *y = b;
+    int order = strcmp(x->key, y->key);
+
+    if (order)
+        return order;
+    return (uintptr_t)x->value < (uintptr_t)y->value ? -1 : 1;
+}
+
+/**
+ * @brief Sort keys with keySort and with qsort made stable; the two must agree item for item
+ */
+static void sortLikeQsort(char **keys, size_t count, int threads)
+{
+    KeySortItem *sorted = malloc(count * sizeof(KeySortItem));
+    KeySortItem *expected = malloc(count * sizeof(KeySortItem));
+
+    for (size_t i = 0; i < count; i++)
+        sorted[i] = expected[i] = (KeySortItem){keys[i], (void *)(uintptr_t)i};
+    CHECK(keySort(sorted, count, threads));
+    qsort(expected, count, sizeof(KeySortItem), compareStable);
+    CHECK(memcmp(sorted, expected, count * sizeof(KeySortItem)) == 0);
+    free(sorted);
+    free(expected);
+}
+
+/**
+ * @brief Random bytes, few distinct keys, keys nested in each other, long shared prefixes and a
+ * single repeated key, on one thread and on several
+ */
+static void testMatchesStableQsort(void)
+{
+    char **keys = malloc(ITEM_COUNT * sizeof(char *));
+
+    for (size_t i = 0; i < ITEM_COUNT; i++)
+        keys[i] = malloc(80);
+
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        for (size_t i = 0; i < ITEM_COUNT; i++)
+        {
+            size_t length = nextRandom() % 12;
+
+            for (size_t j = 0; j < length; j++)
+                keys[i][j] = (char)(1 + nextRandom() % 255);
+            keys[i][length] = '\0';
+        }
+        sortLikeQsort(keys, ITEM_COUNT, threads);
+        sortLikeQsort(keys, 20, threads);
+
+        for (size_t i = 0; i < ITEM_COUNT; i++)
+        {
+            size_t length = nextRandom() % 4;
+
+            for (size_t j = 0; j < length; j++)
+                keys[i][j] = (char)('a' + nextRandom() % 2);
+            keys[i][length] = '\0';
+        }
+        sortLikeQsort(keys, ITEM_COUNT, threads);
+
+        for (size_t i = 0; i < ITEM_COUNT; i++)
+        {
+            size_t length = 1 + nextRandom() % 78;
+
+            memset(keys[i], 'a', length);
+            keys[i][length] = '\0';
+        }
+        sortLikeQsort(keys, ITEM_COUNT, threads);
+
+        for (size_t i = 0; i < ITEM_COUNT; i++)
+            snprintf(keys[i], 80, "%060d%u", 0, nextRandom() % 50000);
+        sortLikeQsort(keys, ITEM_COUNT, threads);
+
+        for (size_t i = 0; i < ITEM_COUNT; i++)
+            strcpy(keys[i], "same");
+        sortLikeQsort(keys, ITEM_COUNT, threads);
+    }
+
+    for (size_t i = 0; i < ITEM_COUNT; i++)
+        free(keys[i]);
+    free(keys);
+}
+
+static void *failingAlloc(size_t size, void *ctx)
+{
+    (void)size;
+    (void)ctx;
+    return NULL;
+}
+
+/**
+ * @brief Without scratch space the sort fails and leaves the items as they were; inputs small
+ * enough for insertion sort need none
+ */
+static void testOutOfMemory(void)
+{
+    KeySortItem items[1000];
+    char keys[1000][8];
+
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "%d", 999 - i);
+        items[i] = (KeySortItem){keys[i], NULL};
+    }
+    CHECK(!keySortWithAllocator(items, 1000, 1, failingAlloc, NULL, NULL));
+    for (int i = 0; i < 1000; i++)
+        CHECK(items[i].key == keys[i]);
+
+    CHECK(keySortWithAllocator(items, 3, 1, failingAlloc, NULL, NULL));
+    CHECK(strcmp(items[0].key, "997") == 0 && strcmp(items[2].key, "999") == 0);
+    CHECK(keySort(items, 0, 1));
+}
+
+int main(void)
+{
+    testMatchesStableQsort();
+    testOutOfMemory();
+    return CHECK_DONE();
+}
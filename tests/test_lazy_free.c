@@ -0,0 +1,187 @@
+#define DICT_TEST_THREADS /* the reclaim thread frees what the dictionary hands it */
+#include "../include/Dict.h"
+#include "Check.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_COUNT 5000
+#define BIG_VALUE_BYTES (256 * 1024) /* past the size from which values are freed in the background */
+
+/**
+ * @brief malloc counting what is still allocated, called from the reclaim thread as well
+ */
+static atomic_long live;
+static atomic_long allocations;
+
+static void *countingAlloc(size_t size, void *ctx)
+{
+    void *block = malloc(size);
+
+    (void)ctx;
+    if (block)
+        atomic_fetch_add(&live, 1);
+    atomic_fetch_add(&allocations, 1);
+    return block;
+}
+
+static void *countingRealloc(void *block, size_t size, void *ctx)
+{
+    void *grown;
+
+    if (!block)
+        return countingAlloc(size, ctx);
+    grown = realloc(block, size);
+    return grown;
+}
+
+static void countingFree(void *block, void *ctx)
+{
+    (void)ctx;
+    if (block)
+        atomic_fetch_sub(&live, 1);
+    free(block);
+}
+
+/**
+ * @brief Fill a dictionary with every optional structure that points at its pairs
+ */
+static void fill(Dict *dict, const char *prefix)
+{
+    char key[32];
+
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        snprintf(key, sizeof(key), "%s%d", prefix, i);
+        CHECK(i % 10 ? insert_dict(dict, key, "value") : insertTTL_dict(dict, key, "value", 100000));
+    }
+}
+
+/**
+ * @brief On every backend, a lazy clear empties the dictionary at once and leaves it usable while
+ * the reclaim thread frees the old pairs, the index and the table
+ */
+static void testClearEveryBackend(void)
+{
+    char *big = malloc(BIG_VALUE_BYTES);
+
+    memset(big, 'b', BIG_VALUE_BYTES - 1);
+    big[BIG_VALUE_BYTES - 1] = '\0';
+
+    for (int backend = DICT_BACKEND_CHAINING; backend <= DICT_BACKEND_SMALL; backend++)
+    {
+        Dict *dict = createDictWithAllocator((DictBackend)backend, countingAlloc, countingRealloc, countingFree, NULL);
+        DictCacheConfig cache = {0};
+        char key[32];
+
+        cache.policy = DICT_EVICT_LRU;
+        cache.maxEntries = KEY_COUNT * 2;
+        CHECK(setCacheMode_dict(dict, &cache));
+        CHECK(setOrderedIndex_dict(dict, true));
+        setLazyFree_dict(dict, true);
+        CHECK(dict->lazyFree_dict);
+
+        fill(dict, "k");
+        clear_dict(dict);
+        CHECK(size_dict(dict) == 0 && get_dict(dict, "k1") == NULL);
+
+        // the cleared dictionary takes new keys while the old ones are still being freed
+        fill(dict, "k");
+        CHECK(size_dict(dict) == KEY_COUNT);
+        snprintf(key, sizeof(key), "k%d", KEY_COUNT / 2);
+        CHECK(strcmp(get_dict(dict, key), "value") == 0);
+
+        // large values replaced or removed go to the reclaim thread too
+        CHECK(update_dict(dict, "k7", big));
+        CHECK(update_dict(dict, "k7", "small"));
+        CHECK(strcmp(get_dict(dict, "k7"), "small") == 0);
+        CHECK(insert_dict(dict, "large", big));
+        removeKey_dict(dict, "large");
+        CHECK(!exists_dict(dict, "large"));
+        expireTick_dict(dict, 10);
+
+        // destroying hands the table over as it is: a shell, the index header and a reclaim job, no empty table
+        long before = atomic_load(&allocations);
+
+        destroyDict(dict);
+        CHECK(atomic_load(&allocations) - before <= 3);
+    }
+
+    waitLazyFree_dict();
+    CHECK(atomic_load(&live) == 0);
+    free(big);
+}
+
+static void *clearLoop(void *arg)
+{
+    (void)arg;
+    for (int round = 0; round < 4; round++)
+    {
+        Dict *dict = createDictWithAllocator(DICT_BACKEND_ROBIN_HOOD, countingAlloc, countingRealloc, countingFree, NULL);
+
+        setLazyFree_dict(dict, true);
+        fill(dict, "t");
+        clear_dict(dict);
+        fill(dict, "u");
+        destroyDict(dict);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Dictionaries cleared and destroyed on several threads at once share the one reclaim thread
+ */
+static void testConcurrentClears(void)
+{
+    pthread_t threads[4];
+
+    for (int t = 0; t < 4; t++)
+        CHECK(pthread_create(&threads[t], NULL, clearLoop, NULL) == 0);
+    for (int t = 0; t < 4; t++)
+        pthread_join(threads[t], NULL);
+    waitLazyFree_dict();
+    CHECK(atomic_load(&live) == 0);
+}
+
+static void *arenaAlloc(size_t size, void *ctx)
+{
+    size_t *used = ctx;
+    static _Alignas(16) char arena[1 << 16];
+
+    size = (size + 15) & ~(size_t)15;
+    if (*used + size > sizeof(arena))
+        return NULL;
+    *used += size;
+    return arena + *used - size;
+}
+
+static void *arenaRealloc(void *block, size_t size, void *ctx)
+{
+    (void)block; // never called with a block by a small dictionary holding a few keys
+    return arenaAlloc(size, ctx);
+}
+
+/**
+ * @brief In arena mode nothing is freed one by one, so there is nothing to hand the reclaim thread
+ */
+static void testArenaStaysInline(void)
+{
+    size_t used = 0;
+    Dict *dict = createDictWithAllocator(DICT_BACKEND_SMALL, arenaAlloc, arenaRealloc, NULL, &used);
+
+    setLazyFree_dict(dict, true);
+    CHECK(!dict->lazyFree_dict);
+    CHECK(insert_dict(dict, "a", "1"));
+    clear_dict(dict);
+    CHECK(size_dict(dict) == 0);
+    destroyDict(dict);
+}
+
+int main(void)
+{
+    testClearEveryBackend();
+    testConcurrentClears();
+    testArenaStaysInline();
+    return CHECK_DONE();
+}
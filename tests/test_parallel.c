@@ -0,0 +1,135 @@
+#define DICT_TEST_THREADS /* the visitors run on several threads */
+#include "../include/Dict.h"
+#include "Check.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define KEY_COUNT 50000
+
+/**
+ * @struct Totals
+ * @brief Accumulator of testReduce: a sum and a small histogram, merged field by field.
+ */
+typedef struct Totals
+{
+    unsigned long long sum;
+    size_t byLength[8];
+} Totals;
+
+static void fold(void *acc, const char *key, const char *value, void *ctx)
+{
+    Totals *totals = acc;
+
+    (void)ctx;
+    totals->sum += strtoull(value, NULL, 10);
+    totals->byLength[strlen(key) & 7]++;
+}
+
+static void combine(void *into, const void *from, void *ctx)
+{
+    Totals *totals = into;
+    const Totals *other = from;
+
+    (void)ctx;
+    totals->sum += other->sum;
+    for (int i = 0; i < 8; i++)
+        totals->byLength[i] += other->byLength[i];
+}
+
+static bool countVisit(const char *key, const char *value, void *ctx)
+{
+    (void)key;
+    (void)value;
+    atomic_fetch_add((atomic_size_t *)ctx, 1);
+    return true;
+}
+
+static bool stopAfterHundred(const char *key, const char *value, void *ctx)
+{
+    (void)key;
+    (void)value;
+    return atomic_fetch_add((atomic_size_t *)ctx, 1) < 100;
+}
+
+/**
+ * @brief Fill a dictionary with keys k0..k(count-1) valued by their number, plus one expired key
+ *
+ * @return unsigned long long Sum of the live values
+ */
+static unsigned long long fill(Dict *dict, int count)
+{
+    struct timespec pause = {0, 5000000};
+    char key[32];
+    char value[32];
+    unsigned long long sum = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        snprintf(value, sizeof(value), "%d", i);
+        CHECK(insert_dict(dict, key, value));
+        sum += (unsigned long long)i;
+    }
+    CHECK(insertTTL_dict(dict, "expired", "1000000", 1));
+    nanosleep(&pause, NULL);
+    return sum;
+}
+
+/**
+ * @brief On every backend and team size, foreach visits each live pair once, reduce folds each
+ * live pair once, and a visitor returning false stops the threads within a run each
+ */
+static void testEveryBackend(void)
+{
+    for (int backend = DICT_BACKEND_CHAINING; backend <= DICT_BACKEND_SMALL; backend++)
+    {
+        Dict *dict = createDictWithBackend((DictBackend)backend);
+        int count = backend == DICT_BACKEND_SMALL ? 12 : KEY_COUNT; // a small table that stays small
+        unsigned long long sum = fill(dict, count);
+
+        for (int threads = 0; threads <= 8; threads += threads < 2 ? 1 : 3)
+        {
+            Totals totals = {0};
+            size_t histogram = 0;
+            atomic_size_t visits = 0;
+            atomic_size_t stopped = 0;
+
+            CHECK(parallelReduce_dict(dict, threads, &totals, sizeof(totals), fold, combine, NULL) == (size_t)count);
+            CHECK(totals.sum == sum);
+            for (int i = 0; i < 8; i++)
+                histogram += totals.byLength[i];
+            CHECK(histogram == (size_t)count);
+
+            CHECK(parallelForEach_dict(dict, threads, countVisit, &visits) == (size_t)count);
+            CHECK(atomic_load(&visits) == (size_t)count);
+
+            parallelForEach_dict(dict, threads, stopAfterHundred, &stopped);
+            CHECK(atomic_load(&stopped) < (size_t)count || count <= 101);
+        }
+        destroyDict(dict);
+    }
+}
+
+/**
+ * @brief An empty dictionary visits nothing and leaves the accumulator at its identity
+ */
+static void testEmpty(void)
+{
+    Dict *dict = createDictWithBackend(DICT_BACKEND_ROBIN_HOOD);
+    Totals totals = {0};
+    atomic_size_t visits = 0;
+
+    CHECK(parallelReduce_dict(dict, 4, &totals, sizeof(totals), fold, combine, NULL) == 0);
+    CHECK(totals.sum == 0);
+    CHECK(parallelForEach_dict(dict, 4, countVisit, &visits) == 0);
+    destroyDict(dict);
+}
+
+int main(void)
+{
+    testEveryBackend();
+    testEmpty();
+    return CHECK_DONE();
+}
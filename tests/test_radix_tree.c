@@ -0,0 +1,166 @@
+#include "../include/RadixTree.h"
+#include "Check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_COUNT 4000
+
+/**
+ * @struct Budget
+ * @brief malloc that fails once every period calls, counting what is still allocated.
+ */
+typedef struct Budget
+{
+    unsigned long calls;
+    unsigned long period; /**< Every period-th call fails, 0 for none */
+    long live; /**< Blocks allocated and not freed yet */
+} Budget;
+
+static void *budgetAlloc(size_t size, void *ctx)
+{
+    Budget *budget = ctx;
+    void *block;
+
+    if (budget->period && ++budget->calls % budget->period == 0)
+        return NULL;
+    if ((block = malloc(size)))
+        budget->live++;
+    return block;
+}
+
+static void budgetFree(void *block, void *ctx)
+{
+    Budget *budget = ctx;
+
+    budget->live--;
+    free(block);
+}
+
+typedef struct OrderCheck
+{
+    const char *previous;
+    size_t count;
+    bool ordered;
+} OrderCheck;
+
+static bool checkOrder(const char *key, void *value, void *ctx)
+{
+    OrderCheck *check = ctx;
+
+    if (check->previous && strcmp(check->previous, key) >= 0)
+        check->ordered = false;
+    if (strcmp(key, value) != 0)
+        check->ordered = false;
+    check->previous = key;
+    check->count++;
+    return true;
+}
+
+/**
+ * @brief Keys sharing long prefixes and fanning out at many bytes, so that every node type is
+ * grown into, shrunk out of and collapsed
+ */
+static void makeKey(char *key, size_t size, unsigned int i)
+{
+    switch (i % 4)
+    {
+    case 0:
+        snprintf(key, size, "user:%u", i);
+        break;
+    case 1:
+        snprintf(key, size, "user:%u:profile:with:a:long:shared:path", i);
+        break;
+    case 2:
+        snprintf(key, size, "%c%c", (char)('!' + i % 90), (char)('!' + i / 90 % 90));
+        break;
+    default:
+        snprintf(key, size, "session/%08x", i * 2654435761u);
+        break;
+    }
+}
+
+/**
+ * @brief Random inserts and removes against a presence table, with an allocator that fails now
+ * and then: every failed insert leaves the tree as it was, and lookups and ordered iteration
+ * always agree with the table
+ */
+static void testAgainstReference(unsigned long period)
+{
+    Budget budget = {0, period, 0};
+    RadixTree tree;
+    static char keys[KEY_COUNT][64];
+    bool present[KEY_COUNT] = {false};
+    size_t size = 0;
+    unsigned int seed = 12345;
+
+    for (unsigned int i = 0; i < KEY_COUNT; i++)
+        makeKey(keys[i], sizeof(keys[i]), i);
+    radixTreeInitWithAllocator(&tree, budgetAlloc, budgetFree, &budget);
+
+    for (int step = 0; step < 60000; step++)
+    {
+        unsigned int i;
+
+        seed = seed * 1103515245u + 12345u;
+        i = (seed >> 8) % KEY_COUNT;
+
+        if ((seed >> 4) % 3)
+        {
+            void *result = radixTreeInsert(&tree, keys[i], keys[i]);
+
+            CHECK(result == (present[i] ? keys[i] : NULL) || (!present[i] && result == RADIX_TREE_NO_MEMORY));
+            if (!present[i] && result == NULL)
+            {
+                present[i] = true;
+                size++;
+            }
+        }
+        else
+        {
+            CHECK(radixTreeRemove(&tree, keys[i]) == (present[i] ? keys[i] : NULL));
+            if (present[i])
+            {
+                present[i] = false;
+                size--;
+            }
+        }
+        CHECK(tree.size == size);
+    }
+
+    OrderCheck check = {NULL, 0, true};
+
+    radixTreeRange(&tree, NULL, NULL, checkOrder, &check);
+    CHECK(check.ordered && check.count == size);
+    for (unsigned int i = 0; i < KEY_COUNT; i++)
+        CHECK((radixTreeSearch(&tree, keys[i]) != NULL) == present[i]);
+
+    radixTreeFree(&tree);
+    CHECK(budget.live == 0);
+}
+
+/**
+ * @brief radixTreeReplace repoints a leaf without allocating and ignores absent keys
+ */
+static void testReplace(void)
+{
+    RadixTree tree;
+    char first[] = "shared";
+    char second[] = "shared";
+
+    radixTreeInit(&tree);
+    CHECK(radixTreeInsert(&tree, first, first) == NULL);
+    CHECK(radixTreeReplace(&tree, second, second) == first);
+    CHECK(radixTreeSearch(&tree, "shared") == second);
+    CHECK(radixTreeReplace(&tree, "absent", second) == NULL);
+    CHECK(tree.size == 1);
+    radixTreeFree(&tree);
+}
+
+int main(void)
+{
+    testAgainstReference(0);
+    testAgainstReference(3);
+    testAgainstReference(17);
+    testReplace();
+    return CHECK_DONE();
+}
@@ -0,0 +1,118 @@
+#include "../include/Dict.h"
+#include "Check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define KEY_COUNT 2000
+#define EXTRA_COUNT 12000
+
+static bool countBase(const char *key, const char *value, void *ctx)
+{
+    int *seen = ctx;
+
+    (void)value;
+    if (key[0] == 'k')
+        seen[atoi(key + 1)]++;
+    return true;
+}
+
+static bool stopAtOnce(const char *key, const char *value, void *ctx)
+{
+    (void)key;
+    (void)value;
+    ++*(int *)ctx;
+    return false;
+}
+
+/**
+ * @brief Between every two steps of a scan, grow the table many times over with extra keys, then
+ * remove them again so that it shrinks, or rebuild it with compact_dict: every key present for the
+ * whole scan is still visited
+ */
+static void testResizeBetweenSteps(DictBackend backend, int baseCount)
+{
+    Dict *dict = createDictWithBackend(backend);
+    static int seen[KEY_COUNT];
+    size_t cursor = 0;
+    int extras = 0;
+    int steps = 0;
+    char key[32];
+
+    memset(seen, 0, sizeof(seen));
+    for (int i = 0; i < baseCount; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        CHECK(insert_dict(dict, key, "base"));
+    }
+
+    do
+    {
+        cursor = scan_dict(dict, cursor, 10, countBase, seen);
+        steps++;
+
+        if (steps % 40 == 0)
+            CHECK(compact_dict(dict));
+        else if (extras < EXTRA_COUNT && steps % 80 < 40)
+        {
+            for (int i = 0; i < 1500 && extras < EXTRA_COUNT; i++, extras++)
+            {
+                snprintf(key, sizeof(key), "n%d", extras);
+                CHECK(insert_dict(dict, key, "extra"));
+            }
+        }
+        else
+        {
+            for (int i = 0; i < 1500 && extras > 0; i++)
+            {
+                snprintf(key, sizeof(key), "n%d", --extras);
+                removeKey_dict(dict, key);
+            }
+        }
+    } while (cursor);
+
+    for (int i = 0; i < baseCount; i++)
+        CHECK(seen[i] >= 1);
+    destroyDict(dict);
+}
+
+/**
+ * @brief A visitor returning false ends the scan, and expired keys are never visited
+ */
+static void testStopAndExpiry(DictBackend backend)
+{
+    Dict *dict = createDictWithBackend(backend);
+    struct timespec pause = {0, 5000000};
+    int visits = 0;
+    int seen[1] = {0};
+    size_t cursor = 0;
+
+    CHECK(insert_dict(dict, "a", "1") && insert_dict(dict, "b", "2"));
+    do // a step may cover only empty slots of a sparse table
+        cursor = scan_dict(dict, cursor, 1, stopAtOnce, &visits);
+    while (cursor && !visits);
+    CHECK(cursor == 0 && visits == 1);
+
+    CHECK(insertTTL_dict(dict, "k0", "gone", 1));
+    nanosleep(&pause, NULL);
+    do
+        cursor = scan_dict(dict, cursor, 10, countBase, seen);
+    while (cursor);
+    CHECK(seen[0] == 0);
+    destroyDict(dict);
+}
+
+int main(void)
+{
+    for (int backend = DICT_BACKEND_CHAINING; backend <= DICT_BACKEND_SMALL; backend++)
+    {
+        // a cuckoo scan is only complete while nobody modifies the table, see scan_dict
+        if (backend != DICT_BACKEND_CUCKOO)
+        {
+            testResizeBetweenSteps((DictBackend)backend, KEY_COUNT);
+            testResizeBetweenSteps((DictBackend)backend, 10);
+        }
+        testStopAndExpiry((DictBackend)backend);
+    }
+    return CHECK_DONE();
+}
@@ -0,0 +1,172 @@
+#include "../include/Dict.h"
+#include "../include/TimerWheel.h"
+#include "Check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TIMER_COUNT 2000
+
+static unsigned long long seed = 12345;
+
+static uint64_t nextRandom(void)
+{
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return seed >> 16;
+}
+
+/**
+ * @brief Expiry distance of timer i: around every level boundary, within each level and past the
+ * top level's span, where timers are parked and re-placed
+ */
+static uint64_t distance(int i)
+{
+    static const uint64_t boundaries[] = {0, 1, 255, 256, 257, 65535, 65536, 65537, 1ull << 24, (1ull << 24) + 1,
+                                          (1ull << 32) - 1, 1ull << 32, (1ull << 32) + 300, 3ull << 32};
+    int count = (int)(sizeof(boundaries) / sizeof(boundaries[0]));
+
+    if (i < count)
+        return boundaries[i];
+    return nextRandom() % (1ull << (8 * (1 + i % 4) + (i % 7 == 0 ? 2 : 0)));
+}
+
+/**
+ * @brief Advance a wheel started at an unaligned time in irregular steps, with small budgets now
+ * and then: after each step that ran to completion exactly the timers due by then have fired, each
+ * once, and a cancelled or rescheduled timer fires only at its last expiry
+ */
+static void testWheelCascades(void)
+{
+    static TimerWheel wheel;
+    static WheelTimer timers[TIMER_COUNT];
+    static bool fired[TIMER_COUNT];
+    static bool cancelled[TIMER_COUNT];
+    uint64_t start = 1000003;
+    uint64_t now = start;
+    uint64_t last = start;
+    size_t pending = TIMER_COUNT;
+
+    timerWheelInit(&wheel, start);
+    for (int i = 0; i < TIMER_COUNT; i++)
+    {
+        timers[i].data = &timers[i];
+        timerWheelSchedule(&wheel, &timers[i], start + distance(i));
+        last = timers[i].expireAt > last ? timers[i].expireAt : last;
+    }
+
+    while (pending)
+    {
+        WheelTimer *timer;
+        size_t budget = nextRandom() % 4 ? SIZE_MAX : 1 + nextRandom() % 3;
+
+        // steps of every scale, landing on level boundaries now and then
+        if (nextRandom() % 4 == 0)
+            now = (now | ((1ull << (8 * (1 + nextRandom() % 3))) - 1)) + 1;
+        else
+            now += nextRandom() % (1ull << (nextRandom() % 34));
+        if (now > last)
+            now = last;
+
+        timerWheelAdvance(&wheel, now, budget);
+        while ((timer = timerWheelPopDue(&wheel)))
+        {
+            int i = (int)(timer - timers);
+
+            CHECK(!fired[i] && !cancelled[i]);
+            CHECK(timer->expireAt <= now);
+            fired[i] = true;
+            pending--;
+        }
+
+        if (budget == SIZE_MAX)
+        {
+            for (int i = 0; i < TIMER_COUNT; i++)
+                CHECK(fired[i] || cancelled[i] || timers[i].expireAt > now);
+        }
+
+        // cancel one pending timer and push another further out
+        for (int tries = 0; tries < 2; tries++)
+        {
+            int i = (int)(nextRandom() % TIMER_COUNT);
+
+            if (fired[i] || cancelled[i])
+                continue;
+            timerWheelCancel(&wheel, &timers[i]);
+            if (tries == 0)
+            {
+                cancelled[i] = true;
+                pending--;
+            }
+            else
+            {
+                timerWheelSchedule(&wheel, &timers[i], now + 1 + nextRandom() % 100000);
+                last = timers[i].expireAt > last ? timers[i].expireAt : last;
+            }
+        }
+    }
+    for (int i = 0; i < TIMER_COUNT; i++)
+        CHECK(fired[i] != cancelled[i]);
+}
+
+/**
+ * @brief Expired keys vanish from lookups at once, expireTick_dict reclaims the rest within its
+ * budget, and expire_dict and persist_dict change a key's fate
+ */
+static void testDictExpiry(void)
+{
+    Dict *dict = createDict();
+    struct timespec pause = {0, 20000000};
+    struct timespec longPause = {0, 150000000}; // past the 100 ms TTLs that persist_dict and expire_dict replace
+    char key[32];
+
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "short%d", i);
+        CHECK(insertTTL_dict(dict, key, "value", 5));
+    }
+    CHECK(insertTTL_dict(dict, "persisted", "value", 100));
+    CHECK(insertTTL_dict(dict, "extended", "value", 100));
+    CHECK(insertTTL_dict(dict, "long", "value", 60000));
+    CHECK(insert_dict(dict, "plain", "value"));
+
+    CHECK(ttl_dict(dict, "plain") == -1);
+    CHECK(ttl_dict(dict, "absent") == -2);
+    CHECK(ttl_dict(dict, "long") > 50000);
+    CHECK(persist_dict(dict, "persisted"));
+    CHECK(!persist_dict(dict, "plain"));
+    CHECK(expire_dict(dict, "extended", 60000));
+    CHECK(!expire_dict(dict, "absent", 10));
+    nanosleep(&longPause, NULL);
+
+    // lookups hide and reclaim expired keys before any tick
+    CHECK(get_dict(dict, "short0") == NULL && !exists_dict(dict, "short1"));
+    CHECK(size_dict(dict) == 102);
+    CHECK(expireTick_dict(dict, 30) == 30);
+    CHECK(size_dict(dict) == 72);
+    CHECK(expireTick_dict(dict, 1000) == 68);
+    CHECK(expireTick_dict(dict, 1000) == 0);
+    CHECK(size_dict(dict) == 4);
+    CHECK(exists_dict(dict, "persisted") && ttl_dict(dict, "persisted") == -1);
+    CHECK(exists_dict(dict, "extended") && exists_dict(dict, "long") && exists_dict(dict, "plain"));
+
+    // an update of an expired key is an insert without a TTL
+    CHECK(insertTTL_dict(dict, "renewed", "old", 1));
+    nanosleep(&pause, NULL);
+    CHECK(update_dict(dict, "renewed", "new"));
+    CHECK(strcmp(get_dict(dict, "renewed"), "new") == 0 && ttl_dict(dict, "renewed") == -1);
+    CHECK(expireTick_dict(dict, 10) == 0);
+
+    removeKey_dict(dict, "long");
+    clear_dict(dict);
+    CHECK(insertTTL_dict(dict, "after clear", "value", 1));
+    nanosleep(&pause, NULL);
+    CHECK(expireTick_dict(dict, 10) == 1 && size_dict(dict) == 0);
+    destroyDict(dict);
+}
+
+int main(void)
+{
+    testWheelCascades();
+    testDictExpiry();
+    return CHECK_DONE();
+}